@@ -72,6 +72,8 @@
 #include <cstdio>
 #include <ctime>
 #include <cmath>
+#include <cstring>
+#include <stdint.h>
 
 class MTRand {
 // Data
@@ -79,15 +81,30 @@ public:
     typedef unsigned long uint32;  // unsigned integer type, at least 32 bits
     
     enum { N = 624 };       // length of state vector
-    enum { SAVE = N + 1 };  // length of array for save()
+    enum { NORM = 128 };    // length of the buffer of normal deviates
+    enum { SAVE = N + 2 + 2*NORM };  // length of array for save()
+    enum { CBSAVE = 8 + 2*NORM };    // length of save() for a counter-based stream
 
 protected:
     enum { M = 397 };  // period parameter
     
     uint32 state[N];   // internal state
-    uint32 *pNext;     // next value to get from state
+    uint32 block[N];   // tempered block of outputs generated from state
+    uint32 *pNext;     // next value to get from block
     int left;          // number of values left before reload needed
 
+    double normBuffer[NORM];  // block of normal deviates
+    int normLeft;             // number of normal deviates left in normBuffer
+
+    // Counter-based (Philox4x32-10) stream, used instead of the twister when
+    // counterBased is set.  The 128-bit counter holds the 64-bit block number
+    // in its low words and the (path,thread) stream labels in its high words,
+    // while the key holds the (seed,process) pair.
+    bool counterBased;        // do we generate blocks from the counter?
+    uint32_t key[2];          // the Philox key (seed,process)
+    uint32_t stream[2];       // the high counter words (path,thread)
+    uint64_t nextCounter;     // the counter of the next block to generate
+
 // Methods
 public:
     MTRand( const uint32 oneSeed );  // initialize with a simple uint32
@@ -120,9 +137,19 @@ public:
     void seed( const uint32 oneSeed );
     void seed( uint32 *const bigSeed, const uint32 seedLength = N );
     void seed();
+
+    // Switch to an independent counter-based stream keyed by seed, process,
+    // path and thread number, and jump ahead in the current stream
+    void seedStream( const uint32 oneSeed, const uint32 process,
+                     const uint32 path = 0, const uint32 thread = 0 );
+    void skip( const uint64_t n );         // discard n 32-bit integers in O(1)
+    // Start an independent stream for another path of the same simulation
+    void seedPath( const uint32 oneSeed, const uint32 path );
+    bool isCounterBased() const { return counterBased; }
     
     // Saving and loading generator state
-    void save( uint32* saveArray ) const;  // to array of size SAVE
+    int saveSize() const { return counterBased ? int(CBSAVE) : int(SAVE); }
+    void save( uint32* saveArray ) const;  // to array of size saveSize()
     void load( uint32 *const loadArray );  // from such array
     friend std::ostream& operator<<( std::ostream& os, const MTRand& mtrand );
     friend std::istream& operator>>( std::istream& is, MTRand& mtrand );
@@ -131,6 +158,14 @@ public:
 protected:
     void initialize( const uint32 oneSeed );
     void reload();
+    void temper();
+    void reloadNorm();
+    void reloadCounter();
+    static void philox( const uint64_t ctr, const uint32_t *str,
+                        const uint32_t *k, uint32 *out );
+    void saveNorm( uint32* saveArray ) const;
+    void loadNorm( uint32 *const loadArray );
+    void copy( const MTRand& o );
     uint32 hiBit( const uint32 u ) const { return u & 0x80000000UL; }
     uint32 loBit( const uint32 u ) const { return u & 0x00000001UL; }
     uint32 loBits( const uint32 u ) const { return u & 0x7fffffffUL; }
@@ -189,6 +224,8 @@ inline void MTRand::initialize( const uint32 _seed )
 
 inline void MTRand::reload()
 {
+    if( counterBased ) { reloadCounter();  return; }
+
     // Generate N new values in state
     // Made clearer and faster by Matthew Bellew (matthew.bellew@home.com)
     static const int MmN = int(M) - int(N);  // in case enums are unsigned
@@ -200,14 +237,89 @@ inline void MTRand::reload()
         *p = twist( p[MmN], p[0], p[1] );
     *p = twist( p[MmN], p[0], state[0] );
     
-    left = N, pNext = state;
+    temper();
+}
+
+inline void MTRand::temper()
+{
+    // Temper the whole state vector in a single pass, so that randInt() only
+    // has to read from the block.  The loop has no dependencies between
+    // iterations and is easily vectorized by the compiler.
+    for( int i = 0; i < N; ++i )
+    {
+        uint32 s1 = state[i];
+        s1 ^= (s1 >> 11);
+        s1 ^= (s1 <<  7) & 0x9d2c5680UL;
+        s1 ^= (s1 << 15) & 0xefc60000UL;
+        block[i] = s1 ^ (s1 >> 18);
+    }
+    
+    left = N, pNext = block;
+}
+
+inline void MTRand::philox( const uint64_t ctr, const uint32_t *str,
+                            const uint32_t *k, uint32 *out )
+{
+    // Philox4x32-10 of Salmon, Moraes, Dror and Shaw, "Parallel random
+    // numbers: as easy as 1, 2, 3", SC11 (2011).  Each call is a pure function
+    // of (counter,key), which gives O(1) skip-ahead and independent streams.
+    uint32_t c0 = uint32_t( ctr & 0xffffffffUL );
+    uint32_t c1 = uint32_t( ctr >> 32 );
+    uint32_t c2 = str[0];
+    uint32_t c3 = str[1];
+    uint32_t k0 = k[0];
+    uint32_t k1 = k[1];
+    for( int r = 0; r < 10; ++r )
+    {
+        uint64_t p0 = uint64_t(0xD2511F53UL) * c0;
+        uint64_t p1 = uint64_t(0xCD9E8D57UL) * c2;
+        uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c1 = uint32_t(p1);
+        c3 = uint32_t(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9UL;
+        k1 += 0xBB67AE85UL;
+    }
+    out[0] = c0;  out[1] = c1;  out[2] = c2;  out[3] = c3;
+}
+
+inline void MTRand::reloadCounter()
+{
+    // Fill the block with the next N/4 Philox outputs
+    for( int i = 0; i < N/4; ++i )
+        philox( nextCounter + i, stream, key, &block[4*i] );
+    nextCounter += N/4;
+    left = N, pNext = block;
+}
+
+inline void MTRand::reloadNorm()
+{
+    // Fill the buffer of normal deviates using the basic form of the
+    // Box-Muller transformation, keeping both deviates of each pair.  All
+    // uniforms are drawn first so that the transformation loop is free of
+    // branches.
+    double u[NORM];
+    for( int i = 0; i < NORM; ++i )
+        u[i] = randDblExc();
+    for( int i = 0; i < NORM; i += 2 )
+    {
+        double r = sqrt( -2.0 * log(u[i]) );
+        double theta = 2.0 * M_PI * u[i+1];
+        normBuffer[i]   = r * cos(theta);
+        normBuffer[i+1] = r * sin(theta);
+    }
+    normLeft = NORM;
 }
 
 inline void MTRand::seed( const uint32 oneSeed )
 {
     // Seed the generator with a simple uint32
+    counterBased = false;
     initialize(oneSeed);
     reload();
+    normLeft = 0;
 }
 
 inline void MTRand::seed( uint32 *const bigSeed, const uint32 seedLength )
@@ -218,6 +330,7 @@ inline void MTRand::seed( uint32 *const bigSeed, const uint32 seedLength )
     // default seed length of N = 624 uint32's).  Any bits above the lower 32
     // in each element are discarded.
     // Just call seed() if you want to get array from /dev/urandom
+    counterBased = false;
     initialize(19650218UL);
     int i = 1;
     uint32 j = 0;
@@ -243,6 +356,7 @@ inline void MTRand::seed( uint32 *const bigSeed, const uint32 seedLength )
     }
     state[0] = 0x80000000UL;  // MSB is 1, assuring non-zero initial array
     reload();
+    normLeft = 0;
 }
 
 inline void MTRand::seed()
@@ -268,6 +382,54 @@ inline void MTRand::seed()
     seed( hash( time(NULL), clock() ) );
 }
 
+inline void MTRand::seedStream( const uint32 oneSeed, const uint32 process,
+                                const uint32 path, const uint32 thread )
+{
+    // Start at the beginning of the counter-based stream labelled by
+    // (seed,process,path,thread)
+    counterBased = true;
+    key[0] = uint32_t( oneSeed & 0xffffffffUL );
+    key[1] = uint32_t( process & 0xffffffffUL );
+    stream[0] = uint32_t( path & 0xffffffffUL );
+    stream[1] = uint32_t( thread & 0xffffffffUL );
+    nextCounter = 0;
+    reloadCounter();
+    normLeft = 0;
+}
+
+inline void MTRand::seedPath( const uint32 oneSeed, const uint32 path )
+{
+    // A counter-based stream keeps its (seed,process) key and thread label
+    // and moves to the path label, while the twister is seeded with the
+    // (seed,path) pair
+    if( counterBased )
+    {
+        seedStream( key[0], key[1], path, stream[1] );
+        return;
+    }
+    uint32 bigSeed[2] = { oneSeed, path };
+    seed( bigSeed, 2 );
+}
+
+inline void MTRand::skip( const uint64_t n )
+{
+    // Discard the next n 32-bit integers.  For a counter-based stream we
+    // simply compute the new position, otherwise we have to draw them.
+    // Any buffered normal deviates are discarded.
+    normLeft = 0;
+    if( !counterBased )
+    {
+        for( uint64_t i = 0; i < n; ++i )
+            randInt();
+        return;
+    }
+    uint64_t position = (nextCounter - N/4) * 4 + (N - left) + n;
+    nextCounter = (position / N) * (N/4);
+    reloadCounter();
+    left = N - int(position % N);
+    pNext = &block[N-left];
+}
+
 inline MTRand::MTRand( const uint32 oneSeed )
     { seed(oneSeed); }
 
@@ -277,16 +439,23 @@ inline MTRand::MTRand( uint32 *const bigSeed, const uint32 seedLength )
 inline MTRand::MTRand()
     { seed(); }
 
-inline MTRand::MTRand( const MTRand& o )
+inline void MTRand::copy( const MTRand& o )
 {
-    const uint32 *t = o.state;
-    uint32 *s = state;
-    int i = N;
-    for( ; i--; *s++ = *t++ ) {}
+    memcpy( state, o.state, sizeof(state) );
+    memcpy( block, o.block, sizeof(block) );
     left = o.left;
-    pNext = &state[N-left];
+    pNext = &block[N-left];
+    memcpy( normBuffer, o.normBuffer, sizeof(normBuffer) );
+    normLeft = o.normLeft;
+    counterBased = o.counterBased;
+    memcpy( key, o.key, sizeof(key) );
+    memcpy( stream, o.stream, sizeof(stream) );
+    nextCounter = o.nextCounter;
 }
 
+inline MTRand::MTRand( const MTRand& o )
+    { copy(o); }
+
 inline MTRand::uint32 MTRand::randInt()
 {
     // Pull a 32-bit integer from the generator state
@@ -295,12 +464,7 @@ inline MTRand::uint32 MTRand::randInt()
     if( left == 0 ) reload();
     --left;
     
-    uint32 s1;
-    s1 = *pNext++;
-    s1 ^= (s1 >> 11);
-    s1 ^= (s1 <<  7) & 0x9d2c5680UL;
-    s1 ^= (s1 << 15) & 0xefc60000UL;
-    return ( s1 ^ (s1 >> 18) );
+    return *pNext++;
 }
 
 inline MTRand::uint32 MTRand::randInt( const uint32 n )
@@ -349,17 +513,10 @@ inline double MTRand::rand53()
 inline double MTRand::randNorm( const double mean, const double stddev )
 {
     // Return a real number from a normal (Gaussian) distribution with given
-    // mean and standard deviation by polar form of Box-Muller transformation
-    double x, y, r;
-    do
-    {
-        x = 2.0 * rand() - 1.0;
-        y = 2.0 * rand() - 1.0;
-        r = x * x + y * y;
-    }
-    while ( r >= 1.0 || r == 0.0 );
-    double s = sqrt( -2.0 * log(r) / r );
-    return mean + x * s * stddev;
+    // mean and standard deviation, consumed from a buffer which is refilled
+    // a block at a time
+    if( normLeft == 0 ) reloadNorm();
+    return mean + normBuffer[NORM - normLeft--] * stddev;
 }
 
 inline double MTRand::operator()()
@@ -367,52 +524,116 @@ inline double MTRand::operator()()
     return rand();
 }
 
+inline void MTRand::saveNorm( uint32* saveArray ) const
+{
+    // The number of buffered normal deviates followed by their exact bit
+    // patterns (as pairs of 32-bit words)
+    uint32 *sa = saveArray;
+    *sa++ = normLeft;
+    for( int i = 0; i < NORM; ++i )
+    {
+        uint64_t bits;
+        memcpy( &bits, &normBuffer[i], sizeof(bits) );
+        *sa++ = uint32( bits & 0xffffffffUL );
+        *sa++ = uint32( bits >> 32 );
+    }
+}
+
+inline void MTRand::loadNorm( uint32 *const loadArray )
+{
+    uint32 *la = loadArray;
+    normLeft = *la++;
+    for( int i = 0; i < NORM; ++i )
+    {
+        uint64_t bits = uint64_t( *la++ & 0xffffffffUL );
+        bits |= uint64_t( *la++ & 0xffffffffUL ) << 32;
+        memcpy( &normBuffer[i], &bits, sizeof(bits) );
+    }
+}
+
 inline void MTRand::save( uint32* saveArray ) const
 {
-    const uint32 *s = state;
+    // A counter-based stream is fully described by its key, stream labels,
+    // block counter and position.  Otherwise we store the state vector and
+    // position.  Both are followed by the normal deviate buffer.
     uint32 *sa = saveArray;
-    int i = N;
-    for( ; i--; *sa++ = *s++ ) {}
-    *sa = left;
+    if( counterBased )
+    {
+        *sa++ = key[0];
+        *sa++ = key[1];
+        *sa++ = stream[0];
+        *sa++ = stream[1];
+        *sa++ = uint32( nextCounter & 0xffffffffUL );
+        *sa++ = uint32( nextCounter >> 32 );
+        *sa++ = left;
+    }
+    else
+    {
+        const uint32 *s = state;
+        int i = N;
+        for( ; i--; *sa++ = *s++ ) {}
+        *sa++ = left;
+    }
+    saveNorm( sa );
 }
 
 inline void MTRand::load( uint32 *const loadArray )
 {
-    uint32 *s = state;
+    // The layout is determined by the current type of stream.  The block is
+    // a function of the state (or counter) alone, so it is regenerated rather
+    // than stored.  A zero normLeft (as found in state files from before the
+    // normal buffer existed) simply empties the buffer.
     uint32 *la = loadArray;
-    int i = N;
-    for( ; i--; *s++ = *la++ ) {}
-    left = *la;
-    pNext = &state[N-left];
+    if( counterBased )
+    {
+        key[0] = uint32_t( *la++ & 0xffffffffUL );
+        key[1] = uint32_t( *la++ & 0xffffffffUL );
+        stream[0] = uint32_t( *la++ & 0xffffffffUL );
+        stream[1] = uint32_t( *la++ & 0xffffffffUL );
+        nextCounter = uint64_t( *la++ & 0xffffffffUL );
+        nextCounter |= uint64_t( *la++ & 0xffffffffUL ) << 32;
+        int savedLeft = *la++;
+        nextCounter -= N/4;
+        reloadCounter();
+        left = savedLeft;
+    }
+    else
+    {
+        uint32 *s = state;
+        int i = N;
+        for( ; i--; *s++ = *la++ ) {}
+        int savedLeft = *la++;
+        temper();
+        left = savedLeft;
+    }
+    pNext = &block[N-left];
+    loadNorm( la );
 }
 
 inline std::ostream& operator<<( std::ostream& os, const MTRand& mtrand )
 {
-    const MTRand::uint32 *s = mtrand.state;
-    int i = mtrand.N;
-    for( ; i--; os << *s++ << "\t" ) {}
-    return os << mtrand.left;
+    MTRand::uint32 saveArray[MTRand::SAVE];
+    mtrand.save( saveArray );
+    int size = mtrand.saveSize();
+    for( int i = 0; i < size - 1; ++i )
+        os << saveArray[i] << "\t";
+    return os << saveArray[size - 1];
 }
 
 inline std::istream& operator>>( std::istream& is, MTRand& mtrand )
 {
-    MTRand::uint32 *s = mtrand.state;
-    int i = mtrand.N;
-    for( ; i--; is >> *s++ ) {}
-    is >> mtrand.left;
-    mtrand.pNext = &mtrand.state[mtrand.N-mtrand.left];
+    MTRand::uint32 loadArray[MTRand::SAVE];
+    int size = mtrand.saveSize();
+    for( int i = 0; i < size; ++i )
+        is >> loadArray[i];
+    mtrand.load( loadArray );
     return is;
 }
 
 inline MTRand& MTRand::operator=( const MTRand& o )
 {
     if( this == &o ) return (*this);
-    const uint32 *t = o.state;
-    uint32 *s = state;
-    int i = N;
-    for( ; i--; *s++ = *t++ ) {}
-    left = o.left;
-    pNext = &state[N-left];
+    copy(o);
     return (*this);
 }
 
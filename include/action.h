@@ -54,6 +54,22 @@ class ActionBase {
         virtual double potentialActionCorrection (const beadLocator &) {return 0.0; }
         virtual double potentialActionCorrection (const beadLocator &, const beadLocator &) { return 0.0; }
 
+        /** A lower bound on the potential action of a single bead (-BIG if unknown) */
+        virtual double potentialActionLowerBound (const beadLocator &) { return -BIG; }
+
+        /** Can the potential action be split into terms scaling as tau and tau^3? */
+        virtual bool hasPotentialActionComponents() { return false; }
+        /** The total potential action split into terms scaling as tau and tau^3 */
+        virtual bool potentialActionComponents (double &, double &) { return false; }
+
+        /** Can we compute the action of a bead at a trial position? */
+        virtual bool hasTrialPotentialAction() { return false; }
+        /** The potential action of a single bead placed at a trial position */
+        virtual double trialPotentialAction (const beadLocator &, const dVec &) { return 0.0; }
+        /** As above, safe to call concurrently using the supplied neighbor buffers */
+        virtual double trialPotentialAction (const beadLocator &, const dVec &,
+                vector <beadLocator> &, vector <dVec> &) { return 0.0; }
+
         /* Various derivatives of the potential action */
         virtual double derivPotentialActionTau (int) { return 0.0; }
         virtual double derivPotentialActionLambda (int) { return 0.0; }
@@ -66,17 +82,10 @@ class ActionBase {
         /* gradient of the potential action */
         virtual dVec gradPotentialAction(int) { return 0.0; }
 
-        /* r \dot gradU -> for virial estimator.
-         * It is necessary to split the terms in order to compute
-         * the specific heat efficiently.*/
-        virtual double rDOTgradUterm1(int) { return 0.0; }
-        virtual double rDOTgradUterm2(int) { return 0.0; }
-
-        /* (r-R) \dot gradU -> for centroid virial estimator.
-         * It is necessary to split the terms in order to compute
-         * the specific heat efficiently.*/
-        virtual double deltaDOTgradUterm1(int) { return 0.0; }
-        virtual double deltaDOTgradUterm2(int) { return 0.0; }
+        /* Both terms of gradU on every bead of a slice -> for the virial
+         * estimators.  They are split in order to compute the specific heat
+         * efficiently. */
+        virtual void virialForces(int, blitz::Array<dVec,1> &, blitz::Array<dVec,1> &);
 
         /* return virial kinetic energy estimator term */
         virtual double virKinCorr(int) { return 0.0; }
@@ -108,9 +117,6 @@ class ActionBase {
         PotentialBase *externalPtr;     ///< The external potential
         PotentialBase *interactionPtr;  ///< The interaction potential
 
-	blitz::Array <int,1> sepHist;          ///< A histogram of separations
-	blitz::Array <int,1> cylSepHist;       ///< A histogram of separations for a cylinder
-
     protected:
         string name;                    ///< The name of the action
 
@@ -134,11 +140,6 @@ class ActionBase {
 
         beadLocator bead2,bead3;        // Bead indexers
         dVec sep,sep2;                  // The spatial separation between beads.
-        double dSep;                    // The discretization for the separation histogram
-        double dPerSep;                 // The PBC discretization for the separation histogram 
-
-        /* Update the separation histogram */
-        void updateSepHist(const dVec &);   
 };
 
 // ========================================================================  
@@ -166,6 +167,19 @@ class LocalAction : public ActionBase {
         double potentialActionCorrection (const beadLocator &);
         double potentialActionCorrection (const beadLocator &, const beadLocator &);
 
+        /* A lower bound on the potential action of a single bead */
+        double potentialActionLowerBound (const beadLocator &);
+
+        /* The total potential action split by its dependence on tau */
+        bool hasPotentialActionComponents() { return true; }
+        bool potentialActionComponents (double &, double &);
+
+        /* The potential action of a single bead at a trial position */
+        bool hasTrialPotentialAction() { return !PIGS; }
+        double trialPotentialAction (const beadLocator &, const dVec &);
+        double trialPotentialAction (const beadLocator &, const dVec &,
+                vector <beadLocator> &, vector <dVec> &);
+
         /* Various derivatives of the potential action */
         double derivPotentialActionTau (int);
         double derivPotentialActionLambda (int);
@@ -176,13 +190,8 @@ class LocalAction : public ActionBase {
         /* gradient of the potential action */
         virtual dVec gradPotentialAction(int slice) { return gradU(slice); }
 
-        /* R \dot gradU -> for virial estimators */
-        double rDOTgradUterm1(int); 
-        double rDOTgradUterm2(int); 
-
-        /* delta \dot gradU -> for centroid virial estimators */
-        virtual double deltaDOTgradUterm1(int slice) { return deltadotgradUterm1(slice); }
-        virtual double deltaDOTgradUterm2(int slice) { return deltadotgradUterm2(slice); }
+        /* Both terms of gradU on every bead of a slice */
+        void virialForces(int, blitz::Array<dVec,1> &, blitz::Array<dVec,1> &);
 
         /* Returns virial kinetic energy correction term. */
         virtual double virKinCorr(int slice) { return virialKinCorrection(slice); }
@@ -215,6 +224,7 @@ class LocalAction : public ActionBase {
         /* The full potential with the NN lookup table for a single bead and all
          * beads at a single time slice. */
         double Vnn(const beadLocator&);
+        double Vnn(const beadLocator&, const dVec&);
         double Vnn(const int);
 
         /* The bare potential action for a trajectory */
@@ -223,6 +233,7 @@ class LocalAction : public ActionBase {
         /* The gradient of the potential squared for a single bead using the 
          * nearest neighbor lookup table */
         double gradVnnSquared(const beadLocator&);
+        double gradVnnSquared(const beadLocator&, const dVec&);
 
         /* gradient and Laplacian of potential energy */
         dVec gradientV(const int);
@@ -230,14 +241,6 @@ class LocalAction : public ActionBase {
         /* T-matrix needed for grad((gradV)^2) */
         dMat tMatrix(const int);
 
-        /* r \dot gradU -> for virial estimator */
-        double RdotgradUterm1(const int);
-        double RdotgradUterm2(const int);
-
-        /* delta \dot gradU -> for centroid virial estimator */
-        double deltadotgradUterm1(const int);
-        double deltadotgradUterm2(const int);
-
         /* virial kinetic energy term */
         double virialKinCorrection(const int);
 
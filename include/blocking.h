@@ -0,0 +1,82 @@
+/**
+ * @file blocking.h
+ * @date 10.16.2026
+ *
+ * @brief BlockingAnalysis class definition.
+ */
+
+#ifndef BLOCKING_H
+#define BLOCKING_H
+
+#include "common.h"
+
+// ========================================================================
+// BlockingAnalysis Class
+// ========================================================================
+/**
+ * Online Flyvbjerg-Petersen blocking of a set of correlated time series.
+ *
+ * Every new value is added to level 0, and each pair of consecutive values
+ * at a level is averaged into a single value at the next level, so level k
+ * holds block averages of 2^k values.  Only the sum, sum of squares and one
+ * pending value are kept per level, so the memory is O(log n).
+ *
+ * The naive error of the mean grows with the level until the blocks are
+ * longer than the autocorrelation time, and then stays flat.  The error is
+ * taken from the first level whose successor agrees with it within its own
+ * statistical uncertainty, and the integrated autocorrelation time follows
+ * from the ratio of this error to that of the uncorrelated estimate.
+ *
+ * The accumulators can be saved to and loaded from a state file, so that
+ * the analysis carries on across restarts.
+ *
+ * @see H. Flyvbjerg and H. G. Petersen, J. Chem. Phys. 91, 461 (1989).
+ */
+class BlockingAnalysis {
+
+    public:
+        BlockingAnalysis(const int);
+
+        /* Add one value of every series */
+        void add(const blitz::Array<double,1> &);
+
+        /** The number of values added to each series */
+        uint64_t count() const {return level.empty() ? 0 : level[0].n;}
+
+        /* The mean of a series */
+        double mean(const int) const;
+
+        /* The error of the mean of a series at its plateau */
+        double error(const int) const;
+
+        /* The integrated autocorrelation time of a series in units of values */
+        double tau(const int) const;
+
+        /* Has the error of a series reached a plateau? */
+        bool converged(const int) const;
+
+        /* Write or read the accumulators of every level */
+        void save(ostream &) const;
+        bool load(istream &);
+
+    private:
+        /** The accumulators of one blocking level */
+        struct Level {
+            uint64_t n;                 // The number of blocks
+            vector <double> sum;        // The sum of the blocks
+            vector <double> sum2;       // The sum of their squares
+            vector <double> pending;    // A block awaiting its partner
+            bool hasPending;            // Is there a pending block?
+        };
+
+        int numSeries;                  // The number of series
+        vector <Level> level;           // The blocking levels
+
+        /* The naive error of the mean of a series at a level */
+        double levelError(const int, const int) const;
+
+        /* The plateau level of a series */
+        int plateau(const int, bool &) const;
+};
+
+#endif
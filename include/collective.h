@@ -0,0 +1,93 @@
+/**
+ * @file collective.h
+ * @date 10.16.2026
+ *
+ * @brief CollectiveDensity class definition.
+ */
+
+#ifndef COLLECTIVE_H
+#define COLLECTIVE_H
+
+#include "common.h"
+#include <functional>
+
+class Path;
+class FFT;
+
+// ========================================================================
+// CollectiveDensity Class
+// ========================================================================
+/**
+ * The collective density modes of a path.
+ *
+ * Computes ρ_q = Σ_j exp(iq·r_j) at every time slice for a fixed set of
+ * q-vectors, grouped into shells.  Vector k of shell n is written as n times
+ * a base vector, which is shared by all shells with vectors in the same
+ * direction.  The phases of each bead are then only computed once per base
+ * vector, and the higher multiples follow from a complex recurrence.  This
+ * takes O(N) work per q-vector and slice, instead of the O(N^2) pair sum.
+ * The base vectors are independent, and are computed by the thread pool.
+ *
+ * Correlations in imaginary time are found from the power spectrum of ρ_q
+ * along the slices, taking O(P log P) work per q-vector.
+ */
+class CollectiveDensity {
+
+    public:
+        CollectiveDensity(const vector< vector<dVec> > &, const dVec &side = dVec(0.0));
+        CollectiveDensity(const vector<dVec> &);
+        ~CollectiveDensity();
+
+        /** A filter on the beads which contribute */
+        typedef std::function<bool(const dVec &)> filter;
+
+        /* Compute ρ_q at each time slice for the included beads */
+        void compute(const Path &, const filter &include = filter());
+
+        /** The number of q-vector shells */
+        int numShells() const {return int(qBase.size());}
+
+        /** The number of q-vectors in a shell */
+        int numVectors(const int nq) const {return int(qBase[nq].size());}
+
+        /** The number of time slices of the last computation */
+        int numSlices() const {return rhoRe.extent(blitz::firstDim);}
+
+        /** The real part of ρ_q for vector k of shell nq at a slice */
+        double re(const int slice, const int nq, const int k) const {
+            return rhoRe(slice,qBase[nq][k],qMultiple[nq][k]);
+        }
+
+        /** The imaginary part of ρ_q for vector k of shell nq at a slice */
+        double im(const int slice, const int nq, const int k) const {
+            return rhoIm(slice,qBase[nq][k],qMultiple[nq][k]);
+        }
+
+        /* The sum of |ρ_q|^2 over slices and the vectors of each shell */
+        void structureFactor(blitz::Array<double,1> &) const;
+
+        /* The imaginary time autocorrelation of ρ_q summed over each shell */
+        void correlation(blitz::Array<double,2> &);
+
+    private:
+        vector <dVec> base;                 // The base vectors
+        int maxMultiple;                    // The largest multiple of a base vector
+
+        vector < vector<int> > qBase;       // The base of each q-vector
+        vector < vector<int> > qMultiple;   // The multiple of its base
+
+        vector < vector<dVec> > pos;        // The included beads at each slice
+
+        blitz::Array <double,3> rhoRe;      // Re ρ_q for (slice,base,multiple)
+        blitz::Array <double,3> rhoIm;      // Im ρ_q for (slice,base,multiple)
+
+        FFT *fftPtr;                        // The transform along the slices
+
+        /* Add a q-vector to the last shell */
+        void addVector(const dVec &, const int);
+
+        /* Compute all multiples of a base vector */
+        void computeBase(const int);
+};
+
+#endif
@@ -37,6 +37,7 @@
         #define gpu_wait(x) hipStreamSynchronize(x)
         #define gpu_memset(w, x, y, z) hipMemsetAsync(w, x, y, z)
         #define gpu_free(x, y) hipFreeAsync(x, y)
+        #define gpu_device_count(x) hipGetDeviceCount(&x)
         #ifdef USE_BLAS
             #include "hipblas.hpp"
             typedef hipHandle_t gpu_blas_handle_t;
@@ -58,6 +59,7 @@
         #define gpu_wait(x) cudaStreamSynchronize(x)
         #define gpu_memset(w, x, y, z) cudaMemsetAsync(w, x, y, z)
         #define gpu_free(x, y) cudaFreeAsync(x, y)
+        #define gpu_device_count(x) cudaGetDeviceCount(&x)
         #ifdef USE_BLAS
             #include "cublas_v2.h"
             typedef cublasHandle_t gpu_blas_handle_t;
@@ -88,6 +90,7 @@
         #define gpu_wait(x) x.wait()
         #define gpu_memset(w, x, y, z) z.memset(w, x, y)
         #define gpu_free(x, y) sycl::free(x, y)
+        #define gpu_device_count(x) x = sycl::device::get_devices(sycl::info::device_type::gpu).size()
         #ifdef USE_BLAS
             #include "oneapi/mkl.hpp"
             typedef sycl::queue gpu_blas_handle_t;
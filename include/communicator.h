@@ -13,6 +13,10 @@
 #include "constants.h"
 #include <cstring>
 #include <fstream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 
 // ========================================================================  
@@ -41,6 +45,10 @@ class File
         /* Reset and rename the primary file */
         void reset();
         void rename();
+
+        /* Atomically replace the primary file with a string */
+        void replace(const string &, const bool);
+
         void prepare() {prepared_ = true;}
         bool prepared() {return prepared_;}
 
@@ -65,6 +73,50 @@ class File
 
 };
 
+// ========================================================================  
+// StateWriter Class
+// ========================================================================  
+/** 
+ * Writes state files on a background thread.
+ *
+ * State strings are handed over by pointer and written in the order they 
+ * were submitted, each through a (possibly synced) backup file which is 
+ * then renamed.  A buffer must not be modified until the ticket returned 
+ * on its submission has been waited for.
+ */
+class StateWriter
+{
+    public:
+        StateWriter(const bool);
+        ~StateWriter();
+
+        /* Queue a state string to be written to a file */
+        uint64_t submit(File *, const string *);
+
+        /* Wait until a submitted state is on disk */
+        void wait(const uint64_t);
+
+        /** Wait until all submitted states are on disk */
+        void flush() {wait(numSubmitted);}
+
+    private:
+        bool sync;                          // Do we fsync before renaming?
+
+        std::mutex writerMutex;             // Protects the queue and counters
+        std::condition_variable submitted;  // Signals a new state or stop
+        std::condition_variable written;    // Signals a state on disk
+
+        std::deque< pair<File*,const string*> > queue;  // The pending writes
+        uint64_t numSubmitted;              // The total number of states submitted
+        uint64_t numWritten;                // The total number of states on disk
+        bool stopping;                      // Have we been asked to stop?
+
+        std::thread writer;                 // The I/O thread
+
+        /* The writer loop */
+        void work();
+};
+
 // ========================================================================  
 // Communicator Class
 // ========================================================================  
@@ -81,9 +133,26 @@ class Communicator
     public:
         static Communicator* getInstance();
 
+        /* Give the calling thread its own set of output files */
+        static Communicator* bindReplica();
+        static void unbindReplica();
+
+        /* Share the output files of another thread with the calling thread */
+        static void attach(Communicator *);
+        static void detach();
+
+        /** The communicator bound to the calling thread (or NULL) */
+        static Communicator* binding() {return replica_;}
+
         /** Initialize the output files */
         void init(double,bool,string,string);
 
+        /** Write all files to a directory other than OUTPUT (before init) */
+        void setBaseDir(const string &_baseDir) {baseDir = _baseDir;}
+
+        /* Close all files and remove the output directory */
+        void discard();
+
         /** Get method returning file object */
         File *file(string type) {
             if (!file_.count(type))
@@ -99,6 +168,8 @@ class Communicator
         Communicator& operator= (const Communicator&);  ///< Singleton equals
 
     private:
+        static thread_local Communicator *replica_;   // Communicator bound to this thread
+
         ios_base::openmode mode;    // The file i/o mode
 
         string ensemble;            // The type of ensemble
@@ -125,5 +196,113 @@ inline Communicator* communicate() {
     Communicator *temp = Communicator::getInstance();
     return temp;
 }
+
+// ========================================================================  
+// EnsembleChannel Class
+// ========================================================================  
+/** 
+ * Streams estimator bins from an ensemble worker to the aggregator.
+ *
+ * Only exists in a process forked by the ensemble launcher.  The estimators
+ * sharing an output file are assembled into a single row, which is sent 
+ * down a pipe once complete, along with the file header the first time.
+ * An empty label marks the end of the stream, so that the aggregator can
+ * tell a finished worker from one that died.
+ */
+class EnsembleChannel
+{
+    public:
+        static EnsembleChannel* getInstance() {return instance_;}
+
+        /* Open or close the channel of this process */
+        static void open(const int);
+        static void close();
+
+        /* Add the bin of a single estimator */
+        void bin(const string &, const string &, const double *, const int, const bool);
+
+    private:
+        EnsembleChannel(const int _fd) : fd(_fd) {}
+
+        static EnsembleChannel *instance_;  // The channel of this process (or NULL)
+
+        int fd;                             // The write end of the pipe
+        map <string,string> header;         // The header of each partial row
+        map <string,vector<double>> row;    // The partial row of each file
+        set <string> sent;                  // Files whose header was sent
+};
+
+/**************************************************************************//**
+ *  Global public access to the ensemble channel (NULL unless a worker).
+******************************************************************************/
+inline EnsembleChannel* ensembleChannel() {
+    return EnsembleChannel::getInstance();
+}
+
+// ========================================================================  
+// EnsembleAggregator Class
+// ========================================================================  
+/** 
+ * Merges the estimator bins of an ensemble of workers.
+ *
+ * Each worker streams its bins through its own pipe.  Once every worker has
+ * delivered its n-th bin of a file, the mean over workers of their running
+ * averages up to that bin is written to the file, and its standard error 
+ * (from the scatter between independent workers) to a matching _err file.
+ *
+ * Workers may deliver different numbers of bins, and a worker which has
+ * ended its stream is left out of the rows it did not deliver.  A worker
+ * whose pipe closes before it signals the end of its stream has died.  Its unmerged bins are dropped and the remaining rows are merged
+ * over the survivors, with a warning.  As the error needs at least two
+ * workers, the aggregator fails once fewer survive.  The fate of every
+ * worker is written to the log file.
+ */
+class EnsembleAggregator
+{
+    public:
+        EnsembleAggregator(const vector<int> &, const vector<pid_t> &);
+
+        /* Merge bins until all workers have finished */
+        void run();
+
+        /** The number of merged rows of all files */
+        uint32 numMerged() const {return numMerged_;}
+
+        /** The number of workers which died */
+        int numFailed() const {return numFailed_;}
+
+    private:
+        /* The data of a single file */
+        struct Stream {
+            string header;                                  // The file header
+            vector < vector<double> > sum;                  // The running sum of each worker
+            vector <uint32> numBins;                        // The bins of each worker
+            vector < std::deque< vector<double> > > ready;  // Unmerged running averages
+            size_t numAveraged = 0;                         // The workers in the last row
+            uint32 numRows = 0;                             // The rows written
+        };
+
+        vector <int> fd;                    // The read end of each pipe
+        vector <pid_t> pid;                 // The process of each worker
+        vector <bool> alive;                // Is the worker still merged?
+        vector <bool> finished;             // Did it end its stream?
+        vector <uint32> numReceived;        // The rows received from each worker
+        map <string,Stream> stream;         // The data of each file
+        uint32 numMerged_;                  // The number of merged rows
+        int numFailed_;                     // The number of workers which died
+        vector <string> event;              // Changes to the workers merged, for the log
+
+        /* Receive one row from a worker */
+        bool receive(const int);
+
+        /* Reap a worker whose pipe has closed */
+        void reap(const int);
+
+        /* Write all rows delivered by every surviving worker */
+        void merge(const string &);
+
+        /* Record the fate of every worker */
+        void log();
+};
 #endif
 
@@ -35,6 +35,20 @@ class ConstantParameters
     public:
         static ConstantParameters* getInstance();
 
+        /* Give the calling thread its own copy of the constants */
+        static ConstantParameters* bindReplica();
+        static void unbindReplica();
+
+        /* Give the calling thread its own copy of another thread's constants */
+        static ConstantParameters* bindCopy(ConstantParameters *);
+
+        /** The constants bound to the calling thread (or NULL) */
+        static ConstantParameters* binding() {return replica_;}
+
+        /* Share the constants of another thread with the calling thread */
+        static void attach(ConstantParameters *);
+        static void detach();
+
         void initConstants(po::variables_map &);
 
         /* All the get methods */
@@ -54,6 +68,13 @@ class ConstantParameters
         double displaceDelta() const {return displaceDelta_;}       ///< Get center of mass shift
         double aCC() const {return aCC_;}                    // The graphene/graphite carbon-carbon distance
         int virialWindow() const {return virialWindow_;}    ///< Get centroid virial window size.
+        int pairCorrelationBins() const {return pairCorrelationBins_;}          ///< Get number of g(r) bins
+        double pairCorrelationRadius() const {return pairCorrelationRadius_;}   ///< Get maximum g(r) separation
+        int obdmSeparations() const {return obdmSeparations_;}                  ///< Get number of OBDM separations
+        bool blocking() const {return blocking_;}                               ///< Are we blocking scalar estimators?
+        double targetError() const {return targetError_;}                       ///< Get the target error (0 for none)
+        string targetQuantity() const {return targetQuantity_;}                 ///< Get the estimator:quantity targeted
+        double estimatorBudget() const {return estimatorBudget_;}               ///< Get the fraction of a step spent measuring
 
         /** Get deBroglie wavelength */
         double dBWavelength() const {return dBWavelength_;} ///< Get deBroglie wavelength
@@ -116,6 +137,7 @@ class ConstantParameters
         string graphenelut3d_file_prefix() const {return graphenelut3d_file_prefix_;} ///< Get GrapheneLUT3D file prefix <prefix>_serialized.{dat|txt}
         string wavevector() const {return wavevector_;}                               ///< Get wavevectors for scattering functions
         string wavevectorType() const {return wavevectorType_;}                       ///< Get wavevector types for scattering functions
+        string scatteringBackend() const {return scatteringBackend_;}                 ///< Get the backend of the scattering estimators
 
         /* Trial wave funciton parameters */
         double R_LL_wfn() const {return R_LL_wfn_;}        ///< Get Lieb-Liniger length scale
@@ -123,6 +145,14 @@ class ConstantParameters
     
         /* Set methods */
         void setmu(double _mu) {mu_ = _mu;}             ///< Set the value of the chemical potential
+
+        /** Set the temperature at a fixed number of time slices */
+        void setT(double _T) {
+            T_ = _T;
+            imagTimeLength_ = 1.0/T_;
+            tau_ = 1.0/(numTimeSlices_*T_);
+            dBWavelength_ = 2.0*sqrt(M_PI * lambda_ / T_);
+        }
         void setCoMDelta(double _comDelta) {comDelta_ = _comDelta;} ///< Set the CoM move size
         void setDisplaceDelta(double _displaceDelta) {displaceDelta_ = _displaceDelta;} ///< Set the displace move size
 
@@ -135,13 +165,19 @@ class ConstantParameters
         void shiftmu (double frac) { mu_ += frac; }                     ///< Shift the chemical potential
 
         bool saveStateFiles() { return saveStateFiles_;}                              ///< Are we saving states every MC bin?
+        bool syncStateFiles() { return syncStateFiles_;}                              ///< Are state files synced to disk?
 
     protected:
         ConstantParameters();
-        ConstantParameters(const ConstantParameters&);              ///< Protected constructor
+        ConstantParameters(const ConstantParameters&) = default;    ///< Protected constructor
         ConstantParameters& operator= (const ConstantParameters&);  ///< Overload Singleton equals
 
     private:
+        static thread_local ConstantParameters *replica_;   // Constants bound to this thread
+
+        /* Generate a new unique simulation UUID */
+        void generateID();
+
         double T_;              // Temperature [K]
         double imagTimeLength_; // Temperature [K]
         double mu_;             // Chemical Potential [K]
@@ -183,6 +219,7 @@ class ConstantParameters
         bool varUpdates_;           // Perform variable length diagonal updates
 
         string  id_;                // The unique simulation UUID
+        string label_;              // A user label appended to the UUID
         string intPotentialType_;   // The type of interaction potential
         string extPotentialType_;   // The type of external potential
         string waveFunctionType_;   // The type of trial wave function
@@ -192,13 +229,22 @@ class ConstantParameters
         string actionType_;         // The type of action
 
         int virialWindow_;        // Window size for centroid virial estimator
+        int pairCorrelationBins_;       // Number of bins of the pair correlation function
+        double pairCorrelationRadius_;  // Maximum separation of the pair correlation function
+        int obdmSeparations_;           // Number of separations of the one body density matrix
+        bool blocking_;                 // Do we keep online blocking error bars?
+        double targetError_;            // Stop once this error is reached (0 for never)
+        string targetQuantity_;         // The estimator:quantity whose error is targeted
+        double estimatorBudget_;        // The fraction of a step spent measuring (0 for fixed)
         int maxWind_;             // The maximum winding number sampled
         uint32 binSize_;               // The number of measurments per bin.
 
         bool saveStateFiles_;              // Are we saving a state file every MC bin?
+        bool syncStateFiles_;              // Do we fsync state files before renaming?
         string graphenelut3d_file_prefix_; // GrapheneLUT3D file prefix <prefix>_{V,gradV,grad2V}.npy 
         string wavevector_;                // Input for wavevectors 
         string wavevectorType_;            // Type of input for wavevectors
+        string scatteringBackend_;         // Backend of the scattering estimators
         
         map <string,double> attemptProb_;   // The move attempt probabilities
 };
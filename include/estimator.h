@@ -21,6 +21,10 @@
 class Path;
 class ActionBase;
 class Potential;
+class CollectiveDensity;
+class LookupTable;
+class ObservablesCache;
+class BlockingAnalysis;
 
 // ========================================================================  
 // EstimatorBase Class
@@ -72,6 +76,12 @@ class EstimatorBase {
         /** Get the number of samples since the last reset */
         uint32 getNumSampled() const { return numSampled; }
 
+        /** Get the number of steps between measurements */
+        int getFrequency() const { return frequency; }
+
+        /** Set the number of steps between measurements */
+        void setFrequency(const int _frequency) { frequency = _frequency; }
+
         /** Get the name of the estimator */
         virtual string getName() const { return "base"; }
 
@@ -90,13 +100,28 @@ class EstimatorBase {
         /** Get the estimator label */
         string getLabel() const {return label;};
 
+        /** Share the cached observables of the configuration of the path */
+        void shareObservables(ObservablesCache *_observables) {observables = _observables;}
+
+        /* The blocking summary of each named quantity */
+        string summary() const;
+
+        /* The blocking error of a named quantity */
+        bool blockingError(const string &, double &, bool &) const;
+
+        /* Write or read the blocking accumulators in a state file */
+        void saveBlocking(ostream &) const;
+        void loadBlocking(istream &);
+
     protected:
         const Path &path;               ///< A constant reference to the paths
         ActionBase *actionPtr;          ///< A pointer to the action
+        ObservablesCache *observables;  ///< Quantities shared by the estimators of the path
         MTRand random;                  // A local copy of the random number generator
         double maxR;                    // An estimator cutoff radius
 
         fstream *outFilePtr;            ///< The output fie
+        BlockingAnalysis *blocking;     ///< Online error analysis of the bins (or NULL)
 
         map<string,int> estIndex;       ///< Map estimator labels to indices.
 
@@ -230,6 +255,16 @@ class VirialEnergyEstimator: public EstimatorBase {
         void accumulate();      // Accumulate values
         uint32 numPPAccumulated; ///< The number of per particle (PP) accumulated values
 
+        blitz::Array <dVec,2> delta;    ///< The deviation of each bead from its centroid
+        blitz::Array <bool,2> doBead;   ///< Used for ensuring we don't double count beads
+        blitz::Array <dVec,1> gU1;      ///< The tau term of gradU at a slice
+        blitz::Array <dVec,1> gU2;      ///< The tau^3 term of gradU at a slice
+
+        vector <beadLocator> cycle;     ///< The beads of a worldline
+        vector <dVec> link;             ///< The link leaving each bead of a worldline
+        vector <dVec> u;                ///< The unwrapped worldline
+
+        double centroidDeviations();    // Slide the window along each worldline
 };
 
 // ========================================================================  
@@ -704,6 +739,7 @@ class OneBodyDensityMatrixEstimator: public EstimatorBase {
     private:
         Path &lpath;                    // A non-constant local reference to the path
 
+        int numSep;                     // The number of separations
         double dR;                      // The discretization
         int numReps;                    // The number of measurments reps                   
         uint32 numAccepted;             // The number of moves accepted
@@ -724,8 +760,14 @@ class OneBodyDensityMatrixEstimator: public EstimatorBase {
         /* Returns a position used by the staging algorithm */
         dVec newStagingPosition(const beadLocator &, const beadLocator &, const int, const int);
 
+        vector <dVec> trialTailPos;     // The displaced tail of each trial
+        vector <double> trialKick;      // The staging deviates of each trial
+        vector <double> trialUniform;   // The acceptance deviate of each trial
+        vector <double> trialWeight;    // The weight of each trial
+
         /* Accumulate values */
         void accumulate();  
+        void accumulateInPath();
 };
 
 // ========================================================================  
@@ -733,6 +775,9 @@ class OneBodyDensityMatrixEstimator: public EstimatorBase {
 // ========================================================================  
 /** 
  * Compute the two-body pair-correlation function, g(r) ~ <rho(r)rho(0)>.
+ *
+ * The beads are placed in a grid of boxes no smaller than the largest
+ * separation, so only pairs in neighboring boxes are considered.
  */
 class PairCorrelationEstimator: public EstimatorBase {
 
@@ -746,7 +791,12 @@ class PairCorrelationEstimator: public EstimatorBase {
 
     private:
         void accumulate();              // Accumulate values
+        void binPair(const beadLocator &, const beadLocator &);  // Histogram one pair
+        int numBins;                    // The number of separations
         double dR;                      // The discretization
+        double rMax;                    // The largest separation
+        LookupTable *cells;             // The grid of beads (NULL for all pairs)
+	blitz::Array <double,1> pairHist;      // The histogram of pair separations
 };
 
 // ========================================================================  
@@ -769,9 +819,9 @@ class StaticStructureFactorEstimator: public EstimatorBase {
         void accumulate();              // Accumulate values
 	blitz::Array <double,1> sf;            // structure factor
         vector <vector<dVec> > q;       // the q-vectors
+        CollectiveDensity *rho;         // the collective density modes
 };
 
-#ifdef USE_GPU
 // ========================================================================  
 // GPU Accellerated Static Structure Factor
 // ========================================================================  
@@ -795,6 +845,10 @@ class StaticStructureFactorGPUEstimator: public EstimatorBase {
         blitz::Array<double,1> ssf;             // local intermediate scattering function
 
         int numq;                        // the number of q vectors
+        bool useDevice;                 // Do we run on the gpu?
+        CollectiveDensity *rho;         // the collective density modes on the cpu
+
+#ifdef USE_GPU
         size_t bytes_beads;
         size_t bytes_ssf;
         size_t bytes_qvecs;
@@ -804,10 +858,9 @@ class StaticStructureFactorGPUEstimator: public EstimatorBase {
 
         //FIXME stream handling needs to be moved out of estimators
         gpu_stream_t stream_array[MAX_GPU_STREAMS]; // Store Multiple GPU streams
-};
 #endif
+};
 
-#ifdef USE_GPU
 // ========================================================================  
 // GPU Accellerated Cylinder Static Structure Factor Estimator Class
 // ========================================================================  
@@ -833,6 +886,10 @@ class CylinderStaticStructureFactorGPUEstimator: public EstimatorBase {
         blitz::Array<double,1> ssf;             // local intermediate scattering function
 
         int numq;                        // the number of q vectors
+        bool useDevice;                 // Do we run on the gpu?
+        CollectiveDensity *rho;         // the collective density modes on the cpu
+
+#ifdef USE_GPU
         size_t bytes_beads;
         size_t bytes_ssf;
         size_t bytes_qvecs;
@@ -842,8 +899,8 @@ class CylinderStaticStructureFactorGPUEstimator: public EstimatorBase {
 
         //FIXME stream handling needs to be moved out of estimators
         gpu_stream_t stream_array[MAX_GPU_STREAMS]; // Store Multiple GPU streams
-};
 #endif
+};
 
 // ========================================================================  
 // Intermediate Scattering Function Estimator Class
@@ -868,9 +925,10 @@ class IntermediateScatteringFunctionEstimator: public EstimatorBase {
         int numq;                       // the number of q-magnitudes
 	blitz::Array <int,1> numqVecs;         // the number of q-vectors with a given magnitude
         vector <vector<dVec> > q;       // the q-vectors
+        CollectiveDensity *rho;         // the collective density modes
+	blitz::Array <double,2> corr;          // their correlation in imaginary time
 };
 
-#ifdef USE_GPU
 // ========================================================================  
 // Intermediate Scattering Function GPU Estimator Class
 // ========================================================================  
@@ -894,6 +952,11 @@ class IntermediateScatteringFunctionEstimatorGpu: public EstimatorBase {
 	blitz::Array<double,1> isf;           // local intermediate scattering function
 
         int numq;                        // the number of q vectors
+        bool useDevice;                 // Do we run on the gpu?
+        CollectiveDensity *rho;         // the collective density modes on the cpu
+	blitz::Array <double,2> corr;          // their correlation in imaginary time
+
+#ifdef USE_GPU
         size_t bytes_beads;
         size_t bytes_isf;
         size_t bytes_qvecs;
@@ -903,11 +966,9 @@ class IntermediateScatteringFunctionEstimatorGpu: public EstimatorBase {
 
         //FIXME stream handling needs to be moved out of estimators
         gpu_stream_t stream_array[MAX_GPU_STREAMS]; // Store Multiple GPU streams
-        
-};
 #endif
+};
 
-#ifdef USE_GPU
 // ========================================================================  
 // Elastic Scattering GPU Estimator Class
 // ========================================================================  
@@ -931,6 +992,11 @@ class ElasticScatteringEstimatorGpu: public EstimatorBase {
 	blitz::Array<double,1> es;           // local intermediate scattering function
 
         int numq;                        // the number of q vectors
+        bool useDevice;                 // Do we run on the gpu?
+        CollectiveDensity *rho;         // the collective density modes on the cpu
+	blitz::Array <double,2> corr;          // their correlation in imaginary time
+
+#ifdef USE_GPU
         size_t bytes_beads;
         size_t bytes_es;
         size_t bytes_qvecs;
@@ -940,8 +1006,8 @@ class ElasticScatteringEstimatorGpu: public EstimatorBase {
 
         //FIXME stream handling needs to be moved out of estimators
         gpu_stream_t stream_array[MAX_GPU_STREAMS]; // Store Multiple GPU streams
-};
 #endif
+};
 
 
 // ========================================================================  
@@ -1136,6 +1202,7 @@ class CylinderOneBodyDensityMatrixEstimator: public EstimatorBase {
     private:
         Path &lpath;                    // A non-constant local reference to the path
 
+        int numSep;                     // The number of separations
         double dR;                      // The discretization
         int numReps;                    // The number of measurments reps                   
         uint32 numAccepted;             // The number of moves accepted
@@ -1180,7 +1247,9 @@ class CylinderPairCorrelationEstimator: public EstimatorBase {
 
     private:
         void accumulate();              // Accumulate values
+        int numBins;                    // The number of separations
         double dR;                      // The discretization
+	blitz::Array <double,1> pairHist;      // The histogram of pair separations
 };
 
 // ========================================================================  
@@ -1256,6 +1325,7 @@ class CylinderStaticStructureFactorEstimator: public EstimatorBase {
         void accumulate();              // Accumulate values
 	blitz::Array <double,1> sf;            // structure factor
         vector <vector<dVec> > q;       // the q-vectors
+        CollectiveDensity *rho;         // the collective density modes
 };
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -1486,6 +1556,7 @@ class PIGSOneBodyDensityMatrixEstimator: public EstimatorBase {
     private:
         Path &lpath;                    // A non-constant local reference to the path
 
+        int numSep;                     // The number of separations
         double dR;                      // The discretization
         int numReps;                    // The number of measurments reps
         uint32 numAccepted;             // The number of moves accepted
@@ -0,0 +1,51 @@
+/**
+ * @file fft.h
+ * @date 10.16.2026
+ *
+ * @brief FFT class definition.
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include "common.h"
+#include <complex>
+
+// ========================================================================
+// FFT Class
+// ========================================================================
+/**
+ * A one dimensional complex discrete Fourier transform of fixed length.
+ *
+ * Powers of two use an iterative radix-2 transform, and all other lengths
+ * are mapped onto one via Bluestein's chirp-z algorithm, so any length
+ * takes O(n log n) operations.  The tables are computed once, and
+ * transforms may run concurrently.
+ */
+class FFT {
+
+    public:
+        typedef std::complex<double> complex;
+
+        FFT(const int);
+
+        /** The length of the transform */
+        int size() const {return n;}
+
+        /* The unnormalized forward (e^{-i}) or inverse (e^{+i}) transform */
+        void transform(vector <complex> &, const bool inverse=false) const;
+
+    private:
+        int n;                          // The length of the transform
+        int m;                          // The power of two used internally
+        bool bluestein;                 // Is n not a power of two?
+
+        vector <complex> twiddle;       // The radix-2 roots of unity of length m
+        vector <complex> chirp;         // exp(iπj^2/n)
+        vector <complex> chirpFT;       // The transform of the padded chirp
+
+        /* The in-place radix-2 transform of length m */
+        void radix2(vector <complex> &, const bool) const;
+};
+
+#endif
@@ -29,7 +29,7 @@ class Path;
 class LookupTable {
 
     public:
-        LookupTable(const Container *, const int, const int);
+        LookupTable(const Container *, const int, const int, const double _rc=0.0);
         ~LookupTable();
 
         const Container *boxPtr;            ///< The simulation cell
@@ -50,6 +50,9 @@ class LookupTable {
 
         /* Update the NN table interaction list */
         void updateInteractionList(const Path &, const beadLocator &);
+        void updateInteractionList(const Path &, const beadLocator &, const dVec &);
+        void trialInteractionList(const Path &, const beadLocator &, const dVec &,
+                vector <beadLocator> &, vector <dVec> &);
         void updateFullInteractionList(const beadLocator &, const int);
         void updateFullInteractionList(const int, const int);
         void updateGrid(const Path &);
@@ -59,7 +62,10 @@ class LookupTable {
 
         /* Remove a bead from the grid */
         void delBead(const beadLocator &);
+        void delBeads(const blitz::Array <beadLocator,1>&, const int);
+        void moveBead(const beadLocator &, const beadLocator &);
         void addBead(const beadLocator &, const dVec &);
+        void addBeads(const blitz::Array <beadLocator,1>&, const blitz::Array <dVec,1>&, const int);
         void updateBead(const beadLocator &, const dVec &);
 
         /* Returns the grid index where the suplied position resides */
@@ -98,7 +104,8 @@ class LookupTable {
         iVec numNNGrid;                     // The number of nn grid boxes in each direction
         iVec gIndex;                        // A commonly used grid box index vector
 
-        double rc2;                         // A local copy of the potential cutoff squared
+        double rc;                          // The grid box size, the potential cutoff unless given
+        double rc2;                         // A local copy of the cutoff squared
 
 	blitz::TinyVector<int,NDIM+1> nnIndex;     // Comonly used nn index vector
 	blitz::TinyVector<int,NDIM+1> nI;          // Used for indexing numLabels
@@ -119,6 +126,7 @@ class LookupTable {
         beadLocator swap;                   // Used when deleting/updating beads
 
         void setupNNGrid();                 // We initialize the nearest neighbor grid
+        void resizeHash();                  // Grow the hash array to hashSize
 
         /* Return tiny vectors suitable for indexing the numLabel and hash array */
         inline blitz::TinyVector <int,NDIM+1> numLabelIndex(const beadLocator&);
@@ -88,8 +88,8 @@ class MoveBase {
         int numToMove;                  ///< The number of particles moved
         int numLevels;                  // The 2^numLevels = num slices moved
 
-        static uint32 totAccepted;      ///< The total number of  moves accepted
-        static uint32 totAttempted;     ///< The total number of  moves attempted
+        static thread_local uint32 totAccepted;     ///< The total number of  moves accepted
+        static thread_local uint32 totAttempted;    ///< The total number of  moves attempted
 
 	blitz::Array <uint32,1> numAcceptedLevel;  ///< The number of moves accepted at each level
 	blitz::Array <uint32,1> numAttemptedLevel; ///< The number of moves attempted at each level
@@ -122,6 +122,7 @@ class MoveBase {
         /* Returns a new bead position based on the staging algorithm */
         dVec newStagingPosition(const beadLocator &, const beadLocator &, const int, const int);
         dVec newStagingPosition(const beadLocator &, const beadLocator &, const int, const int, iVec &);
+        dVec newStagingPosition(const dVec &, const beadLocator &, const int, const int, iVec &);
 
         /** Obtain a winding sector for a stage-like move */
         iVec sampleWindingSector(const beadLocator &, const beadLocator &, const int, double &);
@@ -131,10 +132,16 @@ class MoveBase {
 
         /* Return a new bead position which samples the free particle density matrix */
         dVec newFreeParticlePosition(const beadLocator &);
+        dVec newFreeParticlePosition(const dVec &);
 
         /* Returns a new bead position based on the bisection algorithm */
         dVec newBisectionPosition(const beadLocator&, const int);   
 
+        /* The potential action of a trajectory, stopping early if it exceeds a bound */
+        bool boundedPotentialAction(const beadLocator &, const beadLocator &, const double, double &);
+        bool boundedTrialPotentialAction(const blitz::Array <beadLocator,1> &, 
+                const blitz::Array <dVec,1> &, const int, const double, double &);
+
         double newK,oldK;               ///< The old and new kinetic action
         double newV,oldV;               ///< The old and new potential action
 
@@ -257,6 +264,8 @@ class CenterOfMassMove: public MoveBase {
     private:
         beadLocator startBead,endBead;  // The start and end beads
         void undoMove();                // revert everything back
+
+        blitz::Array <beadLocator,1> wlBeads;   // The beads on the moved worldline
 };
 
 
@@ -284,6 +293,7 @@ class StagingMove: public MoveBase {
         void undoMove();                    // Undo the move
 
         int stageLength;                    // The length of the stage
+        blitz::Array <beadLocator,1> stageBeads; // The beads inside the stage
 };
 
 // ========================================================================  
@@ -0,0 +1,193 @@
+/**
+ * @file numa.h
+ * @date 10.16.2026
+ *
+ * @brief NumaArena class definition.
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "common.h"
+#include <map>
+#include <mutex>
+
+// ========================================================================
+// NumaArena Class
+// ========================================================================
+/**
+ * Places large arrays on numa nodes.
+ *
+ * Blitz arrays allocate their own memory from the heap, which lands on the
+ * node of the thread that first touches it.  Per path arrays are filled by
+ * the thread which owns them, so pinning threads with a numa affinity is
+ * enough to keep them local, and the arena only tracks them.  Their pages
+ * are never bound, as heap ranges share pages with unrelated data.
+ *
+ * Shared read-only tables may be replicated, with one copy on each node in
+ * its own page aligned mapping which prefers that node, and each thread
+ * reading the copy of the node it is running on.  Preferring rather than
+ * binding lets a full node fall back to the others.
+ *
+ * All tracked arrays can be reported on, giving the nodes their pages
+ * actually reside on.  Without numa support (or when disabled) nothing is
+ * tracked or replicated.
+ */
+class NumaArena {
+
+    public:
+        static NumaArena* getInstance();
+
+        /* Detect the numa nodes, and enable placement or replication */
+        void init(const bool, const bool);
+
+        /** The number of numa nodes */
+        int numNodes() const {return int(nodeCPU.size());}
+
+        /* The numa node of the calling thread */
+        int node();
+
+        /* Track an array owned by the calling thread */
+        template <class T, int N>
+            void place(const blitz::Array<T,N> &, const string &);
+
+        /* Replicate a shared read-only array on each node */
+        template <class T, int N>
+            void replicate(const blitz::Array<T,N> &, vector< blitz::Array<T,N> > &, const string &);
+
+        /* The copy of an array on the node of the calling thread */
+        template <class T, int N>
+            const blitz::Array<T,N> &local(const blitz::Array<T,N> &,
+                    const vector< blitz::Array<T,N> > &);
+
+        /* Stop tracking an array, releasing it if it is a replica */
+        void forget(const void *);
+
+        /* Report where the tracked arrays reside */
+        void report(const bool);
+
+    protected:
+        NumaArena();
+        NumaArena(const NumaArena&);                ///< Copy constructor
+        NumaArena& operator= (const NumaArena&);    ///< Singleton equals
+
+    private:
+        /* A tracked array */
+        struct Entry {
+            string label;               // What the array holds
+            const void *owner;          // The constants of the owning replica
+            bool shared;                // Is it shared between replicas?
+            const void *data;           // The first element
+            size_t size;                // The number of bytes
+            void *mapping;              // The mapping of a replica (or NULL)
+            size_t mappingSize;         // The number of bytes mapped
+        };
+
+        bool placing;                   // Do we track arrays for the report?
+        bool replicating;               // Do we replicate shared tables?
+        vector < vector<int> > nodeCPU; // The cpus of each node
+        vector <int> cpuNode;           // The node of each cpu
+
+        std::mutex entryMutex;          // Protects the tracked arrays
+        std::map<const void *, Entry> entry;    // Tracked arrays, by array
+
+        /* Map memory which prefers a node */
+        void *allocate(const size_t, const int);
+
+        /* Track an array */
+        void track(const void *, const string &, const bool, const void *, const size_t,
+                void *mapping = NULL, const size_t mappingSize = 0);
+
+        /* The fraction of pages of a range of memory on each node */
+        vector <double> locate(const void *, const size_t);
+};
+
+/**************************************************************************//**
+ *  Global public access to the numa arena singleton.
+******************************************************************************/
+inline NumaArena* numaArena() {
+    NumaArena *temp = NumaArena::getInstance();
+    return temp;
+}
+
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// TEMPLATE FUNCTION DEFINITIONS
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**************************************************************************//**
+ *  Track an array owned by the calling thread.
+ *
+ *  Its pages are placed on first touch, so this only records the array for
+ *  the report.  It must be repeated whenever the array is reallocated.
+ *
+ *  @param array The array
+ *  @param label A description of the array for the report
+******************************************************************************/
+template <class T, int N>
+void NumaArena::place(const blitz::Array<T,N> &array, const string &label) {
+
+    if (!placing || (array.size() == 0))
+        return;
+
+    track(&array, label, false, array.dataFirst(), array.size()*sizeof(T));
+}
+
+/**************************************************************************//**
+ *  Replicate a shared read-only array on each node.
+ *
+ *  Each copy lives in its own mapping which prefers its node, and refers to
+ *  it without owning it.  The mapping is released when the copy is
+ *  forgotten, which must happen before the copy is used again.  Without
+ *  replication (or if a mapping fails) the copies are empty, and the
+ *  original is only tracked.
+ *
+ *  @param array The original array
+ *  @param copy The copies, one for each node
+ *  @param label A description of the array for the report
+******************************************************************************/
+template <class T, int N>
+void NumaArena::replicate(const blitz::Array<T,N> &array, vector< blitz::Array<T,N> > &copy,
+        const string &label) {
+
+    copy.clear();
+    if (!placing || (array.size() == 0))
+        return;
+
+    track(&array, label, true, array.dataFirst(), array.size()*sizeof(T));
+    if (!replicating)
+        return;
+
+    /* The copies are tracked by address, so the vector must not grow later */
+    size_t size = array.size()*sizeof(T);
+    copy.resize(numNodes());
+    for (int n = 0; n < numNodes(); n++) {
+        T *data = static_cast<T *>(allocate(size,n));
+        if (data == NULL) {
+            for (int m = 0; m < n; m++)
+                forget(&copy[m]);
+            copy.clear();
+            return;
+        }
+        copy[n].reference(blitz::Array<T,N>(data, array.shape(), blitz::neverDeleteData));
+        copy[n] = array;
+        track(&copy[n], str(format("%s (node %d copy)") % label % n), true,
+                data, size, data, size);
+    }
+}
+
+/**************************************************************************//**
+ *  The copy of an array on the node of the calling thread.
+ *
+ *  @param array The original array
+ *  @param copy The copies on each node (or empty)
+ *  @return The copy to read from
+******************************************************************************/
+template <class T, int N>
+const blitz::Array<T,N> &NumaArena::local(const blitz::Array<T,N> &array,
+        const vector< blitz::Array<T,N> > &copy) {
+    if (copy.empty())
+        return array;
+    return copy[node()];
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file observables.h
+ * @date 10.16.2026
+ *
+ * @brief ObservablesCache class definition.
+ */
+
+#ifndef OBSERVABLES_H
+#define OBSERVABLES_H
+
+#include "common.h"
+
+class Path;
+class ActionBase;
+
+// ========================================================================
+// ObservablesCache Class
+// ========================================================================
+/**
+ * Quantities of a single path configuration shared between estimators.
+ *
+ * Many estimators need the same sums over all beads: the squared link
+ * lengths of each slice, the winding vector, and the potential and its
+ * derivatives on each slice.  All estimators of a path share one cache,
+ * which is invalidated whenever the configuration changes.  Each quantity
+ * is then computed lazily the first time it is requested, so it is found
+ * at most once per configuration no matter how many estimators use it.
+ *
+ * The superfluid estimators share a single sweep over the worldlines, which
+ * finds the link, area element and grid cell of every bead once.  It is
+ * threaded over slices, and stores each quantity contiguously by slice so
+ * that the estimators scatter it into their own grids with simple loops.
+ *
+ * Invalidation only bumps a counter, so it costs nothing when no estimator
+ * is measured.  A cache must only be used by the thread sampling its path.
+ * While timing, the time spent filling the cache is accumulated, so that it
+ * can be kept apart from the cost of the estimator which happens to ask
+ * first.
+ */
+class ObservablesCache {
+
+    public:
+        ObservablesCache(const Path &, ActionBase *);
+
+        /** The link of every bead r_j -> r_{j+1}, stored slice by slice */
+        struct Worldlines {
+            vector <int> offset;        ///< The first bead of each slice, and the total
+            vector <double> x;          ///< The x position of each bead
+            vector <double> y;          ///< The y position of each bead
+            vector <double> linkZ;      ///< The periodic link along the last dimension
+            vector <double> area;       ///< The area element x_j y_{j+1} - x_{j+1} y_j
+            vector <double> inner;      ///< x_j x_{j+1} + y_j y_{j+1}
+            vector <int> cell;          ///< The grid cell of the container
+            double Az;                  ///< The total area
+            double I;                   ///< The total of inner
+
+            /** The number of beads */
+            int size() const {return offset.back();}
+        };
+
+        /** Mark all quantities as stale after the path has changed */
+        void invalidate() {++configuration;}
+
+        /** Start or stop accumulating the time spent filling the cache */
+        void setTiming(const bool _timing) {timing = _timing;}
+
+        /** The seconds spent filling the cache while timing */
+        double fillTime() const {return fillTime_;}
+
+        /* The sum of the squared link lengths |r_{j+1} - r_j|^2 at a slice */
+        double linkSquared(const int);
+
+        /* The sum of the links r_{j+1} - r_j over all beads */
+        const dVec &winding();
+
+        /* The links of every bead */
+        const Worldlines &worldlines();
+
+        /* The external and interaction potential at a slice */
+        const blitz::TinyVector<double,2> &potential(const int);
+
+        /* The derivatives of the potential action at a slice */
+        double derivPotentialActionTau(const int);
+        double derivPotentialActionLambda(const int);
+
+    private:
+        const Path &path;                   // The path
+        ActionBase *actionPtr;              // The action
+
+        uint64_t configuration;             // Bumped whenever the path changes
+
+        bool timing;                        // Are fills being timed?
+        double fillTime_;                   // The seconds spent filling
+        std::chrono::steady_clock::time_point fillStart;    // The start of a fill
+
+        uint64_t linkConfig;                // The configuration of the links
+        vector <double> link2;              // Σ |Δr|^2 at each slice
+        dVec W;                             // Σ Δr over all beads
+
+        uint64_t worldlineConfig;           // The configuration of the worldlines
+        Worldlines wl;                      // The links of every bead
+        vector <dVec> sliceW;               // Σ Δr at each slice
+        vector <double> sliceAz;            // The area at each slice
+        vector <double> sliceI;             // The total of inner at each slice
+
+        vector <uint64_t> potentialConfig;  // The configuration of each potential
+        vector < blitz::TinyVector<double,2> > V;
+
+        vector <uint64_t> dUdTauConfig;     // The configuration of each dU/dτ
+        vector <double> dUdTau;
+
+        vector <uint64_t> dUdLambdaConfig;  // The configuration of each dU/dλ
+        vector <double> dUdLambda;
+
+        /* Time a fill of the cache */
+        void beginFill();
+        void endFill();
+
+        /* Find the links of every slice in a single pass */
+        void computeLinks();
+
+        /* Find the links of every bead of a slice */
+        void sweepSlice(const int);
+};
+
+#endif
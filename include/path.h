@@ -16,6 +16,40 @@
 
 class LookupTable;
 
+// ========================================================================  
+// PathSnapshot Class
+// ========================================================================  
+/** 
+ * A compact copy of a worldline configuration.
+ *
+ * Holds everything an estimator may read from a path, so that it can be
+ * measured on another thread while the original path continues to be 
+ * updated.
+ */
+struct PathSnapshot {
+    blitz::Array <dVec,2> beads;                ///< The worldline array
+    blitz::Array <beadLocator,2> prevLink;      ///< Backward bead connections
+    blitz::Array <beadLocator,2> nextLink;      ///< Forward bead connections
+    blitz::Array <unsigned int,2> wormBeads;    ///< Is a bead present?
+    blitz::Array <int,1> numBeadsAtSlice;       ///< The number of active beads at each slice
+
+    beadLocator head;                   ///< The worm head
+    beadLocator tail;                   ///< The worm tail
+    beadLocator special1;               ///< Special worm bead
+    beadLocator special2;               ///< Special worm bead
+    double maxWormCost;                 ///< The maximum worm cost
+    dVec sep;                           ///< The head-tail separation
+    int length;                         ///< The length of the worm
+    int gap;                            ///< numTimeSlices - length
+    bool isConfigDiagonal;              ///< Is the configuration diagonal?
+    int numBeadsOn;                     ///< The number of active beads
+
+    int breakSlice;                     ///< The location of the break in the path
+    vector<int> brokenWorldlinesL;      ///< Broken worldlines left of the break
+    vector<int> brokenWorldlinesR;      ///< Broken worldlines right of the break
+    vector<int> closedWorldlines;       ///< Closed worldlines
+};
+
 // ========================================================================  
 // Path Class
 // ========================================================================  
@@ -120,6 +154,9 @@ class Path {
         beadLocator addNextBead(const beadLocator&, const dVec &);
         /** Add a bead at the previous time slice */
         beadLocator addPrevBead(const beadLocator&, const dVec &);
+        /** Add a linked segment of beads next to (or previous to) a bead */
+        beadLocator insertSegment(const beadLocator&, const blitz::Array<dVec,1> &, 
+                const int, const bool forward=true);
 
         /** Remove a bead from the world-line configuration */
         void delBead(const beadLocator&);
@@ -127,6 +164,8 @@ class Path {
         beadLocator delBeadGetNext(const beadLocator&);
         /** Delete a bead and move backwards */
         beadLocator delBeadGetPrev(const beadLocator&);
+        /** Remove a linked segment of beads starting at a bead */
+        beadLocator removeSegment(const beadLocator&, const int, const bool forward=true);
     
         /** Break the link to right of bead **/
         void breakLink(const beadLocator&);
@@ -158,6 +197,16 @@ class Path {
         /** Reset broken/closed worldline vectors **/
         void resetBrokenClosedVecs();
 
+        /** Exchange the diagonal configuration with another path */
+        void exchangeConfiguration(Path &);
+
+        /* Copy the configuration to and from a snapshot */
+        void saveSnapshot(PathSnapshot &) const;
+        void loadSnapshot(const PathSnapshot &);
+
+        /* Track the worldline arrays for the numa report */
+        void placeMemory();
+
     private:
         friend class PathIntegralMonteCarlo;        // Friends for I/O
 
@@ -165,6 +214,10 @@ class Path {
 	blitz::Array<beadLocator,2> prevLink, nextLink;    // Bead connection matrices
 
         beadLocator lastBeadIndex;                  // Holds the index of the last bead on a slice
+	blitz::Array<beadLocator,1> segmentBeads;          // Scratch list of beads added in a segment
+
+        /* Grow all worldline data structures to hold a number of worldlines */
+        void reserveWorldLines(const int);
 };
 
 /* inline Path* new_clone(Path const& other){ */
@@ -12,11 +12,21 @@
 #include "common.h"
 #include "communicator.h"
 #include "estimator.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <csignal>
 
 class Path;
+struct PathSnapshot;
+class EstimatorPipeline;
+class TrialChains;
+class ActionBase;
 class LookupTable;
 class MoveBase;
 class EstimatorBase;
+class ObservablesCache;
 
 /** A vector containing measurable estimators */
 typedef boost::ptr_vector<EstimatorBase> estimator_vector;
@@ -36,8 +46,11 @@ typedef boost::ptr_vector<MoveBase> move_vector;
  */
 class PathIntegralMonteCarlo {
     public:
-        PathIntegralMonteCarlo (boost::ptr_vector<Path> &,MTRand &, boost::ptr_vector<move_vector> &,
-                                boost::ptr_vector<estimator_vector> &, const bool);
+        PathIntegralMonteCarlo (boost::ptr_vector<Path> &,MTRand &, boost::ptr_vector<ActionBase> &,
+                                boost::ptr_vector<move_vector> &,
+                                boost::ptr_vector<estimator_vector> &, const bool,
+                                const vector<MTRand*> &, EstimatorPipeline *pipelinePtr = NULL,
+                                TrialChains *trialPtr = NULL);
         ~PathIntegralMonteCarlo ();
 
 
@@ -47,6 +60,10 @@ class PathIntegralMonteCarlo {
         bool  equilStepRelaxmu();
         bool  equilStepRelaxC0();
 
+        /* The equilibration relaxation using concurrent trial chains */
+        bool  equilStepRelaxmuTrial();
+        bool  equilStepRelaxC0Trial();
+
         void equilStep(const uint32, const bool, const bool);
 
         /* The actual monte carlo step */
@@ -58,6 +75,18 @@ class PathIntegralMonteCarlo {
         /* Save the PIMC state to disk */
         void saveState(const int finalSave = 0);
 
+        /** Wait until all saved states are on disk */
+        void flushState() {stateWriter.flush();}
+
+        /* Are all paths in a diagonal configuration? */
+        bool isDiagonal();
+
+        /* Has the blocking error of the target quantity been reached? */
+        bool targetReached();
+
+        /* Save the current state to disk */
+        void checkpoint();
+
         /* Output the world-line configurations in the protein databank format */
         void outputPDB();
 
@@ -78,6 +107,10 @@ class PathIntegralMonteCarlo {
 
     private:
         MTRand &random;             // The global random number generator
+        vector<MTRand*> pathRandom; // The random number generator of each path
+        EstimatorPipeline *pipeline; // Estimators sampled asynchronously (or NULL)
+        TrialChains *trial;         // Concurrent chains used for relaxation (or NULL)
+        double trialSpread;         // The spread of trial C0 or μ values
 
         int configNumber;           // The output configuration number
         int numImagTimeSweeps;      // Partitioning used for updates
@@ -114,10 +147,13 @@ class PathIntegralMonteCarlo {
 
         uint32 Npaths;                 // Number of paths
     
-        vector<string> stateStrings; // A vector of state strings from the last bin
+        vector<string> stateStrings[2]; // Double buffered state strings from the last bins
+        int stateBuffer;                // The buffer holding the most recent state strings
+        uint64_t stateTicket[2];        // The last write submitted from each buffer
+        stringstream stateStrStrm;      // Reused when serializing the state
+        StateWriter stateWriter;        // Writes state files in the background
 
         bool startWithState;        // Are we starting from a saved state
-        bool success;               // Track move success/failure
     
         boost::ptr_vector<Path> &pathPtrVec; // The vector of all paths
         Path &path;                          // A reference to the first path in the path vector
@@ -129,6 +165,9 @@ class PathIntegralMonteCarlo {
                                                                // each path followed by multipath
         estimator_vector &estimator;                           // A reference to the first estimator_vector
 
+        boost::ptr_vector<ObservablesCache> observables;       // The observables shared by the
+                                                               // estimators of each path
+
         vector <double> attemptDiagProb;        // The cumulative diagonal attempt Probabilities
         vector <double> attemptOffDiagProb;     // The cumulative off-diagonal attempt Probabilities
 
@@ -138,6 +177,21 @@ class PathIntegralMonteCarlo {
         /* Output estimators to disk */
         void output();
 
+        /* Refresh the blocking summary file */
+        void outputSummary();
+
+        /* The estimators whose blocking accumulators are saved with a path */
+        vector <EstimatorBase*> blockedEstimators(const int);
+
+        bool estimatorsScheduled;   // Have the sampling frequencies been chosen?
+        double updateCost;          // Seconds spent updating the first path while timing
+        double cacheCost;           // Seconds spent filling its shared observables
+        uint32 numTimedSteps;       // The number of steps timed
+        vector <double> sampleCost; // Seconds spent measuring each estimator of the first path
+
+        /* Choose the sampling frequencies from the cost of each estimator */
+        void scheduleEstimators();
+
         /* perform an iterative linear regrssion for C0 calculation */
         double linearRegressionC0();
 
@@ -154,6 +208,240 @@ class PathIntegralMonteCarlo {
         /* Perform a Metropolis update */
         string update(const double,const int,const int);
 
+        /* Perform all updates and measurements of a single path */
+        void updatePath(const uint32);
+
+        /* Run all trial chains from the current configuration */
+        void runTrialChains(const bool, const int);
+        void trialChain(const int, const PathSnapshot &, const bool, const int);
+
+};
+
+// ========================================================================  
+// EstimatorPipeline Class
+// ========================================================================  
+/** 
+ * Asynchronous sampling of expensive estimators.
+ *
+ * After every step the configuration of the path is published into a ring
+ * buffer of snapshots, and the sampling thread only blocks when the buffer 
+ * is full.  Each worker thread owns a copy of the path (with its own lookup
+ * table and action) and a list of estimators built on it.  It loads every 
+ * snapshot in order and samples its estimators, so that they accumulate 
+ * exactly what they would have if sampled inline.  The pipeline is drained 
+ * before any estimator output.
+ */
+class EstimatorPipeline {
+    public:
+        EstimatorPipeline (const Path &, const int);
+        ~EstimatorPipeline ();
+
+        /* Add a worker sampling a list of estimators on its own path */
+        void addWorker(Path &, ActionBase &, estimator_vector &);
+
+        /* Start all workers */
+        void start();
+
+        /* Publish the current configuration */
+        void publish();
+
+        /* Wait for all published configurations to be sampled */
+        void drain();
+
+        /* Finish sampling and stop all workers */
+        void stop();
+
+        vector <estimator_vector*> estimatorPtr;    ///< The estimators of each worker
+
+    private:
+        const Path &path;                   // The path being sampled
+        int numSlots;                       // The size of the ring buffer
+        boost::ptr_vector<PathSnapshot> slot;  // The ring buffer of snapshots
+
+        std::mutex pipelineMutex;           // Protects the counters below
+        std::condition_variable published;  // Signals a new snapshot or stop
+        std::condition_variable consumed;   // Signals a sampled snapshot
+
+        uint64_t numPublished;              // The total number of snapshots published
+        vector <uint64_t> numConsumed;      // The number sampled by each worker
+        bool stopping;                      // Have we been asked to stop?
+
+        vector <Path*> workerPathPtr;       // The path copy of each worker
+        boost::ptr_vector<ObservablesCache> workerObservables; // The observables of each worker
+        vector <std::thread> worker;        // The worker threads
+
+        /* The oldest snapshot still in use */
+        uint64_t minConsumed();
+
+        /* The worker loop */
+        void work(const int, ConstantParameters *, Communicator *);
+};
+
+// ========================================================================  
+// TrialChains Class
+// ========================================================================  
+/** 
+ * Short trial chains used to relax the worm constant or chemical potential.
+ *
+ * Each chain owns a copy of the path with its own moves and random number
+ * generator.  All chains are started from the same configuration, run
+ * concurrently at their own trial value of C0 or μ, and record the
+ * response (diagonal fraction or number distribution) used to choose the
+ * value committed to the simulation.
+ */
+class TrialChains {
+    public:
+        /* Add a chain updating its own path */
+        void addChain(Path &, move_vector &, MTRand &);
+
+        /** The number of chains */
+        int size() const {return pathPtr.size();}
+
+        vector <Path*> pathPtr;             ///< The path of each chain
+        vector <move_vector*> movePtr;      ///< The moves of each chain
+        vector <MTRand*> randomPtr;         ///< The random number generator of each chain
+
+        vector <double> value;              ///< The trial C0 or μ of each chain
+        vector <double> diagFrac;           ///< The measured diagonal fraction
+        vector <double> aveN;               ///< The measured average number of particles
+        vector <int> peakN;                 ///< The peak of the measured P(N)
+};
+
+// ========================================================================  
+// ReplicaExchange Class
+// ========================================================================  
+/** 
+ * Parallel tempering between replicas at a ladder of temperatures and
+ * chemical potentials.
+ *
+ * Each replica runs on its own thread with its own constants, and
+ * periodically meets the others at a barrier.  The last replica to arrive
+ * proposes configuration swaps between neighboring (diagonal) replicas on
+ * the ladder, alternating between even and odd pairs.  The action of a
+ * configuration at a different temperature is obtained from its kinetic
+ * and potential pieces, which scale with known powers of tau.
+ */
+class ReplicaExchange {
+    public:
+        ReplicaExchange (const int, const uint32);
+
+        /* Register the path and action of a replica */
+        void join(const int, Path &, ActionBase &);
+
+        /* Wait for all active replicas and attempt configuration swaps */
+        void exchange(const int);
+
+        /* Remove a replica from all future exchanges */
+        void retire(const int);
+
+        /* Output swap acceptance data to the log file of a replica */
+        void output(const int);
+
+        /* Output swap acceptance data for the whole ladder */
+        void printSummary();
+
+    private:
+        std::mutex exchangeMutex;           // Protects all data below
+        std::condition_variable roundDone;  // Signals the end of an exchange round
+
+        int numReplicas;                    // The number of replicas on the ladder
+        int numActive;                      // The number of replicas still sampling
+        int numArrived;                     // The number of replicas waiting at the barrier
+        uint32 round;                       // The current exchange round
+
+        MTRand random;                      // Used only for swap decisions
+
+        vector <Path*> pathPtr;             // The path of each replica
+        vector <ActionBase*> actionPtr;     // The action of each replica
+        vector <bool> active;               // Is the replica still sampling?
+        vector <bool> diagonal;             // Is the current configuration diagonal?
+
+        vector <double> tau;                // The imaginary time step of each replica
+        vector <double> mu;                 // The chemical potential of each replica
+        vector <double> kinetic;            // The sum of squared link lengths
+        vector <double> bareU;              // The potential action divided by tau
+        vector <double> corU;               // The potential correction divided by tau^3
+        vector <int> numBeads;              // The number of active beads
+
+        vector <uint32> numAttempted;       // Swaps attempted between r and r+1
+        vector <uint32> numAccepted;        // Swaps accepted between r and r+1
+
+        double lambda;                      // hbar^2/2m
+
+        /* The action of configuration c with the parameters of replica r */
+        double action(const int, const int);
+
+        /* Attempt all swaps for the current round */
+        void attemptExchanges();
+};
+
+// ========================================================================  
+// CheckpointScheduler Class
+// ========================================================================  
+/** 
+ * Decides when to checkpoint and when to stop during the measurement stage.
+ *
+ * Steps, bins and checkpoints are timed as the simulation runs.  Under a 
+ * wall clock limit we stop at the last bin boundary from which another bin,
+ * a checkpoint and the final output would not fit, so no bin is lost.  If
+ * even a single step would not fit, a checkpoint is requested and we stop 
+ * after it.  A checkpoint is also requested every checkpoint interval, on
+ * SIGUSR1, and on SIGTERM after which we stop.  Requested checkpoints are
+ * taken at the next diagonal configuration.
+ */
+class CheckpointScheduler {
+    public:
+        CheckpointScheduler(const time_t, const double);
+
+        /* Time a single step */
+        void startStep();
+        void endStep(const bool);
+
+        /* Time a checkpoint */
+        void startCheckpoint();
+        void endCheckpoint();
+
+        /* Should we checkpoint at the next safe point? */
+        bool checkpointDue();
+
+        /* Should we stop? */
+        bool stopDue(const bool);
+
+        /** Did we stop because of a signal? */
+        bool signalled() const {return terminated;}
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        static volatile sig_atomic_t numTerminate;  // SIGTERM received
+        static volatile sig_atomic_t numCheckpoint; // SIGUSR1 received
+        static void handleSignal(int);
+
+        sig_atomic_t seenTerminate;         // Signals already handled
+        sig_atomic_t seenCheckpoint;
+
+        clock::time_point deadline;         // When the wall clock runs out
+        bool wallClockOn;                   // Is there a deadline?
+        double interval;                    // Seconds between checkpoints (or 0)
+
+        clock::time_point stepStart;        // The start of the current step
+        clock::time_point binStart;         // The start of the current bin
+        clock::time_point checkpointStart;  // The start of the current checkpoint
+        clock::time_point lastCheckpoint;   // The end of the last checkpoint
+
+        double stepTime;                    // Running average step duration
+        double binTime;                     // The duration of the last bin
+        double checkpointTime;              // The longest checkpoint duration
+
+        bool requested;                     // Is a checkpoint requested?
+        bool stopAfterCheckpoint;           // Do we stop after it?
+        bool terminated;                    // Did we get SIGTERM?
+
+        /* Seconds until the deadline */
+        double remaining();
+
+        /* The predicted duration of the final checkpoint and output */
+        double finalTime();
 };
 
 #endif
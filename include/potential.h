@@ -55,6 +55,9 @@ class PotentialBase {
         /** Default Initial configuration of particles*/
         virtual blitz::Array<dVec,1> initialConfig(const Container*, MTRand &, const int); 
 
+        /** A lower bound on the potential (-BIG if none is known) */
+        virtual double lowerBoundV() { return -BIG; }
+
         /** A debug method that output's the potential to a supplied separation */
         void output(const double);
 
@@ -89,6 +92,7 @@ class TabulatedPotential {
 
         double dr;                          ///< The discretization for the lookup table
         int tableLength;                    ///< The number of elements in the lookup table
+        double minLookupV;                  ///< The smallest tabulated or extremal value of V
 
 	blitz::TinyVector<double,2> extV;          ///< Extremal value of V
 	blitz::TinyVector<double,2> extdVdr;       ///< Extremal value of dV/dr
@@ -97,6 +101,9 @@ class TabulatedPotential {
         /* Initialize all data structures */
         void initLookupTable(const double, const double);
 
+        /* The smallest tabulated value of V */
+        double tableMin();
+
         /* Returns the 2-point spline fit to the lookup table */
         virtual double newtonGregory(const blitz::Array<double,1>&, const blitz::TinyVector<double,2>&, const double);
 
@@ -128,6 +135,9 @@ class FreePotential: public PotentialBase {
         /** The potential. */
         double V(const dVec &sep) { return 0.0*sep[0]; };
 
+        /** The potential vanishes */
+        double lowerBoundV() { return 0.0; }
+
         /** The gradient of the potential. */
         dVec gradV(const dVec &pos) {
             return (0.0*pos);
@@ -155,6 +165,9 @@ class HarmonicPotential : public PotentialBase {
             return (omega2*dot(r,r)/(4.0*constants()->lambda()));
         }
 
+        /** The potential is non-negative */
+        double lowerBoundV() { return 0.0; }
+
         /** The gradient of the potential. */
         dVec gradV(const dVec &r) {
             dVec tempr;
@@ -683,6 +696,9 @@ class AzizPotential : public PotentialBase, public TabulatedPotential {
         /* The Aziz HFDHE2 Potential */
         double V(const dVec &);
 
+        /* The minimum of the lookup table */
+        double lowerBoundV() { return minLookupV; }
+
         /* The gradient of the Aziz potential */
         dVec gradV(const dVec &);
 
@@ -779,6 +795,9 @@ class SzalewiczPotential : public PotentialBase, public TabulatedPotential {
         /* The Szalewicz HFDHE2 Potential */
         double V(const dVec &);
 
+        /* The minimum of the lookup table */
+        double lowerBoundV() { return minLookupV; }
+
         /* The gradient of the Szalewicz potential */
         dVec gradV(const dVec &);
 
@@ -1314,8 +1333,8 @@ class GrapheneLUT3DPotential: public PotentialBase  {
 
         void put_in_uc( dVec &, double, double);
         void cartesian_to_uc( dVec &, double, double, double, double);
-        double trilinear_interpolation(blitz::Array<double,3>,dVec,double,double,double);
-        double direct_lookup(blitz::Array<double,3>,dVec,double,double,double);
+        double trilinear_interpolation(const blitz::Array<double,3> &,dVec,double,double,double);
+        double direct_lookup(const blitz::Array<double,3> &,dVec,double,double,double);
 
     private:
         double Lzo2;      ///< half the system size in the z-direction
@@ -1347,6 +1366,13 @@ class GrapheneLUT3DPotential: public PotentialBase  {
 	blitz::Array<double,3> grad2V3d; // Laplacian of potential
 	blitz::Array<double,1> LUTinfo;
 
+        /* Copies of the lookup tables on each numa node (if replicated) */
+        vector< blitz::Array<double,3> > nodeV3d;
+        vector< blitz::Array<double,3> > nodeGradV3d_x;
+        vector< blitz::Array<double,3> > nodeGradV3d_y;
+        vector< blitz::Array<double,3> > nodeGradV3d_z;
+        vector< blitz::Array<double,3> > nodeGrad2V3d;
+
 };
 
 /****
@@ -1368,7 +1394,7 @@ inline void GrapheneLUT3DPotential::cartesian_to_uc( dVec &r, double A11, double
     r[1] = _y;
 }
 
-inline double GrapheneLUT3DPotential::trilinear_interpolation(blitz::Array<double,3> P,dVec r,double dx,double dy,double dz) {
+inline double GrapheneLUT3DPotential::trilinear_interpolation(const blitz::Array<double,3> &P,dVec r,double dx,double dy,double dz) {
     double x = r[0];
     double y = r[1];
     double z = r[2];
@@ -1396,7 +1422,7 @@ inline double GrapheneLUT3DPotential::trilinear_interpolation(blitz::Array<doubl
     return c;
 }
 
-inline double GrapheneLUT3DPotential::direct_lookup(blitz::Array<double,3> P,dVec r,double dx,double dy,double dz) {
+inline double GrapheneLUT3DPotential::direct_lookup(const blitz::Array<double,3> &P,dVec r,double dx,double dy,double dz) {
     double x = r[0];
     double y = r[1];
     double z = r[2];
@@ -1490,28 +1516,28 @@ class GrapheneLUT3DPotentialGenerate: public PotentialBase  {
 
         double V_64( double, double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, blitz::Array<int,1>,
-                blitz::Array<int,1>, blitz::Array<double,1> );
+                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, const blitz::Array<int,1> &,
+                const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
         double gradV_x_64( double, double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, blitz::Array<int,1>,
-                blitz::Array<int,1>, blitz::Array<double,1> );
+                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, const blitz::Array<int,1> &,
+                const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
         double gradV_y_64( double, double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, blitz::Array<int,1>,
-                blitz::Array<int,1>, blitz::Array<double,1> );
+                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, const blitz::Array<int,1> &,
+                const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
         double gradV_z_64( double, double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, blitz::Array<int,1>,
-                blitz::Array<int,1>, blitz::Array<double,1> );
+                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, const blitz::Array<int,1> &,
+                const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
         double grad2V_64( double, double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, blitz::Array<int,1>,
-                blitz::Array<int,1>, blitz::Array<double,1> );
+                blitz::TinyVector<double,2>, blitz::TinyVector<double,2>, const blitz::Array<int,1> &,
+                const blitz::Array<int,1> &, const blitz::Array<double,1> & );
         
         std::tuple<
             blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
@@ -1550,56 +1576,56 @@ class GrapheneLUT3DPotentialGenerate: public PotentialBase  {
         }
 
         void calculate_V3D_64(
-                blitz::Array<double,3>, blitz::Array<double,2>, blitz::Array<double,2>,
-                blitz::Array<double,1>, double, double,
+                blitz::Array<double,3> &, const blitz::Array<double,2> &, const blitz::Array<double,2> &,
+                const blitz::Array<double,1> &, double, double,
                 double, blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>,
-                blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &,
+                const blitz::Array<double,1> & );
 
         void calculate_gradV3D_x_64(
-                blitz::Array<double,3>, blitz::Array<double,2>, blitz::Array<double,2>,
-                blitz::Array<double,1>, double, double,
+                blitz::Array<double,3> &, const blitz::Array<double,2> &, const blitz::Array<double,2> &,
+                const blitz::Array<double,1> &, double, double,
                 double, blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>,
-                blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &,
+                const blitz::Array<double,1> & );
 
         void calculate_gradV3D_y_64(
-                blitz::Array<double,3>, blitz::Array<double,2>, blitz::Array<double,2>,
-                blitz::Array<double,1>, double, double,
+                blitz::Array<double,3> &, const blitz::Array<double,2> &, const blitz::Array<double,2> &,
+                const blitz::Array<double,1> &, double, double,
                 double, blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>,
-                blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &,
+                const blitz::Array<double,1> & );
 
         void calculate_gradV3D_z_64(
-                blitz::Array<double,3>, blitz::Array<double,2>, blitz::Array<double,2>,
-                blitz::Array<double,1>, double, double,
+                blitz::Array<double,3> &, const blitz::Array<double,2> &, const blitz::Array<double,2> &,
+                const blitz::Array<double,1> &, double, double,
                 double, blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>,
-                blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &,
+                const blitz::Array<double,1> & );
 
         void calculate_grad2V3D_64(
-                blitz::Array<double,3>, blitz::Array<double,2>, blitz::Array<double,2>,
-                blitz::Array<double,1>, double, double,
+                blitz::Array<double,3> &, const blitz::Array<double,2> &, const blitz::Array<double,2> &,
+                const blitz::Array<double,1> &, double, double,
                 double, blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>,
-                blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &,
+                const blitz::Array<double,1> & );
 
         std::pair<double, double> get_z_min_V_min( 
                 double, double, double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>, blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
         std::pair<double, double> get_z_V_to_find( 
                 double, double, double,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
                 blitz::TinyVector<double,2>, blitz::TinyVector<double,2>,
-                blitz::Array<int,1>, blitz::Array<int,1>, blitz::Array<double,1> );
+                const blitz::Array<int,1> &, const blitz::Array<int,1> &, const blitz::Array<double,1> & );
 
 	blitz::Array<double,3> get_V3D(
                 double, double, double, int, int, int, double, double ); 
@@ -280,7 +280,11 @@ class Setup {
         void communicator();
 
         /* Define the random seed */
-        uint32 seed(const uint32);
+        uint32 seed(const uint32, const int replica=0);
+        uint32 process(const int replica=0);
+
+        /* Set the constants of a tempering replica */
+        void temperingConstants(const int);
         
         /* Output all options to disk */
         void outputOptions(int, char*[], const uint32, const Container*, const iVec&);
@@ -305,6 +309,10 @@ class Setup {
         boost::ptr_vector<EstimatorBase> * estimators(boost::ptr_vector<Path> &,
                 boost::ptr_vector<ActionBase> &, MTRand&);
 
+        /* Setup the estimators sampled asynchronously */
+        int numEstimatorWorkers();
+        boost::ptr_vector<EstimatorBase> * asyncEstimators(Path &, ActionBase *, MTRand &, const int);
+
         Parameters params;                          ///< All simulation parameters
 
     private:
@@ -314,16 +322,22 @@ class Setup {
         vector<string> randomGeneratorName;         ///< The allowed random number generator names
         vector<string> actionName;                  ///< The allowed action names
         vector<string> estimatorName;               ///< The allowed estimator names
+        vector<string> asyncEstimatorName;          ///< The estimators which may be sampled asynchronously
         vector<string> moveName;                    ///< The allowed move names
         vector<string> optionClassNames;            ///< The allowed option class names
         vector<string> wavevectorTypeName;          ///< The allowed wavevector type names
+        vector<string> threadAffinityName;          ///< The allowed thread affinity policies
+        vector<string> scatteringBackendName;       ///< The allowed scattering estimator backends
 
         string interactionNames;                    ///< The interaction output list
         string externalNames;                       ///< The external output list
         string waveFunctionNames;                   ///< The wavefunction output list
         string randomGeneratorNames;                ///< The random number generator output list
+        string threadAffinityNames;                 ///< The thread affinity output list
+        string scatteringBackendNames;              ///< The scattering estimator backend list
         string actionNames;                         ///< The action output list
         string estimatorNames;                      ///< The estimator list
+        string asyncEstimatorNames;                 ///< The asynchronous estimator list
         string moveNames;                           ///< The move list
         string wavevectorTypeNames;                 ///< The wavevector types list
 
@@ -334,6 +348,14 @@ class Setup {
 
         bool definedCell;                           ///< The user has physically set the sim. cell
 
+        map<string,int> estimatorFrequency;         ///< The requested sampling frequencies
+
+        /** Apply the requested sampling frequencies to a list of estimators */
+        void setFrequencies(boost::ptr_vector<EstimatorBase> &, const bool binning=false);
+
+        vector<double> temperingT;                  ///< The tempering ladder temperatures
+        vector<double> temperingMu;                 ///< The tempering ladder chemical potentials
+
         boost::ptr_map<string,po::options_description> optionClasses; ///< A map of different option types
         po::options_description cmdLineOptions;     ///< All options combined
 
@@ -0,0 +1,209 @@
+/**
+ * @file threadpool.h
+ * @date 10.16.2026
+ *
+ * @brief ThreadPool class definition.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "common.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class ConstantParameters;
+class Communicator;
+
+// ========================================================================
+// ThreadPool Class
+// ========================================================================
+/**
+ * A process wide work-stealing thread pool.
+ *
+ * Each worker owns a queue of tasks.  Tasks submitted by a worker are pushed
+ * onto its own queue and executed last in first out, while idle workers
+ * steal the oldest tasks from the queues of others.  Tasks submitted from
+ * outside the pool are dealt round-robin.  A thread waiting on a group of
+ * tasks helps to execute queued ones, so tasks may themselves submit and
+ * wait on others.  Each task runs with the constants and communicator of
+ * the thread that submitted it, so that replicas can share the pool.
+ *
+ * Blocking service threads (estimator workers, the state writer) are not
+ * run on the pool, as they would hold a worker indefinitely.
+ */
+class ThreadPool {
+
+    public:
+        static ThreadPool* getInstance();
+
+        /* Start the workers, with an optional affinity policy */
+        void init(const int, const string &);
+
+        /** The total number of threads, including the calling one */
+        int numThreads() const {return numWorkers+1;}
+
+        /* Undo the pinning inherited from the calling thread */
+        void unpin();
+
+        /* Pin the thread of a replica to its numa node */
+        void pinReplica(const int);
+
+        /**
+         * A group of tasks which are waited on together.
+         */
+        class TaskGroup {
+            public:
+                TaskGroup() : numPending(0) {}
+            private:
+                friend class ThreadPool;
+                std::atomic<int> numPending;    // Tasks not yet finished
+        };
+
+        /* Submit a task to a group */
+        void run(TaskGroup &, std::function<void()>);
+
+        /* Wait for all tasks of a group, helping to execute them */
+        void wait(TaskGroup &);
+
+        /* Call f(i) for all begin <= i < end, in chunks of grain */
+        template <typename F>
+            void parallelFor(const int, const int, F, const int grain = 1);
+
+        /* A reduction which does not depend on the number of threads */
+        template <typename T, typename F, typename R>
+            T parallelReduce(const int, const int, const T &, F, R, const int grain = 1);
+
+    protected:
+        ThreadPool();
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&);              ///< Copy constructor
+        ThreadPool& operator= (const ThreadPool&);  ///< Singleton equals
+
+    private:
+        /* A task and the context it was submitted from */
+        struct Task {
+            std::function<void()> fn;
+            TaskGroup *group;
+            ConstantParameters *constantsPtr;
+            Communicator *communicatorPtr;
+        };
+
+        /* The task queue of a single worker */
+        struct Queue {
+            std::mutex queueMutex;
+            std::deque<Task> task;
+        };
+
+        static thread_local int workerIndex_;   // The worker owning this thread (or -1)
+
+        int numWorkers;                     // The number of worker threads
+        vector <int> cpu;                   // The cpus available to the process
+        vector < vector<int> > nodeCPU;     // The available cpus of each numa node
+        string affinity_;                   // The affinity policy
+        boost::ptr_vector<Queue> queue;     // The queue of each worker
+        vector <std::thread> worker;        // The worker threads
+
+        std::atomic<uint32> nextQueue;      // Round-robin queue for outside tasks
+        std::atomic<int> numQueued;         // The total number of queued tasks
+        bool stopping;                      // Have we been asked to stop?
+
+        std::mutex activityMutex;           // Used to sleep when there is no work
+        std::condition_variable activity;   // Signals a new task or a finished group
+
+        /* Take a task from our own queue or steal one, and run it */
+        bool tryRun();
+
+        /* Run a task in the context it was submitted from */
+        void execute(Task &);
+
+        /* The worker loop */
+        void work(const int, const string);
+
+        /* Pin a worker to a set of cpus */
+        void pin(const int, const string &);
+};
+
+/**************************************************************************//**
+ *  Global public access to the thread pool singleton.
+******************************************************************************/
+inline ThreadPool* threadPool() {
+    ThreadPool *temp = ThreadPool::getInstance();
+    return temp;
+}
+
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// TEMPLATE FUNCTION DEFINITIONS
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**************************************************************************//**
+ *  Parallel for loop.
+ *
+ *  The range is split into chunks of grain iterations, each of which is a
+ *  task.  With a single thread the loop is run in order on the caller.
+ *
+ *  @param begin The first index
+ *  @param end One past the last index
+ *  @param f The loop body, called as f(i)
+ *  @param grain The number of iterations per task
+******************************************************************************/
+template <typename F>
+void ThreadPool::parallelFor(const int begin, const int end, F f, const int grain) {
+
+    if ((numWorkers == 0) || (end - begin <= grain)) {
+        for (int i = begin; i < end; i++)
+            f(i);
+        return;
+    }
+
+    TaskGroup group;
+    for (int lo = begin; lo < end; lo += grain) {
+        int hi = std::min(lo + grain, end);
+        run(group, [&f,lo,hi] {
+            for (int i = lo; i < hi; i++)
+                f(i);
+        });
+    }
+    wait(group);
+}
+
+/**************************************************************************//**
+ *  Deterministic parallel reduction.
+ *
+ *  The range is split into chunks of grain iterations, which depend only on
+ *  the range, each is reduced in order starting from the identity, and the
+ *  partial results are combined in chunk order.  The result is thus
+ *  reproducible, and independent of the number of threads.
+ *
+ *  @param begin The first index
+ *  @param end One past the last index
+ *  @param identity The identity of combine
+ *  @param f The value of each iteration, called as f(i)
+ *  @param combine The reduction, called as combine(a,b)
+ *  @param grain The number of iterations per chunk
+ *  @return The reduction of all f(i)
+******************************************************************************/
+template <typename T, typename F, typename R>
+T ThreadPool::parallelReduce(const int begin, const int end, const T &identity,
+        F f, R combine, const int grain) {
+
+    int numChunks = (end > begin) ? (end - begin + grain - 1)/grain : 0;
+    vector <T> partial(numChunks, identity);
+
+    parallelFor(0, numChunks, [&](const int c) {
+        int hi = std::min(begin + (c+1)*grain, end);
+        for (int i = begin + c*grain; i < hi; i++)
+            partial[c] = combine(partial[c], f(i));
+    });
+
+    T result = identity;
+    for (int c = 0; c < numChunks; c++)
+        result = combine(result, partial[c]);
+    return result;
+}
+
+#endif
@@ -38,14 +38,6 @@ ActionBase::ActionBase (const Path &_path, LookupTable &_lookup,
     /* The default tau scale is 1 */
     shift = 1;
 
-    /* Initialize the separation histogram */
-    sepHist.resize(NPCFSEP);
-    sepHist = 0;
-    cylSepHist.resize(NPCFSEP);
-    cylSepHist = 0;
-    dSep = 0.5*sqrt(NDIM)*path.boxPtr->side[NDIM-1] / (1.0*NPCFSEP);
-    dPerSep = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1] / (1.0*NPCFSEP);
-
     /* Needed for canonical ensemble weighting */
     canonical = constants()->canonical();
     numBeads0  = constants()->initialNumParticles()*constants()->numTimeSlices();
@@ -59,24 +51,6 @@ ActionBase::ActionBase (const Path &_path, LookupTable &_lookup,
  *  Empty base constructor.
 ******************************************************************************/
 ActionBase::~ActionBase() {
-    sepHist.free();
-    cylSepHist.free();
-}
-
-/*************************************************************************//**
- *  Update the separation histogram. 
- *
- *  We multiply by the periodic array, as we will only measure separations 
- *  along spatial dimensions with periodic boundary conditions.
-******************************************************************************/
-inline void ActionBase::updateSepHist(const dVec &_sep) {
-    dVec psep;
-    /* Temporarly computing full radial g(r) */
-    /* psep = path.boxPtr->periodic*_sep; */
-    psep = _sep;
-    int nR = int(sqrt(dot(psep,psep))/dSep);
-    if (nR >= 0 && nR < NPCFSEP)
-        ++sepHist(nR);
 }
 
 /**************************************************************************//**
@@ -250,6 +224,24 @@ double ActionBase::potentialAction (const beadLocator &startBead,
     return totU;
 }
 
+/**************************************************************************//**
+ *  The two terms of the gradient of the potential action on every bead of a
+ *  slice.
+ *
+ *  Actions without virial estimators have no gradient.
+ *
+ *  @param slice the imaginary time slice
+ *  @param gU1 the term scaling as tau on each bead
+ *  @param gU2 the term scaling as tau^3 on each bead
+******************************************************************************/
+void ActionBase::virialForces(int slice, blitz::Array<dVec,1> &gU1, 
+        blitz::Array<dVec,1> &gU2) {
+    gU1.resize(path.numBeadsAtSlice(slice));
+    gU2.resize(path.numBeadsAtSlice(slice));
+    gU1 = dVec(0.0);
+    gU2 = dVec(0.0);
+}
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // LOCAL ACTION BASE CLASS ---------------------------------------------------
@@ -307,6 +299,33 @@ double LocalAction::potentialAction () {
     return ( totU );
 }
 
+/**************************************************************************//**
+ *  Split the total potential action into pieces with a known dependence on
+ *  the imaginary time step.
+ *
+ *  The total potential action is given by tau*bareU + tau^3*corU, which
+ *  allows it to be evaluated for the same configuration at a different
+ *  temperature, as required for replica exchange.
+ *
+ *  @param bareU the bare potential piece (multiplied by tau)
+ *  @param corU the correction piece (multiplied by tau^3)
+ *  @return true, the decomposition is always known for a local action
+******************************************************************************/
+bool LocalAction::potentialActionComponents (double &bareU, double &corU) {
+
+    bareU = corU = 0.0;
+    for (int slice = 0; slice < path.numTimeSlices; slice++) {
+        eo = (slice % 2);
+        bareU += VFactor[eo]*sum(V(slice));
+        
+        /* We only add the correction if it is finite */
+         if ( gradVFactor[eo] > EPS ) 
+             corU += gradVFactor[eo] * constants()->lambda() * gradVSquared(slice);
+    }
+
+    return true;
+}
+
 /**************************************************************************//**
  *  Return the potential action for a single bead indexed with beadIndex.  
  *
@@ -346,6 +365,83 @@ double LocalAction::potentialAction (const beadLocator &beadIndex) {
      return (bareU + corU);
 }
 
+/**************************************************************************//**
+ *  Return the potential action for a single bead placed at a trial position.
+ *
+ *  This is identical to potentialAction(beadIndex) after moving the bead to
+ *  pos, but leaves the path and lookup table untouched, so that a proposed
+ *  trajectory only has to be written if it is accepted.
+******************************************************************************/
+double LocalAction::trialPotentialAction (const beadLocator &beadIndex, const dVec &pos) {
+
+    eo = (beadIndex[0] % 2);
+
+    double bareU = VFactor[eo]*tau()*Vnn(beadIndex,pos);
+    double corU = 0.0;
+    if ( (shift == 1) && (gradVFactor[eo] > EPS) )
+        corU = gradVFactor[eo] * tau() * tau() * tau() * constants()->lambda() 
+            * gradVnnSquared(beadIndex,pos);
+
+    return (bareU + corU);
+}
+
+/**************************************************************************//**
+ *  Return the potential action for a single bead placed at a trial position,
+ *  which may be evaluated for many positions at once.
+ *
+ *  The neighbors are written to the supplied buffers rather than the lookup
+ *  table lists, and nothing else is modified.  The bead need not exist, so
+ *  a new bead may be given by its slice and an unused particle index.
+ *
+ *  @param beadIndex the bead
+ *  @param pos the trial position
+ *  @param nnBead scratch space for the interacting beads
+ *  @param nnSep scratch space for their separations
+******************************************************************************/
+double LocalAction::trialPotentialAction (const beadLocator &beadIndex, const dVec &pos,
+        vector <beadLocator> &nnBead, vector <dVec> &nnSep) {
+
+    int parity = (beadIndex[0] % 2);
+    lookup.trialInteractionList(path,beadIndex,pos,nnBead,nnSep);
+
+    /* The bare potential, as in Vnn */
+    beadState state1 = path.worm.getState(beadIndex);
+    double totV = path.worm.factor(state1)*externalPtr->V(pos);
+    for (size_t n = 0; n < nnBead.size(); n++)
+        totV += path.worm.factor(state1,nnBead[n]) * interactionPtr->V(nnSep[n]);
+
+    double bareU = VFactor[parity]*tau()*totV;
+    double corU = 0.0;
+
+    /* The gradient correction, as in gradVnnSquared */
+    if ( (shift == 1) && (gradVFactor[parity] > EPS) ) {
+        double totF2 = 0.0;
+        dVec Fext1,Fext2;
+        dVec Fint1,Fint2,Fint3;
+
+        Fext1 = externalPtr->gradV(pos);
+        Fint1 = 0.0;
+        for (size_t n = 0; n < nnBead.size(); n++) {
+            Fint2 = interactionPtr->gradV(nnSep[n]);
+            Fint1 -= Fint2;
+            Fext2 = externalPtr->gradV(path(nnBead[n]));
+
+            Fint3 = 0.0;
+            for (size_t m = 0; m < nnBead.size(); m++) {
+                if (m != n)
+                    Fint3 += interactionPtr->gradV(path.getSeparation(nnBead[n],nnBead[m]));
+            }
+
+            totF2 += dot(Fint2,Fint2) + 2.0*dot(Fext2,Fint2) + 2.0*dot(Fint2,Fint3);
+        }
+        totF2 += dot(Fext1,Fext1) + 2.0*dot(Fext1,Fint1) + dot(Fint1,Fint1);
+
+        corU = gradVFactor[parity] * tau() * tau() * tau() * constants()->lambda() * totF2;
+    }
+
+    return (bareU + corU);
+}
+
 /**************************************************************************//**
  *  Return the bare potential action for a single bead indexed with beadIndex.  
  *
@@ -367,6 +463,38 @@ double LocalAction::barePotentialAction (const beadLocator &beadIndex) {
     return bareU;
 }
 
+/**************************************************************************//**
+ *  Return a lower bound on the potential action of a single bead.
+ *
+ *  The external potential and each interaction with another bead on the
+ *  same slice can be no smaller than the (negative part of the) lower bound
+ *  of the potential, while the gradient correction is non-negative.  This
+ *  allows moves to reject a trajectory before its full action has been 
+ *  computed.  If either potential has no known bound we return -BIG.
+******************************************************************************/
+double LocalAction::potentialActionLowerBound (const beadLocator &beadIndex) {
+
+    double minVext = externalPtr->lowerBoundV();
+    double minVint = interactionPtr->lowerBoundV();
+    eo = (beadIndex[0] % 2);
+
+    if ( (minVext <= -BIG) || (minVint <= -BIG) || (VFactor[eo] < 0.0) )
+        return -BIG;
+
+#if PIGS
+    /* The trial wave function enters at the ends and is unbounded */
+    if ( (beadIndex[0] == 0) || (beadIndex[0] == (constants()->numTimeSlices()-1)) )
+        return -BIG;
+#endif
+
+    if (minVext > 0.0)
+        minVext = 0.0;
+    if (minVint > 0.0)
+        minVint = 0.0;
+
+    return VFactor[eo]*tau()*(minVext + (path.numBeadsAtSlice(beadIndex[0])-1)*minVint);
+}
+
 /**************************************************************************//**
  *  Return the potential action correction for a single bead.
  *
@@ -571,7 +699,7 @@ double LocalAction::V(const beadLocator &bead1) {
  *  a single time slice.  
  *
  *  This is really only used for either debugging or during the calculation 
- *  of the potential energy. As such, we update the separation histogram here.
+ *  of the potential energy.
 ******************************************************************************/
 blitz::TinyVector<double,2> LocalAction::V(const int slice) {
 
@@ -583,9 +711,6 @@ blitz::TinyVector<double,2> LocalAction::V(const int slice) {
 
     int numParticles = path.numBeadsAtSlice(slice);
 
-    /* Initialize the separation histogram */
-    sepHist = 0;
-
     /* Calculate the total potential, including external and interaction
      * effects*/
     for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
@@ -600,7 +725,6 @@ blitz::TinyVector<double,2> LocalAction::V(const int slice) {
              * potential */
             for (bead2[1] = bead1[1]+1; bead2[1] < numParticles; bead2[1]++) {
                 sep = path.getSeparation(bead2,bead1);
-                updateSepHist(sep);
                 totVint += path.worm.factor(state1,bead2) * interactionPtr->V(sep);
             } // bead2
 
@@ -617,24 +741,21 @@ blitz::TinyVector<double,2> LocalAction::V(const int slice) {
  *  a cylinder.  
  *
  *  This is really only used for either debugging or during the calculation 
- *  of the potential energy. As such, we update the separation histogram here.
+ *  of the potential energy.
 ******************************************************************************/
 double LocalAction::V(const int slice, const double maxR) {
 
     double totVint = 0.0;
     double totVext = 0.0;
-    dVec r1,r2;
+    dVec r1;
 
-    double r1sq,r2sq;
+    double r1sq;
 
     beadLocator bead1;
     bead1[0] = bead2[0] = slice;
 
     int numParticles = path.numBeadsAtSlice(slice);
 
-    /* Initialize the separation histogram */
-    cylSepHist = 0;
-
     /* Calculate the total potential, including external and interaction
      * effects*/
     for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
@@ -653,18 +774,7 @@ double LocalAction::V(const int slice, const double maxR) {
             /* The loop over all other particles, to find the total interaction
              * potential */
             for (bead2[1] = bead1[1]+1; bead2[1] < numParticles; bead2[1]++) {
-                r2 = path(bead2);
-
-                r2sq = 0.0;
-                for (int i = 0; i < NDIM-1; i++)
-                    r2sq += r2[i]*r2[i];
-
                 sep = path.getSeparation(bead2,bead1);
-                if (r2sq < maxR*maxR) {
-                    int nR = int(abs(sep[2])/dPerSep);
-                    if (nR < NPCFSEP)
-                        ++cylSepHist(nR);
-                }
                 totVint += interactionPtr->V(sep);
             } // bead2
 
@@ -706,6 +816,36 @@ double LocalAction::Vnn(const beadLocator &bead1) {
     return ( totVext + totVint );
 }
 
+/*************************************************************************//**
+ *  Returns the total potential energy felt by a single bead if it were 
+ *  placed at a trial position, using the nearest neighbor lookup table.
+******************************************************************************/
+double LocalAction::Vnn(const beadLocator &bead1, const dVec &pos) {
+
+    double totVint = 0.0;
+    double totVext = 0.0;
+
+    /* We only continue if bead1 is turned on */
+    if (path.worm.beadOn(bead1)) {
+
+        /* Fill up th nearest neighbor list around the trial position */
+        lookup.updateInteractionList(path,bead1,pos);
+
+        /* Get the state of bead 1 */
+        beadState state1 = path.worm.getState(bead1);
+
+        /* Evaluate the external potential */
+        totVext = path.worm.factor(state1)*externalPtr->V(pos);
+
+        /* Sum the interaction potential over all NN beads */
+        for (int n = 0; n < lookup.numBeads; n++) {
+            totVint += path.worm.factor(state1,lookup.beadList(n)) 
+                * interactionPtr->V(lookup.beadSep(n));
+        }
+    }
+    return ( totVext + totVint );
+}
+
 
 /*************************************************************************//**
  *  Returns the total value of the potential energy, including both the
@@ -916,9 +1056,17 @@ double LocalAction::gradVSquared(const int slice, const double maxR) {
  *  neighbor lookup table.
 ******************************************************************************/
 double LocalAction::gradVnnSquared(const beadLocator &bead1) {
+    return gradVnnSquared(bead1,path(bead1));
+}
 
-    /* This should always be called after Vnn, such that the lookup table 
-     * interaction list has been updated!!! */
+/**************************************************************************//**
+ *  Return the gradient of the full potential squared for a single bead
+ *  located at pos.
+ *
+ *  This should always be called after Vnn with the same position, such that 
+ *  the lookup table interaction list has been updated.
+******************************************************************************/
+double LocalAction::gradVnnSquared(const beadLocator &bead1, const dVec &pos) {
 
     double totF2 = 0.0;     // The total force squared
 
@@ -929,7 +1077,7 @@ double LocalAction::gradVnnSquared(const beadLocator &bead1) {
         dVec Fint1,Fint2,Fint3;
 
         /* Get the gradient squared part for the external potential*/
-        Fext1 = externalPtr->gradV(path(bead1));
+        Fext1 = externalPtr->gradV(pos);
 
         /* We first loop over bead2's interacting with bead1 via the nn lookup table */
         Fint1 = 0.0;
@@ -1068,306 +1216,72 @@ dMat LocalAction::tMatrix(const int slice) {
 }
 
 /**************************************************************************//**
- *  Return the sum over particles at a given time slice of the 
- *  gradient of the action potential for a single bead dotted into the
- *  bead's position.  Used for regular virial energy and thermodynamic
- *  pressure.
- *  
- *  NOTE:  This is the first term.  These were split up because it is
- *      beneficial to be able to return them separately when computing
- *      the specific heat via the centroid virial estimator.
+ *  Return the two terms of the gradient of the potential action on every bead
+ *  at a given time slice.
+ *
+ *  The force and T-matrix of each bead are found in a single pass over the
+ *  pairs, so that the virial terms follow from dot products with the
+ *  positions and centroid deviations, without repeating the pair sum for
+ *  every term.
  *
  *  This includes both the external and interaction potentials.
+ *
+ *  @param slice the imaginary time slice
+ *  @param gU1 the term scaling as tau on each bead
+ *  @param gU2 the term scaling as tau^3 on each bead
 ******************************************************************************/
-double LocalAction::rDOTgradUterm1(const int slice) {
+void LocalAction::virialForces(int slice, blitz::Array<dVec,1> &gU1, 
+        blitz::Array<dVec,1> &gU2) {
 
     eo = slice % 2;
     int numParticles = path.numBeadsAtSlice(slice);
 
+    gU1.resize(numParticles);
+    gU2.resize(numParticles);
+
     /* The two interacting particles */
     beadLocator bead1;
     bead1[0] = bead2[0] = slice;
 
-    dVec gVi, gV;
-    double rDotgV = 0.0;
+    dVec gVi, gVe, gV;
+    dVec rDiff;
+    double rmag, dV, d2V;
+    double dVe = 0.0;
+    double g2Ve = 0.0;
+
+    bool correction = (gradVFactor[eo] > EPS);
+    double factor1 = VFactor[eo]*constants()->tau();
+    double factor2 = 2.0 * gradVFactor[eo] * pow(tau(),3) * constants()->lambda();
 
     /* We loop over the first bead */
     for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
-        gVi = 0.0;
-        /* Sum potential of bead1 interacting with all other beads at
-         * a given time slice.*/
-        for (bead2[1] = 0; bead2[1] < numParticles; bead2[1]++) {
-
-            /* Avoid self interactions */
-            if (!all(bead1==bead2)) {
+        dMat tMat = 0.0; // tMat(row, col)
+        dVec gVdotT = 0.0;
 
-                /* The interaction component of the force */
-                gVi += interactionPtr->gradV(path.getSeparation(bead1,bead2));
-            } 
-        } // end bead2
-        
-        /* Now add the external component */
-        gV = (externalPtr->gradV(path(bead1)) + gVi);
-
-        rDotgV += dot(gV, path(bead1));
-
-    } // end bead1
-
-    return (VFactor[eo]*constants()->tau()*rDotgV);
-}
-
-/**************************************************************************//**
- *  Return the sum over particles at a given time slice of the 
- *  gradient of the action potential for a single bead dotted into the
- *  bead's position.  Used for regular virial energy and thermodynamic
- *  pressure.
- *  
- *  NOTE:  This is the second term
- *
- *  This includes both the external and interaction potentials.
-******************************************************************************/
-double LocalAction::rDOTgradUterm2(const int slice) {
-
-    eo = slice % 2;
-    int numParticles = path.numBeadsAtSlice(slice);
-
-    /* The two interacting particles */
-    beadLocator bead1;
-    bead1[0] = bead2[0] = slice;
-
-    dVec gVi, gVe, gV, g2V;
-
-    double term2 = 0.0;
-    if (gradVFactor[eo] > EPS){
-
-        /* constants for tMatrix */
-        dVec rDiff = 0.0;
-        double rmag = 0.0;
-        double d2V = 0.0;
-        double dV = 0.0;
-        double dVe = 0.0;
-        double dVi = 0.0;
-        double g2Vi = 0.0;
-        double g2Ve = 0.0;
-
-        /* We loop over the first bead */
-        for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
-            gV = 0.0;
-            g2V = 0.0;
-            dMat tMat = 0.0; // tMat(row, col)
-            dVec gVdotT = 0.0;
-
-            /* compute external potential derivatives */
-            gVe = externalPtr->gradV(path(bead1));
+        /* compute external potential derivatives */
+        gVe = externalPtr->gradV(path(bead1));
+        gV = gVe;
+        if (correction) {
             dVe = sqrt(dot(gVe,gVe));
             g2Ve = externalPtr->grad2V(path(bead1));
+        }
 
-            gV += gVe;  // update full slice gradient at bead1
-
-            /* Sum potential of bead1 interacting with all other beads at
-             * a given time slice.*/
-            for (bead2[1] = 0; bead2[1] < numParticles; bead2[1]++) {
-
-                /* separation vector */
-                rDiff = path.getSeparation(bead1, bead2);
-                rmag = sqrt(dot(rDiff,rDiff));
-
-                /* Avoid self interactions */
-                if (!all(bead1==bead2)) {
-
-                    /* Compute interaction potential derivatives */
-                    gVi = interactionPtr->gradV(rDiff);
-                    dVi = sqrt(dot(gVi,gVi));
-                    g2Vi = interactionPtr->grad2V(rDiff);
-                    
-                    /* total derivatives between bead1 and bead2 at bead1 */
-                    dV = dVi + dVe;
-                    d2V = g2Vi + g2Ve;
-
-                    /* compute the T-matrix for bead1 interacting with bead2 */
-                    for (int a=0; a<NDIM; a++){
-                        for (int b=0; b<NDIM; b++){
-                            tMat(a,b) += rDiff(a)*rDiff(b)*d2V/(rmag*rmag)
-                                - rDiff(a)*rDiff(b)*dV/pow(rmag,3);
-                            if (a == b)
-                                tMat(a,b) += dV/rmag;
-                        }
-                    }   // end T-matrix 
-                    
-                    gV += gVi;  // update full slice gradient at bead1
-
-                }   
-            }   // end bead2
-
-            /* blitz++ product function seems broken in my current 
-             * version, so this performs matrix-vector mult. 
-             * Checked --MTG */
-            for(int j=0; j<NDIM; j++){
-                for(int i=0; i<NDIM; i++){
-                    gVdotT(j) += gV(i)*tMat(j,i);
-                }
-            }  
-            term2 += dot(gVdotT, path(bead1));
-
-        }   // end bead1
-
-        term2 *= (2.0 * gradVFactor[eo] * pow(tau(),3) * constants()->lambda());
-    }
-
-    return (term2);
-}
-
-/**************************************************************************//**
- *  Return the sum over particles at a given time slice of the 
- *  gradient of the action potential for a single bead dotted into the
- *  bead's position minus the center of mass of the WL that it belongs to. 
- *  
- *  NOTE:  This is the first term.  These were split up because it is
- *      beneficial to be able to return them separately when computing
- *      the specific heat via the centroid virial estimator.
- *
- *  This includes both the external and interaction potentials.
-******************************************************************************/
-double LocalAction::deltadotgradUterm1(const int slice) {
-
-    eo = slice % 2;
-    int numParticles = path.numBeadsAtSlice(slice);
-    int virialWindow = constants()->virialWindow();
-
-    /* The two interacting particles */
-    beadLocator bead1, beadNext, beadPrev, beadNextOld, beadPrevOld;
-    bead1[0] = bead2[0] = slice;
-
-    dVec gVi, gVe, gV, delta;
-    double rDotgV = 0.0;
-
-    /* We loop over the first bead */
-    for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
-        gVi = 0.0;
-        gVe = 0.0;
-        gV = 0.0;
-        delta = 0.0;
-        /* Sum potential of bead1 interacting with all other beads at
+        /* Sum the force of bead1 interacting with all other beads at
          * a given time slice.*/
         for (bead2[1] = 0; bead2[1] < numParticles; bead2[1]++) {
 
             /* Avoid self interactions */
             if (!all(bead1==bead2)) {
 
-                /* The interaction component of the force */
-                gVi += interactionPtr->gradV(path.getSeparation(bead1,bead2));
-            } 
-        } // end bead2
-        
-        /* Now add the external component */
-        gVe += externalPtr->gradV(path(bead1));
-        
-        /* Compute deviation of bead from COM of worldline, 
-         * WITHOUT mirror image conv. */
-        dVec runTotMore = 0.0;
-        dVec runTotLess = 0.0;
-        dVec COM = 0.0;
-        dVec pos1 = path(bead1);
-        beadNextOld = bead1;
-        beadPrevOld = bead1;
-        for (int gamma = 0; gamma < virialWindow; gamma++) {
-            // move along worldline to next (previous) bead
-            beadNext = path.next(bead1, gamma);
-            beadPrev = path.prev(bead1, gamma);
-            // keep running total of distance from first bead
-            // to the current beads of interest 
-            runTotMore += path.getSeparation(beadNext, beadNextOld);
-            runTotLess += path.getSeparation(beadPrev, beadPrevOld);
-            // update center of mass of WL
-            COM += (pos1 + runTotMore) + (pos1 + runTotLess);
-            // store current bead locations
-            beadNextOld = beadNext;
-            beadPrevOld = beadPrev;
-        }
-        COM /= (2.0*virialWindow);
-
-        delta = pos1 - COM; // end delta computation.
-        path.boxPtr->putInBC(delta);
-        
-        gV += (gVe + gVi);
-
-        rDotgV += dot(gV, delta);
-
-    } // end bead1
-
-    return (VFactor[eo]*constants()->tau()*rDotgV);
-}
-
-/**************************************************************************//**
- *  Return the sum over particles at a given time slice of the 
- *  gradient of the action potential for a single bead dotted into the
- *  bead's position minus the center of mass of the WL that it belongs to. 
- *  
- *  NOTE:  This is the second term
- *
- *  This includes both the external and interaction potentials.
-******************************************************************************/
-double LocalAction::deltadotgradUterm2(const int slice) {
-
-    eo = slice % 2;
-    int numParticles = path.numBeadsAtSlice(slice);
-    int virialWindow = constants()->virialWindow();
-
-    /* The two interacting particles */
-    beadLocator bead1, beadNext, beadPrev, beadNextOld, beadPrevOld;
-    bead1[0] = bead2[0] = slice;
-
-    dVec gVi, gVe, gV, g2V, delta;
-
-    double term2 = 0.0;
-    if (gradVFactor[eo] > EPS){
-
-        /* constants for tMatrix */
-        dVec rDiff = 0.0;
-        double rmag = 0.0;
-        double d2V = 0.0;
-        double dV = 0.0;
-        double dVe = 0.0;
-        double dVi = 0.0;
-        double g2Vi = 0.0;
-        double g2Ve = 0.0;
-
-        /* We loop over the first bead */
-        for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
-            gV = 0.0;
-            g2V = 0.0;
-            delta = 0.0;
-            dMat tMat = 0.0; // tMat(row, col)
-            dVec gVdotT = 0.0;
-
-            /* compute external potential derivatives */
-            gVe = externalPtr->gradV(path(bead1));
-            dVe = sqrt(dot(gVe,gVe));
-            g2Ve = externalPtr->grad2V(path(bead1));
-
-            gV += gVe;  // update full slice gradient at bead1
-
-            /* Sum potential of bead1 interacting with all other beads at
-             * a given time slice.*/
-            for (bead2[1] = 0; bead2[1] < numParticles; bead2[1]++) {
-
-                /* separation vector */
                 rDiff = path.getSeparation(bead1, bead2);
-                rmag = sqrt(dot(rDiff,rDiff));
-
-                /* Avoid self interactions */
-                if (!all(bead1==bead2)) {
-
-                    /* Compute interaction potential derivatives */
-                    gVi = interactionPtr->gradV(rDiff);
-                    dVi = sqrt(dot(gVi,gVi));
-                    g2Vi = interactionPtr->grad2V(rDiff);
-                    
-                    /* total derivatives between bead1 and bead2 at bead1 */
-                    dV = dVi + dVe;
-                    d2V = g2Vi + g2Ve;
-
-                    /* compute the T-matrix for bead1 interacting with bead2 */
+                gVi = interactionPtr->gradV(rDiff);
+                gV += gVi;
+
+                /* compute the T-matrix for bead1 interacting with bead2 */
+                if (correction) {
+                    rmag = sqrt(dot(rDiff,rDiff));
+                    dV = sqrt(dot(gVi,gVi)) + dVe;
+                    d2V = interactionPtr->grad2V(rDiff) + g2Ve;
                     for (int a=0; a<NDIM; a++){
                         for (int b=0; b<NDIM; b++){
                             tMat(a,b) += rDiff(a)*rDiff(b)*d2V/(rmag*rmag)
@@ -1375,57 +1289,22 @@ double LocalAction::deltadotgradUterm2(const int slice) {
                             if (a == b)
                                 tMat(a,b) += dV/rmag;
                         }
-                    }   // end T-matrix 
-                    
-                    gV += gVi;  // update full slice gradient at bead1
-
-                }   
-            }   // end bead2
+                    }
+                }
+            }
+        }   // end bead2
 
-            /* blitz++ product function seems broken in my current 
-             * version, so this performs matrix-vector mult. 
-             * Checked --MTG */
+        if (correction) {
             for(int j=0; j<NDIM; j++){
                 for(int i=0; i<NDIM; i++){
                     gVdotT(j) += gV(i)*tMat(j,i);
                 }
-            }  
-            
-            /* Compute deviation of bead from COM of worldline, 
-             * WITHOUT mirror image conv.*/
-            dVec runTotMore = 0.0;
-            dVec runTotLess = 0.0;
-            dVec COM = 0.0;
-            dVec pos1 = path(bead1);
-            beadNextOld = bead1;
-            beadPrevOld = bead1;
-            for (int gamma = 0; gamma < virialWindow; gamma++) {
-                // move along worldline to next (previous) bead
-                beadNext = path.next(bead1, gamma);
-                beadPrev = path.prev(bead1, gamma);
-                // keep running total of distance from first bead
-                // to the current beads of interest
-                runTotMore += path.getSeparation(beadNext, beadNextOld);
-                runTotLess += path.getSeparation(beadPrev, beadPrevOld);
-                // update center of mass of WL
-                COM += (pos1 + runTotMore) + (pos1 + runTotLess);
-                // store current bead locations
-                beadNextOld = beadNext;
-                beadPrevOld = beadPrev;
             }
-            COM /= (2.0*virialWindow);
-            delta = pos1 - COM; // end delta computation.
-           
-            path.boxPtr->putInBC(delta);
-
-            term2 += dot(gVdotT, delta);
-
-        }   // end bead1
-
-        term2 *= (2.0 * gradVFactor[eo] * pow(tau(),3) * constants()->lambda());
-    }
+        }
 
-    return (term2);
+        gU1(bead1[1]) = factor1*gV;
+        gU2(bead1[1]) = factor2*gVdotT;
+    }   // end bead1
 }
 
 /*************************************************************************//**
@@ -1631,9 +1510,6 @@ blitz::TinyVector<double,2> NonLocalAction::U(int slice) {
 
     int numParticles = path.numBeadsAtSlice(slice);
 
-    /* Initialize the separation histogram */
-    sepHist = 0;
-
     /* Calculate the total potential, including external and interaction
      * effects*/
     for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
@@ -1675,9 +1551,6 @@ double NonLocalAction::derivPotentialActionTau (int slice) {
 
     int numParticles = path.numBeadsAtSlice(slice);
 
-    /* Initialize the separation histogram */
-    sepHist = 0;
-
     /* Calculate the total potential, including external and interaction
      * effects*/
     for (bead1[1] = 0; bead1[1] < numParticles; bead1[1]++) {
@@ -1687,7 +1560,6 @@ double NonLocalAction::derivPotentialActionTau (int slice) {
 
         for (bead2[1] = bead1[1]+1; bead2[1] < numParticles; bead2[1]++) {
             sep = path.getSeparation(bead1,bead2);
-            updateSepHist(sep);
 
             /* Get the advanced neighbor of the second bead */
             nextBead2 = path.next(bead2);
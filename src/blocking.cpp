@@ -0,0 +1,223 @@
+/**
+ * @file blocking.cpp
+ *
+ * @brief BlockingAnalysis class implementation.
+ */
+
+#include "blocking.h"
+
+/** The fewest blocks at a level for its error to be trusted */
+#define MIN_BLOCKS 16
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// BLOCKING ANALYSIS CLASS ---------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  @param _numSeries The number of series analyzed together
+******************************************************************************/
+BlockingAnalysis::BlockingAnalysis(const int _numSeries) :
+    numSeries(_numSeries)
+{
+}
+
+/**************************************************************************//**
+ *  Add one value of every series.
+ *
+ *  The values are carried up through the levels for as long as each level
+ *  completes a pair.
+ *
+ *  @param x The new values
+******************************************************************************/
+void BlockingAnalysis::add(const blitz::Array<double,1> &x) {
+
+    PIMC_ASSERT(int(x.size()) == numSeries);
+
+    vector <double> value(numSeries);
+    for (int i = 0; i < numSeries; i++)
+        value[i] = x(i);
+    for (size_t k = 0; ; k++) {
+        if (k == level.size()) {
+            Level l;
+            l.n = 0;
+            l.sum.assign(numSeries,0.0);
+            l.sum2.assign(numSeries,0.0);
+            l.pending.assign(numSeries,0.0);
+            l.hasPending = false;
+            level.push_back(l);
+        }
+
+        Level &l = level[k];
+        l.n++;
+        for (int i = 0; i < numSeries; i++) {
+            l.sum[i] += value[i];
+            l.sum2[i] += value[i]*value[i];
+        }
+
+        if (!l.hasPending) {
+            l.pending = value;
+            l.hasPending = true;
+            break;
+        }
+
+        /* The pair is complete, and its average moves up a level */
+        for (int i = 0; i < numSeries; i++)
+            value[i] = 0.5*(l.pending[i] + value[i]);
+        l.hasPending = false;
+    }
+}
+
+/**************************************************************************//**
+ *  The mean of a series.
+ *
+ *  @param i The series
+******************************************************************************/
+double BlockingAnalysis::mean(const int i) const {
+    if (count() == 0)
+        return 0.0;
+    return level[0].sum[i]/level[0].n;
+}
+
+/**************************************************************************//**
+ *  The naive error of the mean, treating the blocks of a level as
+ *  independent.
+ *
+ *  @param i The series
+ *  @param k The level
+******************************************************************************/
+double BlockingAnalysis::levelError(const int i, const int k) const {
+
+    const Level &l = level[k];
+    if (l.n < 2)
+        return 0.0;
+
+    double ave = l.sum[i]/l.n;
+    double var = (l.sum2[i]/l.n - ave*ave) * l.n/(l.n - 1.0);
+    return sqrt(std::max(var,0.0)/l.n);
+}
+
+/**************************************************************************//**
+ *  The plateau level of a series.
+ *
+ *  This is the first level with enough blocks whose error is not exceeded by
+ *  that of the next level beyond its own uncertainty σ/sqrt(2(n-1)).  If
+ *  there is none the last level with enough blocks is used.
+ *
+ *  @param i The series
+ *  @param found Set to whether a plateau was found
+******************************************************************************/
+int BlockingAnalysis::plateau(const int i, bool &found) const {
+
+    found = false;
+    int k = 0;
+    while ((k+1 < int(level.size())) && (level[k+1].n >= MIN_BLOCKS)) {
+        double err = levelError(i,k);
+        double errErr = err/sqrt(2.0*(level[k].n - 1.0));
+        if (levelError(i,k+1) <= err + errErr) {
+            found = true;
+            return k;
+        }
+        k++;
+    }
+    return k;
+}
+
+/**************************************************************************//**
+ *  The error of the mean of a series at its plateau.
+ *
+ *  @param i The series
+******************************************************************************/
+double BlockingAnalysis::error(const int i) const {
+    if (count() < 2)
+        return 0.0;
+    bool found;
+    return levelError(i,plateau(i,found));
+}
+
+/**************************************************************************//**
+ *  The integrated autocorrelation time of a series.
+ *
+ *  τ_int = (σ_plateau/σ_0)^2 / 2, which is 1/2 for uncorrelated values.
+ *
+ *  @param i The series
+******************************************************************************/
+double BlockingAnalysis::tau(const int i) const {
+    double err0 = (count() < 2) ? 0.0 : levelError(i,0);
+    if (err0 <= 0.0)
+        return 0.5;
+    double err = error(i);
+    return 0.5*(err*err)/(err0*err0);
+}
+
+/**************************************************************************//**
+ *  Has the error of a series reached a plateau?
+ *
+ *  @param i The series
+******************************************************************************/
+bool BlockingAnalysis::converged(const int i) const {
+    if (count() < 2)
+        return false;
+    bool found;
+    plateau(i,found);
+    return found;
+}
+
+/**************************************************************************//**
+ *  Write the accumulators of every level on a single line.
+ *
+ *  The number of series and levels is followed by the count, pending flag,
+ *  sums, sums of squares and pending values of each level.
+ *
+ *  @param os The output stream
+******************************************************************************/
+void BlockingAnalysis::save(ostream &os) const {
+
+    os << numSeries << " " << level.size();
+    os << setprecision(17);
+    for (const auto &l : level) {
+        os << " " << l.n << " " << l.hasPending;
+        for (int i = 0; i < numSeries; i++)
+            os << " " << l.sum[i];
+        for (int i = 0; i < numSeries; i++)
+            os << " " << l.sum2[i];
+        for (int i = 0; i < numSeries; i++)
+            os << " " << l.pending[i];
+    }
+}
+
+/**************************************************************************//**
+ *  Read the accumulators written by save(), after the number of series.
+ *
+ *  @param is The input stream
+ *  @return false if the stream did not hold a complete set of levels
+******************************************************************************/
+bool BlockingAnalysis::load(istream &is) {
+
+    size_t numLevels;
+    if (!(is >> numLevels))
+        return false;
+
+    level.resize(numLevels);
+    for (auto &l : level) {
+        l.sum.assign(numSeries,0.0);
+        l.sum2.assign(numSeries,0.0);
+        l.pending.assign(numSeries,0.0);
+        is >> l.n >> l.hasPending;
+        for (int i = 0; i < numSeries; i++)
+            is >> l.sum[i];
+        for (int i = 0; i < numSeries; i++)
+            is >> l.sum2[i];
+        for (int i = 0; i < numSeries; i++)
+            is >> l.pending[i];
+    }
+
+    if (!is) {
+        level.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file collective.cpp
+ *
+ * @brief CollectiveDensity class implementation.
+ */
+
+#include "collective.h"
+#include "path.h"
+#include "threadpool.h"
+#include "fft.h"
+#include <numeric>
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// COLLECTIVE DENSITY CLASS --------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  Vector k of shell n (n > 0) is decomposed as n times the base vector
+ *  q/n, and equal base vectors are shared.  This is exact for any set of
+ *  q-vectors, but is only efficient when the shells are multiples of a
+ *  common set of directions, as for evenly spaced magnitudes.
+ *
+ *  If the sides of the box are given, the q-vectors are reciprocal lattice
+ *  vectors (2π/L_i)n_i, and are instead decomposed as gcd(n_i) times the
+ *  primitive vector in their direction.
+ *
+ *  @param q The q-vectors of each shell
+ *  @param side The sides of the box, or zero
+******************************************************************************/
+CollectiveDensity::CollectiveDensity(const vector< vector<dVec> > &q, const dVec &side) :
+    maxMultiple(0),
+    fftPtr(NULL)
+{
+    bool commensurate = blitz::all(side > EPS);
+
+    for (int nq = 0; nq < int(q.size()); nq++) {
+        qBase.push_back(vector<int>());
+        qMultiple.push_back(vector<int>());
+        for (const auto &cqvec : q[nq]) {
+            int multiple = std::max(nq,1);
+            if (commensurate) {
+                multiple = 0;
+                for (int i = 0; i < NDIM; i++)
+                    multiple = std::gcd(multiple,abs(int(round(cqvec[i]*side[i]/(2.0*M_PI)))));
+            }
+            addVector(cqvec,std::max(multiple,1));
+        }
+    }
+
+    /* There is always at least one base, holding the q = 0 mode */
+    if (base.empty())
+        base.push_back(dVec(0.0));
+}
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  Each q-vector is its own shell and its own base, as for an arbitrary
+ *  list of q-vectors which share no common directions.
+ *
+ *  @param q The q-vectors
+******************************************************************************/
+CollectiveDensity::CollectiveDensity(const vector<dVec> &q) :
+    maxMultiple(0),
+    fftPtr(NULL)
+{
+    for (const auto &cqvec : q) {
+        qBase.push_back(vector<int>());
+        qMultiple.push_back(vector<int>());
+        addVector(cqvec,1);
+    }
+
+    if (base.empty())
+        base.push_back(dVec(0.0));
+}
+
+/**************************************************************************//**
+ *  Add a q-vector to the last shell.
+ *
+ *  @param q The q-vector
+ *  @param multiple The multiple of the base vector q/multiple
+******************************************************************************/
+void CollectiveDensity::addVector(const dVec &q, const int multiple) {
+
+    /* The q = 0 mode is simply the number of beads */
+    if (sqrt(dot(q,q)) < EPS) {
+        qBase.back().push_back(0);
+        qMultiple.back().push_back(0);
+        return;
+    }
+
+    dVec b = q/(1.0*multiple);
+
+    int nb = 0;
+    while ((nb < int(base.size())) && (sqrt(dot(base[nb]-b,base[nb]-b)) > EPS))
+        nb++;
+    if (nb == int(base.size()))
+        base.push_back(b);
+
+    qBase.back().push_back(nb);
+    qMultiple.back().push_back(multiple);
+    maxMultiple = std::max(maxMultiple,multiple);
+}
+
+/**************************************************************************//**
+ *  Destructor.
+******************************************************************************/
+CollectiveDensity::~CollectiveDensity() {
+    delete fftPtr;
+}
+
+/**************************************************************************//**
+ *  Compute ρ_q at each time slice.
+ *
+ *  @param path The path
+ *  @param include Only beads whose position passes this filter contribute
+******************************************************************************/
+void CollectiveDensity::compute(const Path &path, const filter &include) {
+
+    int numTimeSlices = path.numTimeSlices;
+
+    /* Gather the positions of the included beads */
+    pos.resize(numTimeSlices);
+    beadLocator beadIndex;
+    for (beadIndex[0] = 0; beadIndex[0] < numTimeSlices; beadIndex[0]++) {
+        pos[beadIndex[0]].clear();
+        for (beadIndex[1] = 0; beadIndex[1] < path.numBeadsAtSlice(beadIndex[0]); beadIndex[1]++) {
+            const dVec &r = path(beadIndex);
+            if (!include || include(r))
+                pos[beadIndex[0]].push_back(r);
+        }
+    }
+
+    if ((rhoRe.extent(blitz::firstDim) != numTimeSlices) ||
+            (rhoRe.extent(blitz::secondDim) != int(base.size()))) {
+        rhoRe.resize(numTimeSlices,base.size(),maxMultiple+1);
+        rhoIm.resize(numTimeSlices,base.size(),maxMultiple+1);
+    }
+
+    threadPool()->parallelFor(0, base.size(), [this](const int nb) {computeBase(nb);});
+}
+
+/**************************************************************************//**
+ *  Compute ρ_q for all multiples of a single base vector.
+ *
+ *  The phase of each bead for the base vector is found once, and the
+ *  multiples follow from exp(i(m+1)b·r) = exp(imb·r) exp(ib·r).  The loops
+ *  over beads are kept free of dependencies so that they vectorize.
+ *
+ *  @param nb The base vector
+******************************************************************************/
+void CollectiveDensity::computeBase(const int nb) {
+
+    vector <double> baseCos, baseSin, phaseCos, phaseSin;
+
+    for (int slice = 0; slice < int(pos.size()); slice++) {
+
+        int numBeads = pos[slice].size();
+        baseCos.resize(numBeads);
+        baseSin.resize(numBeads);
+        phaseCos.assign(numBeads,1.0);
+        phaseSin.assign(numBeads,0.0);
+
+        for (int j = 0; j < numBeads; j++) {
+            double arg = dot(base[nb],pos[slice][j]);
+            baseCos[j] = cos(arg);
+            baseSin[j] = sin(arg);
+        }
+
+        rhoRe(slice,nb,0) = numBeads;
+        rhoIm(slice,nb,0) = 0.0;
+
+        for (int m = 1; m <= maxMultiple; m++) {
+            double *pc = phaseCos.data();
+            double *ps = phaseSin.data();
+            const double *bc = baseCos.data();
+            const double *bs = baseSin.data();
+            for (int j = 0; j < numBeads; j++) {
+                double c = pc[j]*bc[j] - ps[j]*bs[j];
+                double s = pc[j]*bs[j] + ps[j]*bc[j];
+                pc[j] = c;
+                ps[j] = s;
+            }
+
+            double sumCos = 0.0;
+            double sumSin = 0.0;
+            for (int j = 0; j < numBeads; j++) {
+                sumCos += pc[j];
+                sumSin += ps[j];
+            }
+            rhoRe(slice,nb,m) = sumCos;
+            rhoIm(slice,nb,m) = sumSin;
+        }
+    }
+}
+
+/**************************************************************************//**
+ *  The static structure factor of each shell.
+ *
+ *  @param sf Set to the sum of |ρ_q|^2 over all slices and the q-vectors of
+ *  each shell
+******************************************************************************/
+void CollectiveDensity::structureFactor(blitz::Array<double,1> &sf) const {
+
+    sf = 0.0;
+    for (int slice = 0; slice < numSlices(); slice++)
+        for (int nq = 0; nq < numShells(); nq++)
+            for (int k = 0; k < numVectors(nq); k++)
+                sf(nq) += re(slice,nq,k)*re(slice,nq,k) + im(slice,nq,k)*im(slice,nq,k);
+}
+
+/**************************************************************************//**
+ *  The imaginary time autocorrelation of ρ_q.
+ *
+ *  C(τ) = Σ_t Re[ρ_q(t) ρ_q*(t+τ)], periodic in τ, is the inverse transform
+ *  of the power spectrum |ρ_q(ω)|^2 divided by the number of slices.  The
+ *  spectra of the q-vectors are found by the thread pool and summed over
+ *  each shell in a fixed order, before a single inverse transform.
+ *
+ *  @param corr Set to the correlation of each shell (shell,τ)
+******************************************************************************/
+void CollectiveDensity::correlation(blitz::Array<double,2> &corr) {
+
+    int P = numSlices();
+    if (!fftPtr || (fftPtr->size() != P)) {
+        delete fftPtr;
+        fftPtr = new FFT(P);
+    }
+
+    /* Flatten the q-vectors of all shells */
+    vector < std::pair<int,int> > vec;
+    for (int nq = 0; nq < numShells(); nq++)
+        for (int k = 0; k < numVectors(nq); k++)
+            vec.push_back(std::make_pair(nq,k));
+
+    /* The power spectrum of each q-vector */
+    vector < vector<double> > power(vec.size());
+    threadPool()->parallelFor(0, vec.size(), [&](const int v) {
+        vector <FFT::complex> x(P);
+        for (int slice = 0; slice < P; slice++)
+            x[slice] = FFT::complex(re(slice,vec[v].first,vec[v].second),
+                    im(slice,vec[v].first,vec[v].second));
+        fftPtr->transform(x);
+
+        power[v].resize(P);
+        for (int w = 0; w < P; w++)
+            power[v][w] = std::norm(x[w]);
+    });
+
+    /* Sum the spectra of each shell and transform back */
+    corr = 0.0;
+    for (int nq = 0, v = 0; nq < numShells(); nq++) {
+        vector <FFT::complex> x(P,FFT::complex(0.0,0.0));
+        for (int k = 0; k < numVectors(nq); k++, v++)
+            for (int w = 0; w < P; w++)
+                x[w] += power[v][w];
+        fftPtr->transform(x,true);
+
+        for (int tau = 0; tau < P; tau++)
+            corr(nq,tau) = x[tau].real()/P;
+    }
+}
@@ -6,6 +6,12 @@
  */
 
 #include "communicator.h"
+#include "threadpool.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
 
 /* Filesystem is tricky as it is not yet widely supported.  We try to address
  * that here. */
@@ -131,12 +137,154 @@ void File::rename() {
     fs::rename(bakname.c_str(), name.c_str());
 }
 
+/**************************************************************************//**
+ *  Replace a file.
+ *  
+ *  The contents are written to the .bak file, optionally synced to disk, and
+ *  then renamed to .dat so that the primary file is never left partially
+ *  written.
+ *
+ *  @param contents The new contents of the file
+ *  @param sync Do we fsync the backup file before renaming it?
+******************************************************************************/
+void File::replace(const string &contents, const bool sync) {
+
+    close();
+
+    int fd = ::open(bakname.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "Unable to process file: " << bakname << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    /* Write the whole string, allowing for partial writes */
+    const char *data = contents.data();
+    size_t remaining = contents.size();
+    while (remaining > 0) {
+        ssize_t numWritten = ::write(fd, data, remaining);
+        if (numWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            cerr << "Unable to write file: " << bakname << endl;
+            exit(EXIT_FAILURE);
+        }
+        data += numWritten;
+        remaining -= numWritten;
+    }
+
+    if (sync && (::fsync(fd) != 0)) {
+        cerr << "Unable to sync file: " << bakname << endl;
+        exit(EXIT_FAILURE);
+    }
+    ::close(fd);
+
+    /* Perform the rename */
+    fs::rename(bakname.c_str(), name.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// STATE WRITER CLASS --------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  Start the I/O thread.
+ *
+ *  @param _sync Do we fsync state files before renaming them?
+******************************************************************************/
+StateWriter::StateWriter(const bool _sync) : 
+    sync(_sync),
+    numSubmitted(0),
+    numWritten(0),
+    stopping(false)
+{
+    writer = std::thread(&StateWriter::work, this);
+}
+
+/**************************************************************************//**
+ *  Destructor.
+ *
+ *  Finish all pending writes and stop the I/O thread.
+******************************************************************************/
+StateWriter::~StateWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        stopping = true;
+    }
+    submitted.notify_all();
+    writer.join();
+}
+
+/**************************************************************************//**
+ *  Queue a state string to be written to a file.
+ *
+ *  Neither the file nor the string may be touched by the caller until the
+ *  returned ticket has been waited for.
+ *
+ *  @param filePtr The state file
+ *  @param state The string to be written
+ *  @return The ticket of this write
+******************************************************************************/
+uint64_t StateWriter::submit(File *filePtr, const string *state) {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        queue.push_back(make_pair(filePtr,state));
+        ticket = ++numSubmitted;
+    }
+    submitted.notify_one();
+    return ticket;
+}
+
+/**************************************************************************//**
+ *  Wait until a submitted state, and all those before it, is on disk.
+ *
+ *  @param ticket The ticket returned by submit
+******************************************************************************/
+void StateWriter::wait(const uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    written.wait(lock, [&]{return numWritten >= ticket;});
+}
+
+/**************************************************************************//**
+ *  The writer loop.
+ *
+ *  States are written one at a time, in order, so that a checkpoint is 
+ *  only started once the previous one is durable.  Pending writes are 
+ *  finished before stopping.
+******************************************************************************/
+void StateWriter::work() {
+
+    threadPool()->unpin();
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (true) {
+        submitted.wait(lock, [&]{return stopping || !queue.empty();});
+        if (queue.empty())
+            break;
+
+        pair<File*,const string*> job = queue.front();
+        lock.unlock();
+        job.first->replace(*job.second,sync);
+        lock.lock();
+
+        queue.pop_front();
+        ++numWritten;
+        written.notify_all();
+    }
+}
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // COMMUNICATOR CLASS --------------------------------------------------------
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 
+thread_local Communicator* Communicator::replica_ = NULL;
+
 /**************************************************************************//**
  *  Initialize all input/output files.
  *  
@@ -149,7 +297,8 @@ void Communicator::init(double _tau, bool outputWorldline, string _initName,
 {
 
     /* Set local class variables */
-    baseDir = "OUTPUT"; 
+    if (baseDir.empty())
+        baseDir = "OUTPUT"; 
     initName = _initName;
     fixedName = _fixedName;
     tau = _tau;
@@ -172,7 +321,7 @@ void Communicator::init(double _tau, bool outputWorldline, string _initName,
     /* Check to make sure the correct directory structure for OUTPUT files is
      * in place. */ 
     fs::path outputPath(baseDir);
-    fs::create_directory(outputPath);
+    fs::create_directories(outputPath);
 
     /* If we have cylinder output files, add the required directory. */
     if (constants()->extPotentialType().find("tube") != string::npos) {
@@ -278,12 +427,459 @@ void Communicator::updateNames() {
         fs::rename(oldName.c_str(), filePtr->name.c_str());
     }
 }
+/**************************************************************************//**
+ * Close all files and remove the output directory with everything in it.
+ *
+ * Used by ensemble workers, whose bins are kept by the aggregator.
+******************************************************************************/
+void Communicator::discard() {
+    for (auto const& [key, filePtr] : file_)
+        filePtr->close();
+    fs::remove_all(baseDir);
+}
+
 /**************************************************************************//**
  *  This public method gets an instance of the Communicator object,  only one
  *  can ever exist at a time.
 ******************************************************************************/
 Communicator* Communicator::getInstance ()
 {   
+    if (replica_)
+        return replica_;
+
     static Communicator inst;
     return &inst;
 }
+
+/**************************************************************************//**
+ *  Bind a new, uninitialized communicator to the calling thread.
+ *
+ *  This allows replicas run in the same process to write to their own set of
+ *  files.  It must be initialized after the replica's constants are bound.
+******************************************************************************/
+Communicator* Communicator::bindReplica ()
+{   
+    replica_ = new Communicator();
+    return replica_;
+}
+
+/**************************************************************************//**
+ *  Release the communicator bound to the calling thread, closing its files.
+******************************************************************************/
+void Communicator::unbindReplica ()
+{   
+    delete replica_;
+    replica_ = NULL;
+}
+
+/**************************************************************************//**
+ *  Share the communicator of another thread with the calling thread.
+******************************************************************************/
+void Communicator::attach (Communicator *shared)
+{   
+    replica_ = shared;
+}
+
+/**************************************************************************//**
+ *  Stop sharing a communicator with another thread.
+******************************************************************************/
+void Communicator::detach ()
+{   
+    replica_ = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ENSEMBLE CHANNEL CLASS ----------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+EnsembleChannel* EnsembleChannel::instance_ = NULL;
+
+/**************************************************************************//**
+ *  Write a buffer to a pipe, allowing for partial writes.
+******************************************************************************/
+static void writeAll(const int fd, const void *buffer, size_t size) {
+    const char *data = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t numWritten = ::write(fd, data, size);
+        if (numWritten < 0) {
+            if (errno == EINTR)
+                continue;
+            cerr << "Unable to write to the ensemble aggregator." << endl;
+            exit(EXIT_FAILURE);
+        }
+        data += numWritten;
+        size -= numWritten;
+    }
+}
+
+/**************************************************************************//**
+ *  Read a buffer from a pipe, allowing for partial reads.
+ *
+ *  @return false if the pipe was closed
+******************************************************************************/
+static bool readAll(const int fd, void *buffer, size_t size) {
+    char *data = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t numRead = ::read(fd, data, size);
+        if (numRead < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (numRead == 0)
+            return false;
+        data += numRead;
+        size -= numRead;
+    }
+    return true;
+}
+
+/**************************************************************************//**
+ *  Read a length prefixed string from a pipe.
+******************************************************************************/
+static bool readString(const int fd, string &value) {
+    uint32_t length;
+    if (!readAll(fd, &length, sizeof(length)))
+        return false;
+    value.resize(length);
+    return (length == 0) || readAll(fd, &value[0], length);
+}
+
+/**************************************************************************//**
+ *  Open the channel of this process.
+ *
+ *  @param fd The write end of a pipe to the aggregator
+******************************************************************************/
+void EnsembleChannel::open(const int fd) {
+    instance_ = new EnsembleChannel(fd);
+}
+
+/**************************************************************************//**
+ *  Close the channel, signalling the aggregator that we are done.
+ *
+ *  The end of the stream is marked by an empty label.
+******************************************************************************/
+void EnsembleChannel::close() {
+    if (instance_) {
+        uint32_t length = 0;
+        writeAll(instance_->fd, &length, sizeof(length));
+        ::close(instance_->fd);
+        delete instance_;
+        instance_ = NULL;
+    }
+}
+
+/**************************************************************************//**
+ *  Add the bin of a single estimator.
+ *
+ *  Each message holds the file label, the header (only the first time) and
+ *  the values of the row.
+ *
+ *  @param label The output file label of the estimator
+ *  @param estHeader The header of the estimator
+ *  @param value The binned values
+ *  @param numValues The number of values
+ *  @param endLine Does this estimator complete the row?
+******************************************************************************/
+void EnsembleChannel::bin(const string &label, const string &estHeader, 
+        const double *value, const int numValues, const bool endLine) {
+
+    if (!sent.count(label))
+        header[label] += estHeader;
+    row[label].insert(row[label].end(), value, value + numValues);
+
+    if (!endLine)
+        return;
+
+    string rowHeader;
+    if (!sent.count(label)) {
+        rowHeader = header[label];
+        sent.insert(label);
+    }
+
+    uint32_t length = label.size();
+    writeAll(fd, &length, sizeof(length));
+    writeAll(fd, label.data(), length);
+    length = rowHeader.size();
+    writeAll(fd, &length, sizeof(length));
+    writeAll(fd, rowHeader.data(), length);
+    length = row[label].size();
+    writeAll(fd, &length, sizeof(length));
+    writeAll(fd, row[label].data(), length*sizeof(double));
+
+    row[label].clear();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ENSEMBLE AGGREGATOR CLASS -------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  @param _fd The read end of the pipe from each worker
+ *  @param _pid The process of each worker
+******************************************************************************/
+EnsembleAggregator::EnsembleAggregator(const vector<int> &_fd, const vector<pid_t> &_pid) :
+    fd(_fd),
+    pid(_pid),
+    alive(_fd.size(),true),
+    finished(_fd.size(),false),
+    numReceived(_fd.size(),0),
+    numMerged_(0),
+    numFailed_(0)
+{
+}
+
+/**************************************************************************//**
+ *  Merge bins until every worker has closed its pipe.
+******************************************************************************/
+void EnsembleAggregator::run() {
+
+    vector <pollfd> pfd(fd.size());
+    for (size_t w = 0; w < fd.size(); w++) {
+        pfd[w].fd = fd[w];
+        pfd[w].events = POLLIN;
+    }
+
+    size_t numOpen = fd.size();
+    while (numOpen > 0) {
+        if (poll(pfd.data(), pfd.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            cerr << "Unable to poll the ensemble workers." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        for (size_t w = 0; w < pfd.size(); w++) {
+            if ((pfd[w].fd >= 0) && (pfd[w].revents & (POLLIN|POLLHUP|POLLERR))) {
+                if (!receive(w)) {
+                    ::close(pfd[w].fd);
+                    pfd[w].fd = -1;
+                    numOpen--;
+                    reap(w);
+                }
+            }
+        }
+    }
+
+    /* Rows delivered by only a single worker have no error bar */
+    uint32 numUnmerged = 0;
+    for (auto &s : stream)
+        for (auto &r : s.second.ready)
+            numUnmerged += r.size();
+    if (numUnmerged > 0) {
+        string note = str(format("%d rows delivered by a single worker were not merged") 
+                % numUnmerged);
+        cerr << "WARNING: " << note << "." << endl;
+        event.push_back(note);
+    }
+
+    log();
+}
+
+/**************************************************************************//**
+ *  Reap a worker whose pipe has closed.
+ *
+ *  A worker which ended its stream takes part in the rows it delivered, and
+ *  the later rows are merged without it.  If it did not end its stream it
+ *  has died, and is dropped from all further merges.  Rows it has not yet
+ *  delivered are then merged over the survivors, which need to number at
+ *  least two.
+ *
+ *  @param w The worker
+******************************************************************************/
+void EnsembleAggregator::reap(const int w) {
+
+    int status = 0;
+    while ((waitpid(pid[w], &status, 0) < 0) && (errno == EINTR)) {}
+
+    if (finished[w]) {
+        for (auto &s : stream)
+            merge(s.first);
+        return;
+    }
+
+    alive[w] = false;
+    numFailed_++;
+
+    string cause = "closed its pipe";
+    if (WIFSIGNALED(status))
+        cause = str(format("was killed by signal %d") % WTERMSIG(status));
+    else if (WIFEXITED(status))
+        cause = str(format("exited with status %d") % WEXITSTATUS(status));
+    string note = str(format("Ensemble worker %d (pid %d) %s after %d rows; "
+            "merging the remaining rows over the survivors") % w % pid[w] % cause
+        % numReceived[w]);
+    cerr << "WARNING: " << note << "." << endl;
+    event.push_back(note);
+
+    int numAlive = std::count(alive.begin(), alive.end(), true);
+    if (numAlive < 2) {
+        log();
+        cerr << endl << "ERROR: Fewer than two ensemble workers survived." << endl << endl;
+        cerr << "Action: inspect the failed workers with ensemble_raw, and rerun." << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    for (auto &s : stream) {
+        if (!s.second.ready.empty())
+            s.second.ready[w].clear();
+        merge(s.first);
+    }
+}
+
+/**************************************************************************//**
+ *  Receive one row from a worker and merge it if possible.
+ *
+ *  @param w The worker
+ *  @return false once the worker has closed its pipe
+******************************************************************************/
+bool EnsembleAggregator::receive(const int w) {
+
+    string label,header;
+    uint32_t numValues;
+    if (!readString(fd[w], label))
+        return false;
+
+    /* The end of the stream */
+    if (label.empty()) {
+        finished[w] = true;
+        return false;
+    }
+
+    if (!readString(fd[w], header) || !readAll(fd[w], &numValues, sizeof(numValues)))
+        return false;
+
+    vector <double> value(numValues);
+    if ((numValues > 0) && !readAll(fd[w], value.data(), numValues*sizeof(double)))
+        return false;
+    numReceived[w]++;
+
+    Stream &cStream = stream[label];
+    if (cStream.sum.empty()) {
+        cStream.sum.resize(fd.size());
+        cStream.numBins.resize(fd.size(),0);
+        cStream.ready.resize(fd.size());
+    }
+    if (cStream.header.empty())
+        cStream.header = header;
+
+    /* Update the running average of this worker */
+    vector <double> &sum = cStream.sum[w];
+    sum.resize(numValues,0.0);
+    cStream.numBins[w]++;
+    vector <double> average(numValues);
+    for (uint32_t n = 0; n < numValues; n++) {
+        sum[n] += value[n];
+        average[n] = sum[n]/cStream.numBins[w];
+    }
+    cStream.ready[w].push_back(average);
+
+    merge(label);
+    return true;
+}
+
+/**************************************************************************//**
+ *  Write every row which all surviving workers have delivered.
+ *
+ *  A worker which has ended its stream only takes part in the rows it
+ *  delivered, so workers that stop after different numbers of bins (e.g. on
+ *  reaching a target error) do not hold back the others.  Each change in the
+ *  number of workers averaged is reported.  A row needs at least two
+ *  workers for its error bar.
+ *
+ *  @param label The output file label
+******************************************************************************/
+void EnsembleAggregator::merge(const string &label) {
+
+    Stream &cStream = stream[label];
+    string errLabel = label + "_err";
+
+    while (true) {
+
+        /* Wait for every worker still running, and skip those done */
+        vector <size_t> survivor;
+        for (size_t w = 0; w < fd.size(); w++) {
+            if (!alive[w])
+                continue;
+            if (!cStream.ready[w].empty())
+                survivor.push_back(w);
+            else if (!finished[w])
+                return;
+        }
+        size_t numWorkers = survivor.size();
+        if (numWorkers < 2)
+            return;
+
+        if ((cStream.numAveraged > 0) && (numWorkers != cStream.numAveraged)) {
+            string note = str(format("%s: averaging %d instead of %d workers from row %d") 
+                    % label % numWorkers % cStream.numAveraged % (cStream.numRows+1));
+            cerr << "WARNING: " << note << "." << endl;
+            event.push_back(note);
+        }
+        cStream.numAveraged = numWorkers;
+
+        /* Write the headers before the first row */
+        if (!communicate()->file(label)->prepared()) {
+            communicate()->file(label)->prepare();
+            communicate()->file(label)->stream() << cStream.header << endl;
+            communicate()->file(errLabel)->stream() << cStream.header << endl;
+        }
+
+        size_t numValues = cStream.ready[survivor.front()].front().size();
+        fstream &meanFile = communicate()->file(label)->stream();
+        fstream &errFile = communicate()->file(errLabel)->stream();
+        for (size_t n = 0; n < numValues; n++) {
+            double mean = 0.0;
+            for (size_t w : survivor)
+                mean += cStream.ready[w].front()[n];
+            mean /= numWorkers;
+
+            double var = 0.0;
+            for (size_t w : survivor)
+                var += pow(cStream.ready[w].front()[n] - mean, 2);
+            var /= (numWorkers - 1);
+
+            meanFile << format("%16.8E") % mean;
+            errFile << format("%16.8E") % sqrt(var/numWorkers);
+        }
+        meanFile << endl;
+        errFile << endl;
+
+        for (size_t w : survivor)
+            cStream.ready[w].pop_front();
+        cStream.numRows++;
+        numMerged_++;
+    }
+}
+
+/**************************************************************************//**
+ *  Record the fate of every worker and the rows merged in the log file.
+******************************************************************************/
+void EnsembleAggregator::log() {
+
+    fstream &logFile = communicate()->file("log")->stream();
+    logFile << endl;
+    logFile << "---------- Begin Ensemble Data -----------------" << endl;
+    logFile << endl;
+    for (size_t w = 0; w < fd.size(); w++) {
+        string fate = finished[w] ? "finished" : (alive[w] ? "running" : "died");
+        logFile << format("%-29s\t:\t%-8s\t(pid %d, %d rows)\n") 
+            % str(format("Worker %d") % w) % fate % pid[w] % numReceived[w];
+    }
+    logFile << endl;
+    logFile << format("%-29s\t:\t%d\n") % "Merged Rows" % numMerged_;
+    logFile << format("%-29s\t:\t%d\n") % "Failed Workers" % numFailed_;
+    logFile << endl;
+    for (const auto &note : event)
+        logFile << note << endl;
+    if (!event.empty())
+        logFile << endl;
+    logFile << "---------- End Ensemble Data -------------------" << endl;
+    logFile << endl;
+}
@@ -14,6 +14,8 @@
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 
+thread_local ConstantParameters* ConstantParameters::replica_ = NULL;
+
 /**************************************************************************//**
  *  An empty constructor which simply sets all constants to null.
 ******************************************************************************/
@@ -34,14 +36,12 @@ void ConstantParameters::initConstants(po::variables_map &params) {
     /* We use boost to generate a UUID for the simulation */
     if (params["restart"].empty()) {
 
-        id_ = boost::uuids::to_string(boost::uuids::random_generator()());
-
         /* Add a possible user specified label */
-        string label_ = params["label"].as<string>();
+        label_ = params["label"].as<string>();
         if (label_.length() > 12)
             label_ = label_.substr(0,12);
         
-        id_.replace(id_.end()-label_.length(),id_.end(),label_);
+        generateID();
         restart_ = false;
     }
     else {
@@ -81,6 +81,9 @@ void ConstantParameters::initConstants(po::variables_map &params) {
     /* Are we saving a state file every bin? */
     saveStateFiles_ = params["no_save_state"].empty();
 
+    /* Are state files synced to disk before they replace the last one? */
+    syncStateFiles_ = params["no_sync_state"].empty();
+
     /* Do we want variable length diagonal updates? */
     varUpdates_ = params["var_updates"].empty();
     
@@ -131,11 +134,19 @@ void ConstantParameters::initConstants(po::variables_map &params) {
 
     graphenelut3d_file_prefix_ = params["graphenelut3d_file_prefix"].as<string>();
     virialWindow_              = params["virial_window"].as<int>();
+    pairCorrelationBins_       = params["pair_correlation_bins"].as<int>();
+    pairCorrelationRadius_     = params["pair_correlation_radius"].as<double>();
+    obdmSeparations_           = params["obdm_separations"].as<int>();
+    targetError_               = params["target_error"].as<double>();
+    targetQuantity_            = params["target_quantity"].as<string>();
+    blocking_                  = !params["blocking"].empty() || (targetError_ > 0.0);
+    estimatorBudget_           = params["estimator_budget"].as<double>();
 
     if (!params["wavevector"].empty() && !params["wavevector_type"].empty()) { 
         wavevector_                = params["wavevector"].as<string>();
         wavevectorType_            = params["wavevector_type"].as<string>();
     }
+    scatteringBackend_ = params["scattering_backend"].as<string>();
     
     initialNumParticles_ = params["number_particles"].as<int>();
     numBroken_ = params["number_broken"].as<int>();
@@ -231,6 +242,74 @@ void ConstantParameters::initConstants(po::variables_map &params) {
 ******************************************************************************/
 ConstantParameters* ConstantParameters::getInstance ()
 {   
+    if (replica_)
+        return replica_;
+
     static ConstantParameters inst;
     return &inst;
 }
+
+/**************************************************************************//**
+ *  Bind an independent copy of the constants to the calling thread.
+ *
+ *  Each replica run in the same process is a distinct simulation, and is
+ *  given its own PIMCID.  Until unbindReplica() is called, constants() in
+ *  this thread refers to the copy, which may be freely modified.
+******************************************************************************/
+ConstantParameters* ConstantParameters::bindReplica ()
+{   
+    ConstantParameters *replica = new ConstantParameters(*getInstance());
+    replica->generateID();
+    replica_ = replica;
+    return replica_;
+}
+
+/**************************************************************************//**
+ *  Bind a copy of another thread's constants to the calling thread.
+ *
+ *  Used by short lived worker threads which need to modify some constants
+ *  (e.g. trial values of C0 or μ) without affecting the simulation they
+ *  belong to.  The copy keeps the PIMCID, and is released by unbindReplica().
+******************************************************************************/
+ConstantParameters* ConstantParameters::bindCopy (ConstantParameters *source)
+{   
+    replica_ = new ConstantParameters(*source);
+    return replica_;
+}
+
+/**************************************************************************//**
+ *  Release the constants bound to the calling thread.
+******************************************************************************/
+void ConstantParameters::unbindReplica ()
+{   
+    delete replica_;
+    replica_ = NULL;
+}
+
+/**************************************************************************//**
+ *  Share the constants of another thread with the calling thread.
+ *
+ *  Used by worker threads of a single simulation, which must see the same
+ *  constants as the thread that owns it.  The constants are not copied.
+******************************************************************************/
+void ConstantParameters::attach (ConstantParameters *shared)
+{   
+    replica_ = shared;
+}
+
+/**************************************************************************//**
+ *  Stop sharing constants with another thread.
+******************************************************************************/
+void ConstantParameters::detach ()
+{   
+    replica_ = NULL;
+}
+
+/**************************************************************************//**
+ *  Generate a new random UUID, ending with the user supplied label.
+******************************************************************************/
+void ConstantParameters::generateID ()
+{   
+    id_ = boost::uuids::to_string(boost::uuids::random_generator()());
+    id_.replace(id_.end()-label_.length(),id_.end(),label_);
+}
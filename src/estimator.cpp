@@ -11,6 +11,11 @@
 #include "potential.h"
 #include "communicator.h"
 #include "factory.h"
+#include "collective.h"
+#include "lookuptable.h"
+#include "threadpool.h"
+#include "observables.h"
+#include "blocking.h"
 
 /**************************************************************************//**
  * Setup the estimator factory.
@@ -76,13 +81,11 @@ REGISTER_ESTIMATOR("pigs velocity",VelocityEstimator);
 REGISTER_ESTIMATOR("pigs subregion occupation",SubregionOccupationEstimator);
 REGISTER_ESTIMATOR("pigs one body density matrix",PIGSOneBodyDensityMatrixEstimator);
 
-/* GPU accelerated estimators */
-#ifdef USE_GPU 
-    REGISTER_ESTIMATOR("intermediate scattering function gpu",IntermediateScatteringFunctionEstimatorGpu);
-    REGISTER_ESTIMATOR("elastic scattering gpu", ElasticScatteringEstimatorGpu);
-    REGISTER_ESTIMATOR("static structure factor gpu",StaticStructureFactorGPUEstimator);
-    REGISTER_ESTIMATOR("cylinder static structure factor gpu",CylinderStaticStructureFactorGPUEstimator);
-#endif
+/* GPU accelerated estimators, which fall back on the thread pool */
+REGISTER_ESTIMATOR("intermediate scattering function gpu",IntermediateScatteringFunctionEstimatorGpu);
+REGISTER_ESTIMATOR("elastic scattering gpu", ElasticScatteringEstimatorGpu);
+REGISTER_ESTIMATOR("static structure factor gpu",StaticStructureFactorGPUEstimator);
+REGISTER_ESTIMATOR("cylinder static structure factor gpu",CylinderStaticStructureFactorGPUEstimator);
 
 /**************************************************************************//**
  * Setup the estimator factory for multi path estimators.
@@ -137,8 +140,10 @@ EstimatorBase::EstimatorBase(const Path &_path, ActionBase *_actionPtr,
         const MTRand &_random, double _maxR, int _frequency, string _label) :
     path(_path),
     actionPtr(_actionPtr),
+    observables(NULL),
     random(_random),
     maxR(_maxR),
+    blocking(NULL),
     frequency(_frequency),
     label(_label),
     numSampled(0),
@@ -179,6 +184,7 @@ EstimatorBase::EstimatorBase(const Path &_path, ActionBase *_actionPtr,
 EstimatorBase::~EstimatorBase() { 
     estimator.free();
     norm.free();
+    delete blocking;
 }
 
 /**************************************************************************//**
@@ -292,6 +298,10 @@ void EstimatorBase::prepare() {
                 (*outFilePtr) << endl;
 
         }
+
+        /* The bins of scalar estimators may be blocked as they are output */
+        if (constants()->blocking() && !estIndex.empty() && !blocking)
+            blocking = new BlockingAnalysis(numEst);
     }
 }
 
@@ -332,10 +342,103 @@ void EstimatorBase::output() {
     if (endLine)
         (*outFilePtr) << endl;
 
+    /* Stream the bin to the aggregator of an ensemble */
+    if (ensembleChannel())
+        ensembleChannel()->bin(label,header,estimator.data(),numEst,endLine);
+
+    if (blocking)
+        blocking->add(estimator);
+
     /* Reset all values */
     reset();
 }
 
+/*************************************************************************//**
+ *  The blocking summary of each named quantity.
+ *
+ *  @return One line per quantity with the mean, error, integrated
+ *  autocorrelation time in bins, number of bins and whether the error has
+ *  converged, or nothing if we are not blocking.
+******************************************************************************/
+string EstimatorBase::summary() const {
+
+    string lines;
+    if (!blocking)
+        return lines;
+
+    vector <string> quantity(numEst);
+    for (const auto &cindex : estIndex)
+        quantity[cindex.second] = cindex.first;
+
+    for (int n = 0; n < numEst; n++)
+        lines += str(format("%-40s%16.8E%16.8E%16.4E%16d%16d\n") 
+                % (getName() + ":" + quantity[n]) % blocking->mean(n) % blocking->error(n)
+                % blocking->tau(n) % blocking->count() % blocking->converged(n));
+    return lines;
+}
+
+/*************************************************************************//**
+ *  The blocking error of a named quantity.
+ *
+ *  @param target The quantity as estimator:quantity
+ *  @param error Set to the error of its mean
+ *  @param converged Set to whether the error has converged
+ *  @return Is the quantity blocked by this estimator?
+******************************************************************************/
+bool EstimatorBase::blockingError(const string &target, double &error, bool &converged) const {
+
+    if (!blocking || (target.compare(0,getName().size()+1,getName() + ":") != 0))
+        return false;
+
+    auto index = estIndex.find(target.substr(getName().size()+1));
+    if (index == estIndex.end())
+        return false;
+
+    error = blocking->error(index->second);
+    converged = blocking->converged(index->second);
+    return true;
+}
+
+/*************************************************************************//**
+ *  Write the blocking accumulators on a single line of a state file.
+ *
+ *  A line holding only 0 stands for an estimator which is not blocked.
+******************************************************************************/
+void EstimatorBase::saveBlocking(ostream &os) const {
+    if (blocking)
+        blocking->save(os);
+    else
+        os << 0;
+    os << endl;
+}
+
+/*************************************************************************//**
+ *  Read the blocking accumulators from a state file.
+ *
+ *  This is called before the estimator is prepared.  The accumulators are
+ *  only kept if we are blocking and the number of quantities has not
+ *  changed, otherwise the line is skipped.
+******************************************************************************/
+void EstimatorBase::loadBlocking(istream &is) {
+
+    string line;
+    getline(is >> std::ws, line);
+    istringstream lineStream(line);
+
+    int numSeries = 0;
+    lineStream >> numSeries;
+    if ((numSeries != numEst) || !constants()->blocking() || estIndex.empty())
+        return;
+
+    BlockingAnalysis *restored = new BlockingAnalysis(numSeries);
+    if (restored->load(lineStream)) {
+        delete blocking;
+        blocking = restored;
+    }
+    else
+        delete restored;
+}
+
 /*************************************************************************//**
  *  Output a flat estimator value to disk.
  *
@@ -745,6 +848,11 @@ void EstimatorBase::getQVectorsNN(std::vector<dVec> &qValues) {
 *  (wavevector and wavevector_type command line arguments) return a
 *  list of q-vectors where scattering will be computed.
 *  
+*  The spherical q-vectors are snapped to the nearest reciprocal lattice
+*  vector (2π/L_i)n_i of the box, so that S(q) is unchanged by periodic
+*  images.  Duplicates are dropped, and each is put in the shell nearest to
+*  its magnitude.  The first vector of each shell stays along the z-axis.
+*  
 ******************************************************************************/
 vector <vector<dVec> > EstimatorBase::getQVectors2(double dq, double qMax, 
         int& numq, string qGeometry) {
@@ -813,6 +921,48 @@ vector <vector<dVec> > EstimatorBase::getQVectors2(double dq, double qMax,
         q.push_back(qvecs);
     } //q-mags
 
+    if (qGeometry == "sphere") {
+
+        dVec side = path.boxPtr->side;
+        vector <vector<dVec> > qSnapped(q.size());
+        vector <iVec> added;
+
+        /* The z-axis vectors are already commensurate, and head each shell */
+        for (int nq = 0; nq < int(q.size()); nq++) {
+            qSnapped[nq].push_back(q[nq].front());
+            iVec n;
+            for (int i = 0; i < NDIM; i++)
+                n[i] = int(round(q[nq].front()[i]*side[i]/(2.0*M_PI)));
+            added.push_back(n);
+        }
+
+        for (const auto &cq : q) {
+            for (const auto &cqvec : cq) {
+                iVec n;
+                dVec qd;
+                for (int i = 0; i < NDIM; i++) {
+                    n[i] = int(round(cqvec[i]*side[i]/(2.0*M_PI)));
+                    qd[i] = 2.0*M_PI*n[i]/side[i];
+                }
+
+                if (std::find_if(added.begin(),added.end(),[&n](const iVec &m)
+                            {return blitz::all(m == n);}) != added.end())
+                    continue;
+
+                int nq = int(round(sqrt(dot(qd,qd))/dq));
+                if (nq < int(qSnapped.size())) {
+                    qSnapped[nq].push_back(qd);
+                    added.push_back(n);
+                }
+            }
+        }
+
+        q = qSnapped;
+        numq = 0;
+        for (const auto &cq : q)
+            numq += cq.size();
+    }
+
     /* output */
     /* int totalNumQVecs = 0; */
     /* for (auto [nq,cq] : enumerate(q)) { */
@@ -954,15 +1104,9 @@ void EnergyEstimator::accumulate() {
      * may be multiple mixing and swaps, it doesn't matter as we always
      * just advance one time step at a time, as taken care of through the
      * linking arrays.  This has been checked! */
-    beadLocator beadIndex;
-    dVec vel;
-    for (int slice = startSlice; slice < endSlice; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-            beadIndex = slice,ptcl;
-            vel = path.getVelocity(beadIndex);
-            totK -= dot(vel,vel);
-        }
-    }
+    for (int slice = startSlice; slice < endSlice; slice++)
+        totK -= observables->linkSquared(slice);
+
     /* Normalize the accumulated link-action part */
     totK *= kinNorm;
 
@@ -972,10 +1116,10 @@ void EnergyEstimator::accumulate() {
     double t2 = 0.0;
 
     for (int slice = startSlice; slice < endDiagSlice; slice++) {
-        t1 += sliceFactor[slice]*actionPtr->derivPotentialActionLambda(slice);
-        t2 += sliceFactor[slice]*actionPtr->derivPotentialActionTau(slice);
+        t1 += sliceFactor[slice]*observables->derivPotentialActionLambda(slice);
+        t2 += sliceFactor[slice]*observables->derivPotentialActionTau(slice);
         if (!(slice % actionPtr->period))
-            totVop  += sliceFactor[slice]*actionPtr->potential(slice);
+            totVop  += sliceFactor[slice]*observables->potential(slice);
     }
 
     t1 *= constants()->lambda()/(constants()->tau()*numTimeSlices);
@@ -1114,26 +1258,12 @@ void VirialEnergyEstimator::accumulate() {
     double P2,P3;
     P2 = P3 = 0.0;
 
-    beadLocator bead1, beadNext, beadNextOld;
-    dVec vel1, vel2;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-            bead1 = slice,ptcl; // current bead
-            vel2 = path.getVelocity(bead1);
-            beadNextOld = bead1;
-            vel1 = 0.0;
-            /* get r_{current + window} - r_{current} */
-            for (int gamma = 1; gamma <= virialWindow; gamma++) {
-                beadNext = path.next(bead1, gamma);
-                vel1 += path.getSeparation(beadNext, beadNextOld);
-                beadNextOld = beadNext;
-            }
-            T2 -= dot(vel1,vel2);
+    /* The exchange term, and the deviation of every bead from its centroid */
+    T2 = centroidDeviations();
 
-            /* compute second term of thermodynamic estimator */
-            thermE -= dot(vel2,vel2);
-        }
-    }   
+    /* compute second term of thermodynamic estimator */
+    for (int slice = 0; slice < numTimeSlices; slice++)
+        thermE -= observables->linkSquared(slice);
     P2 = thermE;
     T2 *= exchangeNorm;
 
@@ -1145,17 +1275,23 @@ void VirialEnergyEstimator::accumulate() {
      * and the kinetic energy correction. */
     int eo;
     double T5 = 0.0;
+    beadLocator beadIndex;
     for (int slice = 0; slice < numTimeSlices; slice++) {
         eo = (slice % 2);
-        T3 += actionPtr->deltaDOTgradUterm1(slice);
-        T4 += actionPtr->deltaDOTgradUterm2(slice);
-        T5 += actionPtr->derivPotentialActionTau(slice);
+
+        /* The forces on the slice are found once for all of the terms */
+        actionPtr->virialForces(slice,gU1,gU2);
+        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
+            beadIndex = slice,ptcl;
+            T3 += dot(gU1(ptcl),delta(slice,ptcl));
+            T4 += dot(gU2(ptcl),delta(slice,ptcl));
+            P3 += dot(gU1(ptcl),path(beadIndex)) + dot(gU2(ptcl),path(beadIndex));
+        }
+
+        T5 += observables->derivPotentialActionTau(slice);
         virKinTerm += actionPtr->virKinCorr(slice);
         if (eo==0) 
-            totVop  += sum(actionPtr->potential(slice));
-
-        P3 += actionPtr->rDOTgradUterm1(slice)
-            + actionPtr->rDOTgradUterm2(slice);
+            totVop  += sum(observables->potential(slice));
     }
 
     P3 *= (1.0/(2.0*numTimeSlices));
@@ -1240,6 +1376,89 @@ void VirialEnergyEstimator::accumulate() {
     estimator(estIndex["P"]) += Pressure;
 }
 
+/*************************************************************************//**
+ *  Find the deviation of every bead from the centroid of its window and the
+ *  exchange term of the centroid virial energy.
+ *
+ *  Each worldline is walked once and unwrapped, and the centroid of the
+ *  virialWindow beads on either side of a bead is then updated by sliding
+ *  the window one link along the worldline.  This takes O(NP) work for any
+ *  size of window.
+ *
+ *  @return -Σ_j (r_{j+W} - r_j)·(r_{j+1} - r_j), to be normalized
+******************************************************************************/
+double VirialEnergyEstimator::centroidDeviations() {
+
+    int numTimeSlices = path.numTimeSlices;
+    int virialWindow = constants()->virialWindow();
+
+    int maxBeads = 0;
+    for (int slice = 0; slice < numTimeSlices; slice++)
+        maxBeads = std::max(maxBeads,path.numBeadsAtSlice(slice));
+
+    delta.resize(numTimeSlices,maxBeads);
+    doBead.resize(numTimeSlices,maxBeads);
+    doBead = true;
+
+    double exchange = 0.0;
+    beadLocator startBead,beadIndex;
+    for (int slice = 0; slice < numTimeSlices; slice++) {
+        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
+
+            /* We make sure we don't touch the same worldline twice */
+            if (!doBead(slice,ptcl))
+                continue;
+
+            /* Collect the beads and links of the worldline */
+            startBead = slice,ptcl;
+            beadIndex = startBead;
+            cycle.clear();
+            link.clear();
+            do {
+                doBead(beadIndex[0],beadIndex[1]) = false;
+                cycle.push_back(beadIndex);
+                link.push_back(path.getVelocity(beadIndex));
+                beadIndex = path.next(beadIndex);
+            } while (!all(beadIndex==startBead));
+            int wlLength = int(cycle.size());
+
+            /* Unwrap the worldline relative to its first bead, padded by the
+             * window on either side.  Bead j is stored at u[j+o]. */
+            int o = virialWindow - 1;
+            u.resize(wlLength + 2*virialWindow);
+            u[o] = 0.0;
+            for (int j = 0; j < wlLength + virialWindow; j++)
+                u[o+j+1] = u[o+j] + link[j % wlLength];
+            for (int j = 0; j > -o; j--)
+                u[o+j-1] = u[o+j] - link[((j-1) % wlLength + wlLength) % wlLength];
+
+            /* The forward and backward windows of the first bead */
+            dVec forward = 0.0;
+            dVec backward = 0.0;
+            for (int gamma = 0; gamma < virialWindow; gamma++) {
+                forward += u[o+gamma];
+                backward += u[o-gamma];
+            }
+
+            /* Slide both windows along the worldline */
+            for (int j = 0; j < wlLength; j++) {
+                dVec dj = u[o+j] - (forward + backward)/(2.0*virialWindow);
+                path.boxPtr->putInBC(dj);
+                delta(cycle[j][0],cycle[j][1]) = dj;
+
+                /* r_{j+W} - r_j dotted into the link leaving bead j */
+                dVec span = u[o+j+virialWindow] - u[o+j];
+                exchange -= dot(span,link[j]);
+
+                forward += span;
+                backward += u[o+j+1] - u[o+j+1-virialWindow];
+            }
+        } // ptcl
+    } // slice
+
+    return exchange;
+}
+
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // NUM PARTICLES ESTIMATOR CLASS ---------------------------------------------
@@ -1951,33 +2170,16 @@ SuperfluidFractionEstimator::~SuperfluidFractionEstimator() {
 ******************************************************************************/
 void SuperfluidFractionEstimator::accumulate() {
 
-    int numTimeSlices= path.numTimeSlices;
     double locW2oN = 0.0;
 
-    /* Sum up the winding number over all particles */
-    beadLocator beadIndex;
-    double Az, I;
-    dVec pos1,pos2;
-
-    Az = I = 0.0;
-    dVec W,vel;
-    W = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            /* The winding number estimator */
-            beadIndex = slice,ptcl;
-            vel = path.getVelocity(beadIndex);
-            W += vel;
-
-            /* The area estimator */
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
-            Az += pos1[0]*pos2[1]-pos2[0]*pos1[1];
-            I +=  pos1[0]*pos2[0] + pos1[1]*pos2[1];
+    /* The winding number and area estimators come from the shared sweep
+     * over all beads */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
+    double Az = wl.Az;
+    double I = wl.I;
 
-        }
-    }
+    dVec W;
+    W = observables->winding();
 
     /* Scale by the periodicity of the boundary conditions */
     W *= path.boxPtr->periodic;
@@ -2079,34 +2281,23 @@ PlaneWindingSuperfluidDensityEstimator::~PlaneWindingSuperfluidDensityEstimator(
 ******************************************************************************/
 void PlaneWindingSuperfluidDensityEstimator::accumulate() {
 
-    int numTimeSlices = path.numTimeSlices;
+    /* The links of every bead come from the shared sweep */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
 
-    beadLocator beadIndex;
-    double Wz;
-    dVec pos1,pos2;
-    dVec vel;
-
-    Wz = 0.0;
+    double Wz = 0.0;
     locWz = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            beadIndex = slice,ptcl;
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
+    for (int b = 0; b < wl.size(); b++) {
 
-            int i = static_cast<int>(abs(pos1[0] + 0.5*side[0] - EPS ) / (dx + EPS));
-            int j = static_cast<int>(abs(pos1[1] + 0.5*side[1] - EPS ) / (dy + EPS));
-            int k = 2*NGRIDSEP*j + i;
+        int i = static_cast<int>(abs(wl.x[b] + 0.5*side[0] - EPS ) / (dx + EPS));
+        int j = static_cast<int>(abs(wl.y[b] + 0.5*side[1] - EPS ) / (dy + EPS));
+        int k = 2*NGRIDSEP*j + i;
 
-            /* The winding number estimator */
-            vel = path.getVelocity(beadIndex)*path.boxPtr->periodic;
-            Wz += vel[NDIM-1];
+        /* The winding number estimator */
+        Wz += wl.linkZ[b];
 
-            /* The local part of the winding number */
-            if (k < numGrid)
-                locWz(k) += vel[NDIM-1];
-        }
+        /* The local part of the winding number */
+        if (k < numGrid)
+            locWz(k) += wl.linkZ[b];
     }
 
     estimator += locWz*Wz;
@@ -2168,40 +2359,25 @@ PlaneAreaSuperfluidDensityEstimator::~PlaneAreaSuperfluidDensityEstimator() {
 ******************************************************************************/
 void PlaneAreaSuperfluidDensityEstimator::accumulate() {
 
-    int numTimeSlices = path.numTimeSlices;
-
-    beadLocator beadIndex;
-    double tAz,Az,rp2;
-    dVec pos1,pos2;
+    /* The links of every bead come from the shared sweep */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
 
-    Az = 0.0;
+    double Az = wl.Az;
     locAz = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            beadIndex = slice,ptcl;
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
-
-            int i = static_cast<int>(abs(pos1[0] + 0.5*side[0] - EPS ) / (dx + EPS));
-            int j = static_cast<int>(abs(pos1[1] + 0.5*side[1] - EPS ) / (dy + EPS));
-            int k = 2*NGRIDSEP*j + i;
-
-            /*  The distance from the z-axis squared */
-            rp2 = pos1[0]*pos1[0] + pos1[1]*pos1[1];
-            if (rp2 < dx*dx)
-                rp2 = 0.25*dx*dx;
+    for (int b = 0; b < wl.size(); b++) {
 
-            /* The z-component of the area estimator */
-            tAz = pos1[0]*pos2[1] - pos2[0]*pos1[1];
+        int i = static_cast<int>(abs(wl.x[b] + 0.5*side[0] - EPS ) / (dx + EPS));
+        int j = static_cast<int>(abs(wl.y[b] + 0.5*side[1] - EPS ) / (dy + EPS));
+        int k = 2*NGRIDSEP*j + i;
 
-            /* The total area */
-            Az += tAz;
+        /*  The distance from the z-axis squared */
+        double rp2 = wl.x[b]*wl.x[b] + wl.y[b]*wl.y[b];
+        if (rp2 < dx*dx)
+            rp2 = 0.25*dx*dx;
 
-            /* The local part of the area */
-            if (k < numGrid)
-                locAz(k) += tAz/rp2;
-        }
+        /* The local part of the area */
+        if (k < numGrid)
+            locAz(k) += wl.area[b]/rp2;
     }
 
     estimator += locAz*Az;
@@ -2262,32 +2438,21 @@ RadialWindingSuperfluidDensityEstimator::~RadialWindingSuperfluidDensityEstimato
 ******************************************************************************/
 void RadialWindingSuperfluidDensityEstimator::accumulate() {
 
-    int numTimeSlices = path.numTimeSlices;
-
-    beadLocator beadIndex;
-    double Wz;
-    dVec pos1,pos2;
-    dVec vel;
+    /* The links of every bead come from the shared sweep */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
 
-    Wz = 0.0;
+    double Wz = 0.0;
     locWz = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            beadIndex = slice,ptcl;
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
+    for (int b = 0; b < wl.size(); b++) {
 
-            int k = int(sqrt(pos1[0]*pos1[0]+pos1[1]*pos1[1])/dR);
+        int k = int(sqrt(wl.x[b]*wl.x[b]+wl.y[b]*wl.y[b])/dR);
 
-            /* The winding number estimator */
-            vel = path.getVelocity(beadIndex)*path.boxPtr->periodic;
-            Wz += vel[NDIM-1];
+        /* The winding number estimator */
+        Wz += wl.linkZ[b];
 
-            /* The local part of the winding number */
-            if (k < numGrid)
-                locWz(k) += vel[NDIM-1];
-        }
+        /* The local part of the winding number */
+        if (k < numGrid)
+            locWz(k) += wl.linkZ[b];
     }
 
     estimator += locWz*Wz;
@@ -2348,34 +2513,19 @@ RadialAreaSuperfluidDensityEstimator::~RadialAreaSuperfluidDensityEstimator() {
 ******************************************************************************/
 void RadialAreaSuperfluidDensityEstimator::accumulate() {
 
-    int numTimeSlices = path.numTimeSlices;
-
-    beadLocator beadIndex;
-    double Az,rp2,tAz;
-    dVec pos1,pos2;
+    /* The links of every bead come from the shared sweep */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
 
-    Az = 0.0;
+    double Az = wl.Az;
     locAz = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            beadIndex = slice,ptcl;
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
-            rp2 = pos1[0]*pos1[0] + pos1[1]*pos1[1];
+    for (int b = 0; b < wl.size(); b++) {
 
-            int k = int(sqrt(rp2)/dR);
+        double rp2 = wl.x[b]*wl.x[b] + wl.y[b]*wl.y[b];
+        int k = int(sqrt(rp2)/dR);
 
-            /* The z-component of the area estimator */
-            tAz = pos1[0]*pos2[1] - pos2[0]*pos1[1];
-
-            /* The total area */
-            Az += tAz;
-
-            /* The local part of the winding number */
-            if (k < numGrid)
-                locAz(k) += tAz/rp2;
-        }
+        /* The local part of the area */
+        if (k < numGrid)
+            locAz(k) += wl.area[b]/rp2;
     }
 
     estimator += locAz*Az;
@@ -2473,49 +2623,33 @@ void LocalSuperfluidDensityEstimator::output() {
 ******************************************************************************/
 void LocalSuperfluidDensityEstimator::accumulate() {
 
-    int numTimeSlices = path.numTimeSlices;
     locAz = 0.0;
     locA2 = 0.0;
     locWz = 0.0;
 
-    beadLocator beadIndex;
-    double Az,rp2,Wz;
-    double tAz;
-    dVec pos1,pos2;
-    dVec vel;
-
-    Az = Wz = 0.0;
-    for (int slice = 0; slice < numTimeSlices; slice++) {
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-
-            beadIndex = slice,ptcl;
-            pos1 = path(beadIndex);
-            pos2 = path(path.next(beadIndex));
-            int n = path.boxPtr->gridIndex(pos1);
+    /* The links and grid cells of every bead come from the shared sweep */
+    const ObservablesCache::Worldlines &wl = observables->worldlines();
 
-            /*  The distance from the z-axis squared */
-            //rp2 = pos1[0]*pos1[0] + pos1[1]*pos1[1];
-            rp2 = pos1[0]*pos2[0] + pos1[1]*pos2[1];
-            if (abs(rp2) < dR*dR)
-                rp2 = dR*dR;
+    double Az = wl.Az;
+    double Wz = 0.0;
+    for (int b = 0; b < wl.size(); b++) {
 
-            /* The winding number estimator */
-            vel = path.getVelocity(beadIndex)*path.boxPtr->periodic;
-            Wz += vel[NDIM-1];
+        int n = wl.cell[b];
 
-            /* The local part of the winding number */
-            locWz(n) += vel[NDIM-1];
+        /*  The distance from the z-axis squared */
+        double rp2 = wl.inner[b];
+        if (abs(rp2) < dR*dR)
+            rp2 = dR*dR;
 
-            /* The z-component of the area estimator */
-            tAz = pos1[0]*pos2[1] - pos2[0]*pos1[1];
+        /* The winding number estimator */
+        Wz += wl.linkZ[b];
 
-            /* The total area */
-            Az += tAz;
+        /* The local part of the winding number */
+        locWz(n) += wl.linkZ[b];
 
-            /* The two local components */
-            locA2(n) += tAz; 
-            locAz(n) += tAz/rp2;
-        }
+        /* The two local components */
+        locA2(n) += wl.area[b];
+        locAz(n) += wl.area[b]/rp2;
     }
 
     locWz *= Wz;
@@ -2878,9 +3012,10 @@ void LocalPermutationEstimator::accumulate() {
 /*************************************************************************//**
  *  Constructor.
  * 
- *  The one body density matrix estimator is initialized.  We measure NOBDMSEP
- *  positions, out to the maximum separation in the sample (which may depend
- *  on the type of simulation cell).
+ *  The one body density matrix estimator is initialized.  We measure
+ *  obdm_separations positions (NOBDMSEP by default), out to the maximum
+ *  separation in the sample (which may depend on the type of simulation
+ *  cell).
 ******************************************************************************/
 OneBodyDensityMatrixEstimator::OneBodyDensityMatrixEstimator (Path &_path, 
         ActionBase *_actionPtr, const MTRand &_random, double _maxR, 
@@ -2892,15 +3027,16 @@ OneBodyDensityMatrixEstimator::OneBodyDensityMatrixEstimator (Path &_path,
     sqrt2LambdaTau = sqrt(2.0 * constants()->lambda() * constants()->tau());
 
     /* We chooose the maximum separation to be sqrt(NDIM)*min(L)/2 */
-    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*(blitz::min(path.boxPtr->side)) / (1.0*NOBDMSEP);
+    numSep = constants()->obdmSeparations();
+    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*(blitz::min(path.boxPtr->side)) / (1.0*numSep);
 
     /* This is an off-diagonal estimator*/
-    initialize(NOBDMSEP);
+    initialize(numSep);
     diagonal = false;
 
     /* The header is the first line which contains the spatial separations */
     header = str(format("#%15.3E") % 0.0);
-    for (int n = 1; n < NOBDMSEP; n++) 
+    for (int n = 1; n < numSep; n++) 
         header.append(str(format("%16.3E") % (n*dR)));
 
     numReps = 5;
@@ -3020,9 +3156,98 @@ dVec OneBodyDensityMatrixEstimator::newStagingPosition(const beadLocator &neighb
  *  a position a distance 'r' away from the tail but at the same time slice.
  *  The probability of excepting such a move is equal (up to normalization)
  *  to the one body density matrix.
+ *
+ *  The trial closures never touch the path.  Their random numbers are drawn
+ *  up front in the same order for every run, and each closure is then staged
+ *  in scratch space and its potential action found against the read-only
+ *  interaction grid, so that all numReps*numSep of them are evaluated at
+ *  once by the thread pool.  Actions which cannot be evaluated at a trial
+ *  position fall back on closing the path itself.
 ******************************************************************************/
 void OneBodyDensityMatrixEstimator::accumulate() {
 
+    if (!actionPtr->hasTrialPotentialAction() || constants()->spatialSubregionOn()) {
+        accumulateInPath();
+        return;
+    }
+
+    const beadLocator head = path.worm.head;
+    const beadLocator tail = path.worm.tail;
+    const int gap = path.worm.gap;
+    const int numTrials = numReps*numSep;
+    const int numKick = (gap-1)*NDIM;
+
+    oldTailPos = path(tail);
+    oldAction = actionPtr->potentialAction(tail);
+    double headAction = actionPtr->potentialAction(head);
+
+    /* action shift coming from a finite chemical potential */
+    double muShift = gap*constants()->mu()*constants()->tau();
+
+    /* Draw all random numbers serially */
+    trialTailPos.resize(numTrials);
+    trialKick.resize(numTrials*numKick);
+    trialUniform.resize(numTrials);
+    trialWeight.resize(numTrials);
+    for (int t = 0; t < numTrials; t++) {
+        trialTailPos[t] = oldTailPos + getRandomVector((t % numSep)*dR);
+        path.boxPtr->putInside(trialTailPos[t]);
+        for (int i = 0; i < numKick; i++)
+            trialKick[t*numKick + i] = random.randNorm(0.0,1.0);
+        trialUniform[t] = random.randExc();
+    }
+
+    /* Stage each closure from the head to its displaced tail */
+    threadPool()->parallelFor(0, numTrials, [&](const int t) {
+        vector <beadLocator> nnBead;
+        vector <dVec> nnSep;
+        beadLocator beadIndex;
+        dVec pos,sep;
+
+        double action = headAction;
+        pos = path(head);
+        for (int k = 0; k < (gap-1); k++) {
+
+            /* The rescaled value of lambda used for staging */
+            double f1 = 1.0 * (gap - k - 1);
+            double f2 = 1.0 / (1.0*(gap - k));
+            double sqrtLambdaKTau = sqrt2LambdaTau * sqrt(f1 * f2);
+
+            sep = trialTailPos[t] - pos;
+            path.boxPtr->putInBC(sep);
+            for (int i = 0; i < NDIM; i++)
+                pos[i] += f2*sep[i] + sqrtLambdaKTau*trialKick[t*numKick + k*NDIM + i];
+            path.boxPtr->putInside(pos);
+
+            beadIndex[0] = (head[0] + k + 1) % path.numTimeSlices;
+            beadIndex[1] = XXX;
+            action += actionPtr->trialPotentialAction(beadIndex,pos,nnBead,nnSep);
+        }
+        action += actionPtr->trialPotentialAction(tail,trialTailPos[t],nnBead,nnSep);
+
+        trialWeight[t] = actionPtr->rho0(path(head),trialTailPos[t],gap)
+            * exp(-action + oldAction + muShift);
+    });
+
+    for (int t = 0; t < numTrials; t++) {
+        estimator(t % numSep) += trialWeight[t];
+
+        /* Record the probability of accepting the move */
+        ++numAttempted;
+        if (trialUniform[t] < trialWeight[t])
+            ++numAccepted;
+    }
+}
+
+/*************************************************************************//**
+ *  Accumulate the OBDM by closing the worm in the path.
+ * 
+ *  The beads of each trial closure are added to the path and staged one
+ *  trial at a time, as required for actions which depend on more than a
+ *  single bead.
+******************************************************************************/
+void OneBodyDensityMatrixEstimator::accumulateInPath() {
+
     oldTailPos = lpath(lpath.worm.tail);
     oldAction = actionPtr->potentialAction(lpath.worm.tail);
 
@@ -3043,7 +3268,7 @@ void OneBodyDensityMatrixEstimator::accumulate() {
 
         /* Now we loop through all possible separations, evaluating the potential
          * action */
-        for (int n = 0; n < NOBDMSEP; n++) {
+        for (int n = 0; n < numSep; n++) {
 
             newAction = 0.0;
             ++numAttempted;
@@ -3119,9 +3344,9 @@ void OneBodyDensityMatrixEstimator::outputFooter() {
 /*************************************************************************//**
  *  Constructor.
  * 
- *  For the pair correlation function, we measure NPCFSEP positions to get
- *  high enough data density to observe possible osscilations.  The normalization
- *  depends on dimension.
+ *  For the pair correlation function, we measure pair_correlation_bins
+ *  positions (NPCFSEP by default) to get high enough data density to observe
+ *  possible osscilations.  The normalization depends on dimension.
 ******************************************************************************/
 PairCorrelationEstimator::PairCorrelationEstimator (const Path &_path, 
         ActionBase *_actionPtr, const MTRand &_random, double _maxR, 
@@ -3129,14 +3354,27 @@ PairCorrelationEstimator::PairCorrelationEstimator (const Path &_path,
     EstimatorBase(_path,_actionPtr,_random,_maxR,_frequency,_label) 
 {
     /* The spatial discretization */
-    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1] / (1.0*NPCFSEP);
+    numBins = constants()->pairCorrelationBins();
+    rMax = constants()->pairCorrelationRadius();
+    if (rMax <= 0.0)
+        rMax = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1];
+    dR = rMax / (1.0*numBins);
 
     /* This is a diagonal estimator that gets its own file */
-    initialize(NPCFSEP);
+    initialize(numBins);
+    pairHist.resize(numBins);
+
+    /* Beads closer than rMax lie in the same or neighboring grid boxes.  This
+     * only saves work if every side holds at least three boxes, otherwise all
+     * pairs are compared directly. */
+    cells = NULL;
+    if (3.0*rMax <= blitz::min(path.boxPtr->side))
+        cells = new LookupTable(path.boxPtr,constants()->numTimeSlices(),
+                path.getNumParticles(),rMax);
 
     /* The header is the first line which contains the spatial separations */
     header = str(format("#%15.3E") % 0.0);
-    for (int n = 1; n < NPCFSEP; n++) 
+    for (int n = 1; n < numBins; n++) 
         header.append(str(format("%16.3E") % ((n)*dR)));
 
     /* The normalization factor for the pair correlation function depends 
@@ -3146,13 +3384,13 @@ PairCorrelationEstimator::PairCorrelationEstimator (const Path &_path,
 //  gNorm[1] = 1.0/(4.0*M_PI);
 //  gNorm[2] = 1.0/(8.0*M_PI);
 //  norm(0) = 1.0;
-//  for (int n = 1; n < NPCFSEP; n++)
+//  for (int n = 1; n < numBins; n++)
 //      norm(n) = (gNorm[NDIM-1]*path.boxPtr->volume) / (dR*pow(n*dR,NDIM-1));
 
     /* The normalization factor for the pair correlation function depends 
      * on the dimensionality, and container type */
     if (path.boxPtr->name == "XXX") {
-        for (int n = 0; n < NPCFSEP; n++)
+        for (int n = 0; n < numBins; n++)
             norm(n) = 0.5*path.boxPtr->side[NDIM-1] / dR;
     }
     else {
@@ -3161,7 +3399,7 @@ PairCorrelationEstimator::PairCorrelationEstimator (const Path &_path,
         gNorm[1] = 1.0/(M_PI);
         gNorm[2] = 3.0/(2.0*M_PI);
         double dV;
-        for (int n = 0; n < NPCFSEP; n++) {
+        for (int n = 0; n < numBins; n++) {
             dV = pow((n+1)*dR,NDIM)-pow(n*dR,NDIM);
             norm(n) = 0.5*(gNorm[NDIM-1]*path.boxPtr->volume) / dV;
         }
@@ -3172,22 +3410,78 @@ PairCorrelationEstimator::PairCorrelationEstimator (const Path &_path,
  *  Destructor.
 ******************************************************************************/
 PairCorrelationEstimator::~PairCorrelationEstimator() { 
+    delete cells;
+    pairHist.free();
 }
 
 /*************************************************************************//**
- *  We simply update the local value of the esitimator with the value from
- *  our potential reference.  
+ *  Histogram the separations of all pairs of beads at each time slice,
+ *  normalized by the number of pairs.
+ *
+ *  When rMax is at most a third of the smallest side, each bead is only
+ *  compared with the beads in its own and neighboring grid boxes, which takes
+ *  O(N) work per slice at fixed density.  Otherwise all O(N^2) pairs are
+ *  compared.
  *
  *  We only compute this for N > 1.
 ******************************************************************************/
 void PairCorrelationEstimator::accumulate() {
     int numParticles = path.getTrueNumParticles();
+    if (numParticles < 2)
+        return;
+
+    /* Place all beads in the grid */
+    if (cells) {
+        if (path.getNumParticles() > cells->beadList.extent(blitz::firstDim))
+            cells->resizeList(path.getNumParticles());
+        cells->updateGrid(path);
+    }
+
+    pairHist = 0.0;
+    double numPairs = 0.0;
+
+    beadLocator bead1,bead2;
+    for (bead1[0] = 0; bead1[0] < path.numTimeSlices; bead1[0]++) {
+        int numBeads = path.numBeadsAtSlice(bead1[0]);
+        numPairs += 0.5*numBeads*(numBeads-1);
+        bead2[0] = bead1[0];
+
+        for (bead1[1] = 0; bead1[1] < numBeads; bead1[1]++) {
+
+            /* Each pair is counted once */
+            if (cells) {
+                cells->updateFullInteractionList(bead1,bead1[0]);
+                for (int n = 0; n < cells->fullNumBeads; n++) {
+                    bead2 = cells->fullBeadList(n);
+                    if (bead2[1] > bead1[1])
+                        binPair(bead1,bead2);
+                }
+            }
+            else {
+                for (bead2[1] = bead1[1]+1; bead2[1] < numBeads; bead2[1]++)
+                    binPair(bead1,bead2);
+            }
+        }
+    }
+
     double lnorm = 1.0*(numParticles-1)/(1.0*numParticles);
-    double tot = 1.0*sum(actionPtr->sepHist);
-    if ((numParticles > 1) && (tot > 0.0)) 
-        estimator += lnorm*(1.0*actionPtr->sepHist / tot );
-    else
-        estimator += 0.0;
+    if (numPairs > 0.0)
+        estimator += lnorm*pairHist/numPairs;
+}
+
+/*************************************************************************//**
+ *  Add the separation of a pair of beads to the histogram if it is smaller
+ *  than rMax.
+******************************************************************************/
+void PairCorrelationEstimator::binPair(const beadLocator &bead1, 
+        const beadLocator &bead2) {
+    dVec sep = path.getSeparation(bead1,bead2);
+    double r2 = dot(sep,sep);
+    if (r2 < rMax*rMax) {
+        int nR = int(sqrt(r2)/dR);
+        if (nR < numBins)
+            pairHist(nR) += 1.0;
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -3280,6 +3574,7 @@ StaticStructureFactorEstimator::StaticStructureFactorEstimator(
     /* Get the desired q-vectors */
     int numq = 0;
     q = getQVectors2(dq,qMax,numq,"sphere");
+    rho = new CollectiveDensity(q,path.boxPtr->side);
 
     /* Determine how many q-vector magnitudes  we have */
     numq = q.size();
@@ -3313,6 +3608,7 @@ StaticStructureFactorEstimator::StaticStructureFactorEstimator(
  *  Destructor.
 ******************************************************************************/
 StaticStructureFactorEstimator::~StaticStructureFactorEstimator() { 
+    delete rho;
     sf.free();
 }
 
@@ -3323,41 +3619,39 @@ StaticStructureFactorEstimator::~StaticStructureFactorEstimator() {
 void StaticStructureFactorEstimator::accumulate() {
 
     int numParticles = path.getTrueNumParticles();
-    int numTimeSlices = constants()->numTimeSlices();
 
-    beadLocator bead1,bead2;  // The bead locator
-    sf = 0.0; // initialize
+    /* S(q) = |ρ_q|^2/N, summed over the q-vectors of each magnitude */
+    rho->compute(path);
+    rho->structureFactor(sf);
 
-    /* q-magnitudes */
-    for (auto [nq,cq] : enumerate(q)) {
-
-        /* q-vectors with that q-magnitude*/
-        for (const auto &cqvec : cq) {
-    
-            /* Average over all time slices */
-            for (bead1[0] = 0; bead1[0] < numTimeSlices; bead1[0]++) {
-
-                /* This is an equal imaginary time estimator */
-                bead2[0] = bead1[0];
-
-                for (bead1[1] = 0; bead1[1] < path.numBeadsAtSlice(bead1[0]); bead1[1]++) {
+    estimator += sf/numParticles; 
+}
 
-                    /* The bead1 = bead2 part */
-                    sf(nq) += 1.0;
+/*************************************************************************//**
+ *  Do the scattering estimators run on a gpu?
+ *
+ *  The choice is set by the scattering_backend option: auto uses a gpu
+ *  whenever one is found, and the thread pool otherwise.
+******************************************************************************/
+static bool useScatteringDevice() {
 
-                    for (bead2[1] = bead1[1]+1; bead2[1] < path.numBeadsAtSlice(bead2[0]); bead2[1]++) {
-                        sf(nq) += 2*cos(dot(path.getSeparation(bead1,bead2),cqvec));
-                    } // bead2[1]
-                } // bead1[1]
-            } //bead1[0]
+    string backend = constants()->scatteringBackend();
+    if (backend == "cpu")
+        return false;
 
-        } // q-vectors
-    } // q-magnitudes
+    int numDevices = 0;
+#ifdef USE_GPU
+    gpu_device_count(numDevices);
+#endif
 
-    estimator += sf/numParticles; 
+    if ((backend == "gpu") && (numDevices < 1)) {
+        cerr << "\nERROR: No gpu was found for the scattering estimators." << endl
+             << "Action: set scattering_backend to auto or cpu." << endl;
+        exit(EXIT_FAILURE);
+    }
+    return (numDevices > 0);
 }
 
-#ifdef USE_GPU
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // STATIC STRUCTURE FACTOR GPU ESTIMATOR CLASS -------------------------------
@@ -3366,7 +3660,8 @@ void StaticStructureFactorEstimator::accumulate() {
 /*************************************************************************//**
  *  Constructor.
  * 
- *  A GPU accelerated static structure factor estimator.
+ *  A GPU accelerated static structure factor estimator.  Without a gpu the
+ *  collective density modes of each q-vector are found by the thread pool.
  *  
 ******************************************************************************/
 StaticStructureFactorGPUEstimator::StaticStructureFactorGPUEstimator(
@@ -3388,10 +3683,8 @@ StaticStructureFactorGPUEstimator::StaticStructureFactorGPUEstimator(
     ssf.resize(numq);
     ssf = 0.0;
 
-    // Create multiple gpu streams
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_create(stream_array[i]));
-    }
+    useDevice = useScatteringDevice();
+    rho = useDevice ? NULL : new CollectiveDensity(qValues);
 
     /* This is a diagonal estimator that gets its own file */
     initialize(numq);
@@ -3410,14 +3703,23 @@ StaticStructureFactorGPUEstimator::StaticStructureFactorGPUEstimator(
     /* utilize imaginary time translational symmetry */
     norm = 0.5/constants()->numTimeSlices();
 
-    bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
-    bytes_ssf = ssf.size()*sizeof(double);
-    bytes_qvecs = NDIM*numq*sizeof(double);
+#ifdef USE_GPU
+    if (useDevice) {
+        // Create multiple gpu streams
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_create(stream_array[i]));
+        }
 
-    gpu_malloc_device(double, d_ssf, ssf.size(), stream_array[0]);
-    gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
-    gpu_memcpy_host_to_device(d_qvecs, qValues.data(), bytes_qvecs, stream_array[0]);
-    gpu_wait(stream_array[0]);
+        bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
+        bytes_ssf = ssf.size()*sizeof(double);
+        bytes_qvecs = NDIM*numq*sizeof(double);
+
+        gpu_malloc_device(double, d_ssf, ssf.size(), stream_array[0]);
+        gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
+        gpu_memcpy_host_to_device(d_qvecs, qValues.data(), bytes_qvecs, stream_array[0]);
+        gpu_wait(stream_array[0]);
+    }
+#endif
 }
 
 /*************************************************************************//**
@@ -3425,15 +3727,20 @@ StaticStructureFactorGPUEstimator::StaticStructureFactorGPUEstimator(
 ******************************************************************************/
 StaticStructureFactorGPUEstimator::~StaticStructureFactorGPUEstimator() { 
     ssf.free();
+    delete rho;
 
-    // Release device memory
-    GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_ssf, stream_array[0]));
-    GPU_ASSERT(gpu_wait(stream_array[0]));
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+#ifdef USE_GPU
+    if (useDevice) {
+        // Release device memory
+        GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_ssf, stream_array[0]));
+        GPU_ASSERT(gpu_wait(stream_array[0]));
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        }
     }
+#endif
 }
 
 /*************************************************************************//**
@@ -3444,11 +3751,21 @@ StaticStructureFactorGPUEstimator::~StaticStructureFactorGPUEstimator() {
 void StaticStructureFactorGPUEstimator::accumulate() {
 
     int numParticles = path.getTrueNumParticles();
-    int numTimeSlices = constants()->numTimeSlices();
 
     /* Return to these and check if we need them */
     double _inorm = 1.0/numParticles;
 
+    /* 2|ρ_q|^2 summed over slices, as measured by the gpu kernel */
+    if (!useDevice) {
+        rho->compute(path);
+        rho->structureFactor(ssf);
+        estimator += 2.0*_inorm*ssf;
+        return;
+    }
+
+#ifdef USE_GPU
+    int numTimeSlices = constants()->numTimeSlices();
+
     /* We need to copy over the current beads array to the device */
     auto beads_extent = path.get_beads_extent();
     int full_number_of_beads = beads_extent[0]*beads_extent[1];
@@ -3477,9 +3794,8 @@ void StaticStructureFactorGPUEstimator::accumulate() {
     GPU_ASSERT(gpu_wait(stream_array[0]));
 
     estimator += ssf;
-
-}
 #endif
+}
 
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
@@ -3559,6 +3875,15 @@ IntermediateScatteringFunctionEstimator::IntermediateScatteringFunctionEstimator
     for (int nq = 0; nq < numq; nq++) 
         qMag(nq) = sqrt(dot(q[nq][0],q[nq][0]));
 
+    /* The collective density modes and their correlations.  The magnitudes
+     * are not multiples of a common one, so each q-vector is its own shell
+     * and the shells are summed when accumulating. */
+    vector <dVec> qvecs;
+    for (int nq = 0; nq < numq; nq++)
+        qvecs.insert(qvecs.end(),q[nq].begin(),q[nq].end());
+    rho = new CollectiveDensity(qvecs);
+    corr.resize(int(qvecs.size()),numTimeSlices);
+
     /* Initialize the accumulator for the intermediate scattering function*/
     /* N.B. for now we hard-code three wave-vectors */
     isf.resize(numq*numTimeSlices);
@@ -3591,6 +3916,8 @@ IntermediateScatteringFunctionEstimator::IntermediateScatteringFunctionEstimator
  *  Destructor.
 ******************************************************************************/
 IntermediateScatteringFunctionEstimator::~IntermediateScatteringFunctionEstimator() { 
+    delete rho;
+    corr.free();
 }
 
 /*************************************************************************//**
@@ -3604,46 +3931,19 @@ void IntermediateScatteringFunctionEstimator::accumulate() {
     int numParticles = path.getTrueNumParticles();
     int numTimeSlices = constants()->numTimeSlices();
 
-    beadLocator bead1,bead2;  // The bead locator
-    isf = 0.0; // initialize
-    dVec pos1,pos2;         // The two bead positions
-
-    /* q-magnitudes */
-    for (int nq = 0; nq < numq; nq++) {
-
-        /* q-vectors */
-        for (const auto &cqvec : q[nq]) {
+    /* F(q,τ) from the imaginary time autocorrelation of ρ_q */
+    rho->compute(path);
+    rho->correlation(corr);
 
-            /* Average over all initial time slices */
-            for (bead1[0] = 0; bead1[0] < numTimeSlices; bead1[0]++) {
-
-                /* compute for each tau separation */
-                for (int tausep = 0;  tausep < numTimeSlices; tausep++){
-
-                    bead2[0] = (bead1[0] + tausep) % numTimeSlices;
-
-                    for (bead1[1] = 0; bead1[1] < path.numBeadsAtSlice(bead1[0]); bead1[1]++) {
-
-                        pos1 = path(bead1);
-                        double lq1 = dot(cqvec,pos1);
-
-                        for (bead2[1] = 0; bead2[1] < path.numBeadsAtSlice(bead2[0]); bead2[1]++) {
-
-                            pos2 = path(bead2);
-                            double lq2 = dot(cqvec,pos2);
-
-                            isf(nq*numTimeSlices + tausep) += (cos(lq1)*cos(lq2) + sin(lq1)*sin(lq2))/numqVecs(nq);
-                        } // bead2[1]
-                    } // bead1[1]
-                } //tausep   
-            } //bead1[0]
-        } //q-vectors
-    } //q-magnitudes
+    isf = 0.0;
+    for (int nq = 0, v = 0; nq < numq; nq++)
+        for (int k = 0; k < numqVecs(nq); k++, v++)
+            for (int tausep = 0; tausep < numTimeSlices; tausep++)
+                isf(nq*numTimeSlices + tausep) += corr(v,tausep)/numqVecs(nq);
 
     estimator += isf/numParticles;
 }
 
-#ifdef USE_GPU
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // INTERMEDIATE SCATTERING FUNCTION GPU ESTIMATOR CLASS ----------------------
@@ -3685,10 +3985,10 @@ IntermediateScatteringFunctionEstimatorGpu::IntermediateScatteringFunctionEstima
     isf.resize(numq*(int(numTimeSlices/2) + 1));
     isf = 0.0;
 
-    // Create multiple gpu streams
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_create(stream_array[i]));
-    }
+    useDevice = useScatteringDevice();
+    rho = useDevice ? NULL : new CollectiveDensity(qValues);
+    if (!useDevice)
+        corr.resize(numq,numTimeSlices);
 
     /* This is a diagonal estimator that gets its own file */
     initialize(numq*(int(numTimeSlices/2) + 1));
@@ -3701,20 +4001,29 @@ IntermediateScatteringFunctionEstimatorGpu::IntermediateScatteringFunctionEstima
 
     /* The imaginary time values */
     header = str(format("#%15d") % 0);
-    for (unsigned int n = 1; n < isf.size(); n++) {
+    for (int n = 1; n < int(isf.size()); n++) {
         header.append(str(format("%16d") % n));
     }
     /* utilize imaginary time translational symmetry */
     norm = 0.5;
 
-    bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
-    bytes_isf = isf.size()*sizeof(double);
-    bytes_qvecs = NDIM*numq*sizeof(double);
+#ifdef USE_GPU
+    if (useDevice) {
+        // Create multiple gpu streams
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_create(stream_array[i]));
+        }
+
+        bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
+        bytes_isf = isf.size()*sizeof(double);
+        bytes_qvecs = NDIM*numq*sizeof(double);
 
-    gpu_malloc_device(double, d_isf, isf.size(), stream_array[0]);
-    gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
-    gpu_memcpy_host_to_device(d_qvecs, qValues_dVec.data(), bytes_qvecs, stream_array[0]);
-    gpu_wait(stream_array[0]);
+        gpu_malloc_device(double, d_isf, isf.size(), stream_array[0]);
+        gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
+        gpu_memcpy_host_to_device(d_qvecs, qValues_dVec.data(), bytes_qvecs, stream_array[0]);
+        gpu_wait(stream_array[0]);
+    }
+#endif
 }
 
 /*************************************************************************//**
@@ -3723,17 +4032,22 @@ IntermediateScatteringFunctionEstimatorGpu::IntermediateScatteringFunctionEstima
 IntermediateScatteringFunctionEstimatorGpu::~IntermediateScatteringFunctionEstimatorGpu() { 
     isf.free();
     qValues_dVec.free();
+    delete rho;
+    corr.free();
 
-    // Release device memory
-    GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_isf, stream_array[0]));
-    GPU_ASSERT(gpu_wait(stream_array[0]));
+#ifdef USE_GPU
+    if (useDevice) {
+        // Release device memory
+        GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_isf, stream_array[0]));
+        GPU_ASSERT(gpu_wait(stream_array[0]));
 
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        }
     }
-
+#endif
 }
 
 /*************************************************************************//**
@@ -3750,6 +4064,18 @@ void IntermediateScatteringFunctionEstimatorGpu::accumulate() {
 
     double _inorm = 1.0/number_of_beads;
 
+    /* F(q,τ) for τ up to β/2, as measured by the gpu kernel */
+    if (!useDevice) {
+        rho->compute(path);
+        rho->correlation(corr);
+        for (int nq = 0; nq < numq; nq++)
+            for (int tausep = 0; tausep <= numTimeSlices/2; tausep++)
+                isf(nq*(numTimeSlices/2 + 1) + tausep) = 2.0*_inorm*corr(nq,tausep);
+        estimator += isf;
+        return;
+    }
+
+#ifdef USE_GPU
     auto beads_extent = path.get_beads_extent();
     int full_number_of_beads = beads_extent[0]*beads_extent[1];
     int full_numParticles = beads_extent[1];
@@ -3778,11 +4104,9 @@ void IntermediateScatteringFunctionEstimatorGpu::accumulate() {
     GPU_ASSERT(gpu_wait(stream_array[0]));
 
     estimator += isf;
-
-}
 #endif
+}
 
-#ifdef USE_GPU
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // ELASTIC SCATTERING GPU ESTIMATOR CLASS ------------------------------------
@@ -3822,10 +4146,10 @@ ElasticScatteringEstimatorGpu::ElasticScatteringEstimatorGpu(
     es.resize(numq);
     es = 0.0;
 
-    // Create multiple gpu streams
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_create(stream_array[i]));
-    }
+    useDevice = useScatteringDevice();
+    rho = useDevice ? NULL : new CollectiveDensity(qValues);
+    if (!useDevice)
+        corr.resize(numq,numTimeSlices);
 
     /* This is a diagonal estimator that gets its own file */
     initialize(numq);
@@ -3838,20 +4162,29 @@ ElasticScatteringEstimatorGpu::ElasticScatteringEstimatorGpu(
 
     /* The imaginary time values */
     header = str(format("#%15d") % 0);
-    for (unsigned int n = 1; n < es.size(); n++) {
+    for (int n = 1; n < int(es.size()); n++) {
         header.append(str(format("%16d") % n));
     }
     /* utilize imaginary time translational symmetry */
     norm = 0.5;
 
-    bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
-    bytes_es = es.size()*sizeof(double);
-    bytes_qvecs = NDIM*numq*sizeof(double);
+#ifdef USE_GPU
+    if (useDevice) {
+        // Create multiple gpu streams
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_create(stream_array[i]));
+        }
+
+        bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
+        bytes_es = es.size()*sizeof(double);
+        bytes_qvecs = NDIM*numq*sizeof(double);
 
-    gpu_malloc_device(double, d_es, es.size(), stream_array[0]);
-    gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
-    gpu_memcpy_host_to_device(d_qvecs, qValues_dVec.data(), bytes_qvecs, stream_array[0]);
-    gpu_wait(stream_array[0]);
+        gpu_malloc_device(double, d_es, es.size(), stream_array[0]);
+        gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
+        gpu_memcpy_host_to_device(d_qvecs, qValues_dVec.data(), bytes_qvecs, stream_array[0]);
+        gpu_wait(stream_array[0]);
+    }
+#endif
 }
 
 /*************************************************************************//**
@@ -3860,16 +4193,22 @@ ElasticScatteringEstimatorGpu::ElasticScatteringEstimatorGpu(
 ElasticScatteringEstimatorGpu::~ElasticScatteringEstimatorGpu() { 
     es.free();
     qValues_dVec.free();
+    delete rho;
+    corr.free();
 
-    // Release device memory
-    GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_es, stream_array[0]));
-    GPU_ASSERT(gpu_wait(stream_array[0]));
+#ifdef USE_GPU
+    if (useDevice) {
+        // Release device memory
+        GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_es, stream_array[0]));
+        GPU_ASSERT(gpu_wait(stream_array[0]));
 
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        }
     }
+#endif
 }
 
 /*************************************************************************//**
@@ -3885,6 +4224,19 @@ void ElasticScatteringEstimatorGpu::accumulate() {
 
     double _inorm = 1.0/number_of_beads;
 
+    /* The sum of F(q,τ) for τ up to β/2, as measured by the gpu kernel */
+    if (!useDevice) {
+        rho->compute(path);
+        rho->correlation(corr);
+        es = 0.0;
+        for (int nq = 0; nq < numq; nq++)
+            for (int tausep = 0; tausep <= numTimeSlices/2; tausep++)
+                es(nq) += 2.0*_inorm*corr(nq,tausep);
+        estimator += es;
+        return;
+    }
+
+#ifdef USE_GPU
     auto beads_extent = path.get_beads_extent();
     int full_number_of_beads = beads_extent[0]*beads_extent[1];
     int full_numParticles = beads_extent[1];
@@ -3914,9 +4266,8 @@ void ElasticScatteringEstimatorGpu::accumulate() {
     GPU_ASSERT(gpu_wait(stream_array[0]));
 
     estimator += es;
-
-}
 #endif
+}
 
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
@@ -4425,9 +4776,10 @@ void CylinderSuperfluidFractionEstimator::accumulate() {
 /*************************************************************************//**
  *  Constructor.
  * 
- *  The one body density matrix estimator is initialized.  We measure NOBDMSEP
- *  positions, out to the maximum separation in the sample (which may depend
- *  on the type of simulation cell).
+ *  The one body density matrix estimator is initialized.  We measure
+ *  obdm_separations positions (NOBDMSEP by default), out to the maximum
+ *  separation in the sample (which may depend on the type of simulation
+ *  cell).
 ******************************************************************************/
 CylinderOneBodyDensityMatrixEstimator::CylinderOneBodyDensityMatrixEstimator 
   (Path &_path, ActionBase *_actionPtr, const MTRand &_random, double _maxR, 
@@ -4438,15 +4790,16 @@ CylinderOneBodyDensityMatrixEstimator::CylinderOneBodyDensityMatrixEstimator
     sqrt2LambdaTau = sqrt(2.0 * constants()->lambda() * constants()->tau());
 
     /* We chooose the maximum separation to be sqrt(NDIM)*L/2 */
-    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1] / (1.0*NOBDMSEP);
+    numSep = constants()->obdmSeparations();
+    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1] / (1.0*numSep);
 
     /* This is an off-diagonal estimator that gets its own file */
-    initialize(NOBDMSEP);
+    initialize(numSep);
     diagonal = false;
 
     /* The header is the first line which contains the spatial separations */
     header = str(format("#%15.3E") % 0.0);
-    for (int n = 1; n < NOBDMSEP; n++) 
+    for (int n = 1; n < numSep; n++) 
         header.append(str(format("%16.3E") % (n*dR)));
 
     numReps = 10;
@@ -4567,7 +4920,7 @@ void CylinderOneBodyDensityMatrixEstimator::accumulate() {
 
         /* Now we loop through all possible separations, evaluating the potential
          * action */
-        for (int n = 0; n < NOBDMSEP; n++) {
+        for (int n = 0; n < numSep; n++) {
 
             newAction = 0.0;
             ++numAttempted;
@@ -4632,9 +4985,9 @@ void CylinderOneBodyDensityMatrixEstimator::accumulate() {
 /*************************************************************************//**
  *  Constructor.
  * 
- *  For the pair correlation function, we measure NPCFSEP positions to get
- *  high enough data density to observe possible osscilations.  The normalization
- *  depends on dimension.
+ *  For the pair correlation function, we measure pair_correlation_bins
+ *  positions (NPCFSEP by default) to get high enough data density to observe
+ *  possible osscilations.  The normalization depends on dimension.
 ******************************************************************************/
 CylinderPairCorrelationEstimator::CylinderPairCorrelationEstimator (const Path &_path, 
         ActionBase *_actionPtr, const MTRand &_random, double _maxR, 
@@ -4642,14 +4995,19 @@ CylinderPairCorrelationEstimator::CylinderPairCorrelationEstimator (const Path &
     EstimatorBase(_path,_actionPtr,_random,_maxR,_frequency,_label) 
 {
     /* The spatial discretization */
-    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1] / (1.0*NPCFSEP);
+    numBins = constants()->pairCorrelationBins();
+    double rMax = constants()->pairCorrelationRadius();
+    if (rMax <= 0.0)
+        rMax = 0.5*sqrt(sum(path.boxPtr->periodic))*path.boxPtr->side[NDIM-1];
+    dR = rMax / (1.0*numBins);
 
     /* This is a diagonal estimator that gets its own file */
-    initialize(NPCFSEP);
+    initialize(numBins);
+    pairHist.resize(numBins);
 
     /* The header is the first line which contains the spatial separations */
     header = str(format("#%15.3E") % 0.0);
-    for (int n = 1; n < NPCFSEP; n++) 
+    for (int n = 1; n < numBins; n++) 
         header.append(str(format("%16.3E") % ((n)*dR)));
 
     /* The normalization factor for the pair correlation function */
@@ -4660,21 +5018,48 @@ CylinderPairCorrelationEstimator::CylinderPairCorrelationEstimator (const Path &
  *  Destructor.
 ******************************************************************************/
 CylinderPairCorrelationEstimator::~CylinderPairCorrelationEstimator() { 
+    pairHist.free();
 }
 
 /*************************************************************************//**
- *  We simply update the local value of the esitimator with the value from
- *  our potential reference.  
+ *  Histogram the separations along the axis of all pairs of beads inside
+ *  the cylinder at each time slice, normalized by the number of pairs.
  *
  *  We only compute this for N1D > 1.
 ******************************************************************************/
 void CylinderPairCorrelationEstimator::accumulate() {
     int N1D = num1DParticles(path,maxR);
-    if (N1D > 1) {
-        double lnorm = 1.0*sum(actionPtr->cylSepHist);
-        lnorm /= 1.0*(N1D-1)/(1.0*N1D);
-        estimator += 1.0*actionPtr->cylSepHist / (1.0*lnorm);
+    if (N1D < 2)
+        return;
+
+    pairHist = 0.0;
+    double numPairs = 0.0;
+
+    vector <beadLocator> inside;
+    beadLocator beadIndex;
+    for (beadIndex[0] = 0; beadIndex[0] < path.numTimeSlices; beadIndex[0]++) {
+
+        /* The beads inside the cylinder */
+        inside.clear();
+        for (beadIndex[1] = 0; beadIndex[1] < path.numBeadsAtSlice(beadIndex[0]); beadIndex[1]++) {
+            if (include(path(beadIndex),maxR))
+                inside.push_back(beadIndex);
+        }
+        numPairs += 0.5*inside.size()*(inside.size()-1);
+
+        for (size_t i = 0; i < inside.size(); i++) {
+            for (size_t j = i+1; j < inside.size(); j++) {
+                dVec sep = path.getSeparation(inside[i],inside[j]);
+                int nR = int(abs(sep[NDIM-1])/dR);
+                if (nR < numBins)
+                    pairHist(nR) += 1.0;
+            }
+        }
     }
+
+    double lnorm = 1.0*(N1D-1)/(1.0*N1D);
+    if (numPairs > 0.0)
+        estimator += lnorm*pairHist/numPairs;
 }
 
 /**************************************************************************//**
@@ -4686,7 +5071,7 @@ void CylinderPairCorrelationEstimator::accumulate() {
 void CylinderPairCorrelationEstimator::sample() {
     numSampled++;
 
-    if (baseSample() && (sum(actionPtr->cylSepHist) > 0)) {
+    if (baseSample() && (num1DParticles(path,maxR) > 1)) {
         totNumAccumulated++;
         numAccumulated++;
         accumulate();
@@ -5006,6 +5391,7 @@ CylinderStaticStructureFactorEstimator::CylinderStaticStructureFactorEstimator(
     /* Get the desired q-vectors */
     int numq = 0;
     q = getQVectors2(dq,qMax,numq,"line");
+    rho = new CollectiveDensity(q);
 
     /* Determine how many q-vector magnitudes  we have */
     numq = q.size();
@@ -5039,6 +5425,7 @@ CylinderStaticStructureFactorEstimator::CylinderStaticStructureFactorEstimator(
  *  Destructor.
 ******************************************************************************/
 CylinderStaticStructureFactorEstimator::~CylinderStaticStructureFactorEstimator() { 
+    delete rho;
     sf.free();
 }
 
@@ -5048,42 +5435,11 @@ CylinderStaticStructureFactorEstimator::~CylinderStaticStructureFactorEstimator(
 void CylinderStaticStructureFactorEstimator::accumulate() {
 
     int numParticles = num1DParticles(path,maxR);
-    int numTimeSlices = constants()->numTimeSlices();
-
-    beadLocator bead1,bead2;  // The bead locator
-    sf = 0.0; // initialize
-
-    /* q-magnitudes */
-    for (auto [nq,cq] : enumerate(q)) {
-
-        /* q-vectors with a fixed q-magnitude*/
-        for (const auto &cqvec : cq) {
-    
-            /* Average over all time slices */
-            for (bead1[0] = 0; bead1[0] < numTimeSlices; bead1[0]++) {
 
-                /* This is an equal imaginary time estimator */
-                bead2[0] = bead1[0];
-
-                for (bead1[1] = 0; bead1[1] < path.numBeadsAtSlice(bead1[0]); bead1[1]++) {
-
-                    if (include(path(bead1),maxR)) {
-                        /* The bead1 = bead2 part */
-                        sf(nq) += 1.0;
-
-                        for (bead2[1] = bead1[1]+1; bead2[1] < path.numBeadsAtSlice(bead2[0]); bead2[1]++) {
-
-                            if (include(path(bead2),maxR)) {
-                                sf(nq) += 2*cos(dot(path.getSeparation(bead1,bead2),cqvec));
-                            } //include bead2
-
-                        } // bead2[1]
-                    } //include bead1
-                } // bead1[1]
-            } //bead1[0]
-
-        } // q-vectors
-    } // q-magnitudes
+    /* Only beads inside the cylinder contribute to ρ_q */
+    double R = maxR;
+    rho->compute(path, [R](const dVec &r) {return include(r,R);});
+    rho->structureFactor(sf);
 
     estimator += sf/numParticles; 
 }
@@ -5104,7 +5460,6 @@ void CylinderStaticStructureFactorEstimator::sample() {
     }
 }
 
-#ifdef USE_GPU
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
 // STATIC STRUCTURE FACTOR CYL GPU ESTIMATOR CLASS ---------------------------
@@ -5135,10 +5490,8 @@ CylinderStaticStructureFactorGPUEstimator::CylinderStaticStructureFactorGPUEstim
     ssf.resize(numq);
     ssf = 0.0;
 
-    // Create multiple gpu streams
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_create(stream_array[i]));
-    }
+    useDevice = useScatteringDevice();
+    rho = useDevice ? NULL : new CollectiveDensity(qValues);
 
     /* This is a diagonal estimator that gets its own file */
     initialize(numq);
@@ -5157,14 +5510,23 @@ CylinderStaticStructureFactorGPUEstimator::CylinderStaticStructureFactorGPUEstim
     /* utilize imaginary time translational symmetry */
     norm = 0.5/constants()->numTimeSlices();
 
-    bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
-    bytes_ssf = ssf.size()*sizeof(double);
-    bytes_qvecs = NDIM*numq*sizeof(double);
+#ifdef USE_GPU
+    if (useDevice) {
+        // Create multiple gpu streams
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_create(stream_array[i]));
+        }
+
+        bytes_beads = NDIM*(1 + constants()->initialNumParticles())*sizeof(double);
+        bytes_ssf = ssf.size()*sizeof(double);
+        bytes_qvecs = NDIM*numq*sizeof(double);
 
-    gpu_malloc_device(double, d_ssf, ssf.size(), stream_array[0]);
-    gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
-    gpu_memcpy_host_to_device(d_qvecs, qValues.data(), bytes_qvecs, stream_array[0]);
-    gpu_wait(stream_array[0]);
+        gpu_malloc_device(double, d_ssf, ssf.size(), stream_array[0]);
+        gpu_malloc_device(double, d_qvecs, NDIM*numq, stream_array[0]);
+        gpu_memcpy_host_to_device(d_qvecs, qValues.data(), bytes_qvecs, stream_array[0]);
+        gpu_wait(stream_array[0]);
+    }
+#endif
 }
 
 /*************************************************************************//**
@@ -5172,15 +5534,20 @@ CylinderStaticStructureFactorGPUEstimator::CylinderStaticStructureFactorGPUEstim
 ******************************************************************************/
 CylinderStaticStructureFactorGPUEstimator::~CylinderStaticStructureFactorGPUEstimator() { 
     ssf.free();
+    delete rho;
 
-    // Release device memory
-    GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
-    GPU_ASSERT(gpu_free(d_ssf, stream_array[0]));
-    GPU_ASSERT(gpu_wait(stream_array[0]));
-    for (int i = 0; i < MAX_GPU_STREAMS; i++) {
-        GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+#ifdef USE_GPU
+    if (useDevice) {
+        // Release device memory
+        GPU_ASSERT(gpu_free(d_beads, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_qvecs, stream_array[0]));
+        GPU_ASSERT(gpu_free(d_ssf, stream_array[0]));
+        GPU_ASSERT(gpu_wait(stream_array[0]));
+        for (int i = 0; i < MAX_GPU_STREAMS; i++) {
+            GPU_ASSERT(gpu_stream_destroy(stream_array[i]));
+        }
     }
+#endif
 }
 
 /*************************************************************************//**
@@ -5191,11 +5558,22 @@ CylinderStaticStructureFactorGPUEstimator::~CylinderStaticStructureFactorGPUEsti
 void CylinderStaticStructureFactorGPUEstimator::accumulate() {
 
     int numParticles = path.getTrueNumParticles();
-    int numTimeSlices = constants()->numTimeSlices();
 
     /* Return to these and check if we need them */
     double _inorm = 1.0/numParticles;
 
+    /* Only beads inside the cylinder contribute to ρ_q */
+    if (!useDevice) {
+        double R = maxR;
+        rho->compute(path, [R](const dVec &r) {return include(r,R);});
+        rho->structureFactor(ssf);
+        estimator += 2.0*_inorm*ssf;
+        return;
+    }
+
+#ifdef USE_GPU
+    int numTimeSlices = constants()->numTimeSlices();
+
     /* We need to copy over the current beads array to the device */
     auto beads_extent = path.get_beads_extent();
     int full_number_of_beads = beads_extent[0]*beads_extent[1];
@@ -5224,7 +5602,7 @@ void CylinderStaticStructureFactorGPUEstimator::accumulate() {
     GPU_ASSERT(gpu_wait(stream_array[0]));
 
     estimator += ssf;
-
+#endif
 }
 
 /**************************************************************************//**
@@ -5242,7 +5620,6 @@ void CylinderStaticStructureFactorGPUEstimator::sample() {
         accumulate();
     }
 }
-#endif
 
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -5291,8 +5668,8 @@ void PotentialEnergyEstimator::accumulate() {
                     /path.boxPtr->volume)*actionPtr->interactionPtr->tailV;
     
     /* We use a simple operator estimator for V. */
-    for (int slice = 0; slice <= path.numTimeSlices; slice+=2)
-        estimator(slice/2) += sum(actionPtr->potential(slice)) + tailV;
+    for (int slice = 0; slice < path.numTimeSlices; slice+=2)
+        estimator(slice/2) += sum(observables->potential(slice)) + tailV;
 }
 
 // ---------------------------------------------------------------------------
@@ -5343,24 +5720,18 @@ void KineticEnergyEstimator::accumulate() {
      * including the chemical potential */
     double classicalKinetic = (0.5 * NDIM / constants()->tau()) * numParticles;
     
-    beadLocator beadIndex;
-    dVec vel,pos;
     for (int slice = 0; slice < (numTimeSlices-1); slice+=2) {
         double K = 0.0;
-        for (int eo = 0; eo < 2; eo++){
-            for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice+eo); ptcl++) {
-                beadIndex = slice+eo,ptcl;
-                vel = path.getVelocity(beadIndex);
-                K -= dot(vel,vel);
-            }
-        }
+        for (int eo = 0; eo < 2; eo++)
+            K -= observables->linkSquared(slice+eo);
+
         /* Normalize the accumulated link-action part */
         K *= kinNorm;
         
         /* Copmute the correction to the accumulated link-action part */
         double t1 = 0.0;
         for (int eo = 0; eo < 2; eo++){
-            t1 += actionPtr->derivPotentialActionLambda(slice+eo);
+            t1 += observables->derivPotentialActionLambda(slice+eo);
         }
 
         t1 *= constants()->lambda()/(2.0*constants()->tau());
@@ -5421,22 +5792,16 @@ void TotalEnergyEstimator::accumulate() {
      * including the chemical potential */
     double classicalKinetic = (0.5 * NDIM / constants()->tau()) * numParticles;
     
-    beadLocator beadIndex;
-    dVec vel,pos;
     for (int slice = 0; slice < (numTimeSlices-1); slice++) {
-        double K = 0.0;
-        for (int ptcl = 0; ptcl < path.numBeadsAtSlice(slice); ptcl++) {
-            beadIndex = slice,ptcl;
-            vel = path.getVelocity(beadIndex);
-            K -= dot(vel,vel);
-        }
+        double K = -observables->linkSquared(slice);
+
         /* Normalize the accumulated link-action part */
         K *= kinNorm;
         
         /* Perform all the normalizations and compute the individual energy terms */
         K  += (classicalKinetic);
         
-        double dUdtau = actionPtr->derivPotentialActionTau(slice);
+        double dUdtau = observables->derivPotentialActionTau(slice);
         estimator(slice) += K+dUdtau;
     }
 }
@@ -5483,8 +5848,8 @@ void ThermoPotentialEnergyEstimator::accumulate() {
     int numTimeSlices = constants()->numTimeSlices();
     
     for (int slice = 0; slice < (numTimeSlices-1); slice++) {        
-        double dUdtau = actionPtr->derivPotentialActionTau(slice);
-        double dUdlam = actionPtr->derivPotentialActionLambda(slice);
+        double dUdtau = observables->derivPotentialActionTau(slice);
+        double dUdlam = observables->derivPotentialActionLambda(slice);
         estimator(slice) += dUdtau - (constants()->lambda()/constants()->tau())*dUdlam;
     }
 }
@@ -5788,9 +6153,10 @@ void SubregionOccupationEstimator::accumulate() {
 /*************************************************************************//**
  *  Constructor.
  *
- *  The one body density matrix estimator is initialized.  We measure NOBDMSEP
- *  positions, out to the maximum separation in the sample (which may depend
- *  on the type of simulation cell).
+ *  The one body density matrix estimator is initialized.  We measure
+ *  obdm_separations positions (NOBDMSEP by default), out to the maximum
+ *  separation in the sample (which may depend on the type of simulation
+ *  cell).
 ******************************************************************************/
 PIGSOneBodyDensityMatrixEstimator::PIGSOneBodyDensityMatrixEstimator (Path &_path,
         ActionBase *_actionPtr, const MTRand &_random, double _maxR, 
@@ -5802,15 +6168,16 @@ PIGSOneBodyDensityMatrixEstimator::PIGSOneBodyDensityMatrixEstimator (Path &_pat
     sqrt2LambdaTau = sqrt(2.0 * constants()->lambda() * constants()->tau());
 
     /* We chooose the maximum separation to be sqrt(NDIM)*min(L)/2 */
-    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*(blitz::min(path.boxPtr->side)) / (1.0*NOBDMSEP);
+    numSep = constants()->obdmSeparations();
+    dR = 0.5*sqrt(sum(path.boxPtr->periodic))*(blitz::min(path.boxPtr->side)) / (1.0*numSep);
 
     /* This is an off-diagonal estimator*/
-    initialize(NOBDMSEP);
+    initialize(numSep);
     diagonal = false;
 
     /* The header is the first line which contains the spatial separations */
     header = str(format("#%15.3E") % 0.0);
-    for (int n = 1; n < NOBDMSEP; n++)
+    for (int n = 1; n < numSep; n++)
         header.append(str(format("%16.3E") % (n*dR)));
 
     numReps = 5;
@@ -5919,7 +6286,7 @@ void PIGSOneBodyDensityMatrixEstimator::accumulate() {
 
         /* Now we loop through all possible separations, evaluating the potential
          * action */
-        for (int n = 0; n < NOBDMSEP; n++) {
+        for (int n = 0; n < numSep; n++) {
 
             newAction = 0.0;
             ++numAttempted;
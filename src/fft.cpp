@@ -0,0 +1,129 @@
+/**
+ * @file fft.cpp
+ *
+ * @brief FFT class implementation.
+ */
+
+#include "fft.h"
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// FFT CLASS -----------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  @param _n The length of the transform
+******************************************************************************/
+FFT::FFT(const int _n) :
+    n(_n)
+{
+    PIMC_ASSERT(n > 0);
+
+    m = 1;
+    while (m < n)
+        m *= 2;
+    bluestein = (m != n);
+
+    /* Bluestein's algorithm needs a linear convolution of length 2n-1 */
+    if (bluestein) {
+        m = 1;
+        while (m < 2*n-1)
+            m *= 2;
+    }
+
+    twiddle.resize(m/2);
+    for (int k = 0; k < m/2; k++)
+        twiddle[k] = std::polar(1.0,-2.0*M_PI*k/m);
+
+    if (bluestein) {
+
+        /* j^2 is reduced mod 2n to keep the phase accurate */
+        chirp.resize(n);
+        for (int j = 0; j < n; j++) {
+            long long j2 = (1LL*j*j) % (2LL*n);
+            chirp[j] = std::polar(1.0,M_PI*j2/n);
+        }
+
+        chirpFT.assign(m,complex(0.0,0.0));
+        chirpFT[0] = chirp[0];
+        for (int j = 1; j < n; j++)
+            chirpFT[j] = chirpFT[m-j] = chirp[j];
+        radix2(chirpFT,false);
+    }
+}
+
+/**************************************************************************//**
+ *  The unnormalized discrete Fourier transform.
+ *
+ *  The forward transform is X_k = Σ_j x_j exp(-2πijk/n), and the inverse
+ *  uses exp(+2πijk/n), so that applying both multiplies by n.
+ *
+ *  @param x The data of length n, replaced by its transform
+ *  @param inverse Do we take the inverse transform?
+******************************************************************************/
+void FFT::transform(vector <complex> &x, const bool inverse) const {
+
+    PIMC_ASSERT(int(x.size()) == n);
+
+    if (!bluestein) {
+        radix2(x,inverse);
+        return;
+    }
+
+    /* The inverse is the conjugate of the forward transform of the conjugate */
+    if (inverse)
+        for (auto &c : x)
+            c = std::conj(c);
+
+    /* X_k = conj(w_k) Σ_j (x_j conj(w_j)) w_{k-j} with w_j = exp(iπj^2/n) */
+    vector <complex> a(m,complex(0.0,0.0));
+    for (int j = 0; j < n; j++)
+        a[j] = x[j]*std::conj(chirp[j]);
+
+    radix2(a,false);
+    for (int k = 0; k < m; k++)
+        a[k] *= chirpFT[k];
+    radix2(a,true);
+
+    for (int k = 0; k < n; k++)
+        x[k] = std::conj(chirp[k])*a[k]/double(m);
+
+    if (inverse)
+        for (auto &c : x)
+            c = std::conj(c);
+}
+
+/**************************************************************************//**
+ *  The in-place iterative radix-2 transform of length m.
+ *
+ *  @param x The data of length m
+ *  @param inverse Do we use the conjugate roots of unity?
+******************************************************************************/
+void FFT::radix2(vector <complex> &x, const bool inverse) const {
+
+    /* Bit reversal permutation */
+    for (int i = 1, j = 0; i < m; i++) {
+        int bit = m >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(x[i],x[j]);
+    }
+
+    for (int len = 2; len <= m; len *= 2) {
+        int stride = m/len;
+        for (int i = 0; i < m; i += len) {
+            for (int k = 0; k < len/2; k++) {
+                complex w = inverse ? std::conj(twiddle[k*stride]) : twiddle[k*stride];
+                complex u = x[i+k];
+                complex v = x[i+k+len/2]*w;
+                x[i+k] = u + v;
+                x[i+k+len/2] = u - v;
+            }
+        }
+    }
+}
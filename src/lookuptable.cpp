@@ -6,6 +6,7 @@
  */
 
 #include "lookuptable.h"
+#include "numa.h"
 #include "communicator.h"
 #include "path.h"
 
@@ -19,14 +20,16 @@
  * Initilialize the nearest neighbor lookup table.
  *
  * We partition the simulation cell into a grid of boxes whose edge length is
- * defined by the global potential cutoff radius rc.  All date structures 
- * are initialized to be empty.  We must call an updateBeads method externally
- * in order to place the worldlines in the lookup table.
+ * defined by the global potential cutoff radius rc, or a supplied cutoff.
+ * All date structures are initialized to be empty.  We must call an
+ * updateBeads method externally in order to place the worldlines in the
+ * lookup table.
 ******************************************************************************/
 LookupTable::LookupTable(const Container *_boxPtr, const int _numLookupTimeSlices, 
-        const int _numParticles) : 
+        const int _numParticles, const double _rc) : 
     boxPtr(_boxPtr),
-    numLookupTimeSlices(_numLookupTimeSlices)
+    numLookupTimeSlices(_numLookupTimeSlices),
+    rc((_rc > 0.0) ? _rc : constants()->rc())
 {
     /* Setup the nearest neighbor grid list */
     setupNNGrid();
@@ -41,6 +44,7 @@ LookupTable::LookupTable(const Container *_boxPtr, const int _numLookupTimeSlice
     /* Resize and initialize the main hash array */
     hash.resize(hashSize);
     hash = XXX;
+    numaArena()->place(hash,"lookup table hash");
 
     /* Resize and initialize the grid and bead label and list arrays */
     resizeList(_numParticles);
@@ -51,7 +55,7 @@ LookupTable::LookupTable(const Container *_boxPtr, const int _numLookupTimeSlice
     beadSep = 0.0;
 
     /* Initialize the cutoff^2 */
-    rc2 = constants()->rc2();
+    rc2 = rc*rc;
 }
 
 /**************************************************************************//**
@@ -63,12 +67,23 @@ LookupTable::~LookupTable() {
     beadList.free();
     fullBeadList.free();
     beadSep.free();
+    numaArena()->forget(&hash);
     hash.free();
     grid.free();
     beadLabel.free();
     numLabels.free();
 }
 
+/**************************************************************************//**
+ * Grow the hash array to the current hash size, preserving its contents.
+ *
+ * The new array is first touched, and so placed, by the calling thread.
+******************************************************************************/
+void LookupTable::resizeHash() {
+    hash.resizeAndPreserve(hashSize);
+    numaArena()->place(hash,"lookup table hash");
+}
+
 /**************************************************************************//**
  *  Setup the nearest neighbor grid and lookup tables that will be used
  *  to speed the evaluation of the potential.
@@ -79,7 +94,7 @@ void LookupTable::setupNNGrid() {
      * their size */
     totNumGridBoxes = 1;
     for (int i = 0; i < NDIM; i++) {
-        numNNGrid[i] = static_cast<int>(floor((boxPtr->side[i] / constants()->rc()) + EPS));
+        numNNGrid[i] = static_cast<int>(floor((boxPtr->side[i] / rc) + EPS));
 
         /* Make sure we have at least one grid box */
         if (numNNGrid[i] < 1)
@@ -301,7 +316,7 @@ void LookupTable::updateGrid(const blitz::Array <dVec,1> &fixedPos) {
          * grid box */
         if (hashSize[NDIM+1]==label) {
             hashSize[NDIM+1]++;
-            hash.resizeAndPreserve(hashSize);
+            resizeHash();
         }
 
         /* Update the hash table */
@@ -339,7 +354,7 @@ void LookupTable::updateGrid(const Path &path) {
                  * grid box */
                 if (hashSize[NDIM+1]==label) {
                     hashSize[NDIM+1]++;
-                    hash.resizeAndPreserve(hashSize);
+                    resizeHash();
                 }
 
                 /* Update the hash table */
@@ -387,7 +402,7 @@ void LookupTable::updateBead(const beadLocator &beadIndex, const dVec &pos) {
          * grid box */
         if (hashSize[NDIM+1]==label) {
             hashSize[NDIM+1]++;
-            hash.resizeAndPreserve(hashSize);
+            resizeHash();
         }
 
         /* Update the hash table */
@@ -420,7 +435,7 @@ void LookupTable::addBead(const beadLocator &beadIndex, const dVec &pos) {
      * grid box */
     if (hashSize[NDIM+1]==label) {
         hashSize[NDIM+1]++;
-        hash.resizeAndPreserve(hashSize);
+        resizeHash();
     }
 
     /* Update the hash table */
@@ -433,6 +448,39 @@ void LookupTable::addBead(const beadLocator &beadIndex, const dVec &pos) {
     numLabels(nI)++;
 }
 
+/**************************************************************************//**
+ *  Add a list of beads to the NN grid at the supplied positions.
+ *
+ *  We first assign all grid indices and labels, then grow the hash array at 
+ *  most once before filling it.
+******************************************************************************/
+void LookupTable::addBeads(const blitz::Array <beadLocator,1> &beadIndices, 
+        const blitz::Array <dVec,1> &pos, const int numBeads) {
+
+    /* Determine the grid box and label of each bead, keeping track of the
+     * largest number of labels needed in any box */
+    int maxNumLabels = 0;
+    for (int n = 0; n < numBeads; n++) {
+        grid(beadIndices(n)) = gridIndex(pos(n));
+        nI = numLabelIndex(beadIndices(n));
+        beadLabel(beadIndices(n)) = numLabels(nI);
+        numLabels(nI)++;
+        if (numLabels(nI) > maxNumLabels)
+            maxNumLabels = numLabels(nI);
+    }
+
+    /* We need to resize the hash array if we have too many beads in a single
+     * grid box */
+    if (maxNumLabels > hashSize[NDIM+1]) {
+        hashSize[NDIM+1] = maxNumLabels;
+        resizeHash();
+    }
+
+    /* Update the hash table */
+    for (int n = 0; n < numBeads; n++)
+        hash(hashIndex(beadIndices(n),beadLabel(beadIndices(n)))) = beadIndices(n)[1];
+}
+
 /**************************************************************************//**
  *  Remove a single bead from the NN grid.
 ******************************************************************************/
@@ -466,6 +514,31 @@ void LookupTable::delBead(const beadLocator &beadIndex) {
     numLabels(nI)--;
 }
 
+/**************************************************************************//**
+ *  Remove a list of beads from the NN grid.
+******************************************************************************/
+void LookupTable::delBeads(const blitz::Array <beadLocator,1> &beadIndices, 
+        const int numBeads) {
+    for (int n = 0; n < numBeads; n++)
+        delBead(beadIndices(n));
+}
+
+/**************************************************************************//**
+ *  Relabel a bead in the NN grid.
+ *
+ *  The bead keeps its grid box and label, so only its hash entry needs to 
+ *  point at the new index on the same slice.
+******************************************************************************/
+void LookupTable::moveBead(const beadLocator &oldIndex, const beadLocator &newIndex) {
+
+    grid(newIndex) = grid(oldIndex);
+    beadLabel(newIndex) = beadLabel(oldIndex);
+    hash(hashIndex(newIndex,beadLabel(newIndex))) = newIndex[1];
+
+    beadLabel(oldIndex) = XXX;
+    grid(oldIndex) = XXX;
+}
+
 /**************************************************************************//**
  *  Update the NN lookup table and the array of beadLocators containing
  *  all beads which 'interact' with the supplied bead1.
@@ -524,6 +597,127 @@ void LookupTable::updateInteractionList(const Path &path, const beadLocator &bea
     } // end n
 }
 
+/**************************************************************************//**
+ *  Update the interaction list for a bead placed at a trial position.
+ * 
+ *  The list is identical to the one we would obtain after moving bead1 to
+ *  pos, but neither the path nor the grid are modified.  This allows the 
+ *  action of a proposed configuration to be computed before it is accepted.
+ *  Any beads on the same slice which are themselves being moved are seen at
+ *  their current positions.
+******************************************************************************/
+void LookupTable::updateInteractionList(const Path &path, const beadLocator &bead1, 
+        const dVec &pos) {
+
+    dVec sep;
+
+    /* Reset the number of beads */
+    numBeads = 0;
+
+    /* Get the NDIM-vec coordiantes of the box where the trial position resides */
+    gIndex = gridIndex(pos);
+    for (int i = 0; i < NDIM; i++)
+        nnIndex[i] = gIndex[i];
+
+    /* We go through all the neighbouring grid boxes and assemble the 
+     * interaction list */
+    beadLocator bead2;
+    bead2[0] = bead1[0];
+    for (int n = 0; n < numNN; n++) {
+        nnIndex[NDIM] = n;
+
+        /* Get the grid index of the interacting box */
+        iVec nnGIndex;
+        nnGIndex = gridNN(nnIndex);
+
+        /* Make sure we don't access any illegal grid boxes */
+        if (!any(nnGIndex == -1)) {
+
+            int maxNL = numLabels(numLabelIndex(nnGIndex,bead1[0]));
+            hI = hashIndex(nnGIndex,bead1[0],0);
+
+            for (int label = 0; label < maxNL; label++) {
+
+                /* Get the interacting bead */
+                hI[NDIM+1] = label;
+                bead2[1] = hash(hI);
+
+                /* Eliminate self-interactions */
+                if (!all(bead1 == bead2)) {
+
+                    sep = path(bead2) - pos;
+                    boxPtr->putInBC(sep);
+
+                    /* If we are within the cutoff distance, add the bead to the list, 
+                     * and store their separation.*/
+                    if (dot(sep,sep) < rc2) {
+                        beadList(numBeads) = bead2;
+                        beadSep(numBeads) = sep;
+                        numBeads++;
+                    }
+                } // bead2 != bead1
+
+            } // label
+
+        }  // skip any illegal grid boxes
+
+    } // end n
+}
+
+/**************************************************************************//**
+ *  Find the interaction list of a bead placed at a trial position.
+ *
+ *  As above, but the list is written to the supplied buffers and the grid
+ *  is only read, so that many trial positions may be evaluated at once on
+ *  different threads.  The bead need not be in the grid.
+ *
+ *  @param path The path
+ *  @param bead1 The bead, which is excluded from the list
+ *  @param pos The trial position
+ *  @param nnBead Set to the beads within the cutoff
+ *  @param nnSep Set to their separations from pos
+******************************************************************************/
+void LookupTable::trialInteractionList(const Path &path, const beadLocator &bead1, 
+        const dVec &pos, vector <beadLocator> &nnBead, vector <dVec> &nnSep) {
+
+    nnBead.clear();
+    nnSep.clear();
+
+    iVec gI = gridIndex(pos);
+    blitz::TinyVector<int,NDIM+1> nnI;
+    for (int i = 0; i < NDIM; i++)
+        nnI[i] = gI[i];
+
+    beadLocator bead2;
+    bead2[0] = bead1[0];
+    for (int n = 0; n < numNN; n++) {
+        nnI[NDIM] = n;
+
+        iVec nnGIndex;
+        nnGIndex = gridNN(nnI);
+        if (any(nnGIndex == -1))
+            continue;
+
+        int maxNL = numLabels(numLabelIndex(nnGIndex,bead1[0]));
+        blitz::TinyVector<int,NDIM+2> hashI = hashIndex(nnGIndex,bead1[0],0);
+
+        for (int label = 0; label < maxNL; label++) {
+            hashI[NDIM+1] = label;
+            bead2[1] = hash(hashI);
+
+            if (all(bead1 == bead2))
+                continue;
+
+            dVec sep = path(bead2) - pos;
+            boxPtr->putInBC(sep);
+            if (dot(sep,sep) < rc2) {
+                nnBead.push_back(bead2);
+                nnSep.push_back(sep);
+            }
+        } // label
+    } // end n
+}
+
 /**************************************************************************//**
  *  Fill up the fullBeadList array with a list of beads in the same grid box
  *  as the supplied beadIndex and its nearest neighbors at the supplied time 
@@ -12,8 +12,8 @@
 #include "communicator.h"
 #include "factory.h"
 
-uint32 MoveBase::totAttempted = 0;
-uint32 MoveBase::totAccepted = 0;
+thread_local uint32 MoveBase::totAttempted = 0;
+thread_local uint32 MoveBase::totAccepted = 0;
 
 /**************************************************************************//**
  * Setup the move factory.
@@ -300,6 +300,25 @@ dVec MoveBase::newStagingPosition(const beadLocator &neighborIndex, const beadLo
         const int stageLength, const int k, iVec &wind) {
     
     PIMC_ASSERT(path.worm.beadOn(neighborIndex));
+
+    return newStagingPosition(path(neighborIndex),endIndex,stageLength,k,wind);
+}
+
+/*************************************************************************//**
+* Returns a new staging position which will exactly sample the kinetic
+* action in different winding sectors, given the position of the neighbor.
+*
+* This version does not require the neighbor to exist in the path, and is
+* used when generating a full segment before it is inserted.
+*
+* @param _neighborPos The position of the bead to be updated's neighbor
+* @param endIndex The index of the final bead in the stage
+* @param stageLength The length of the stage
+* @param k The position along the stage
+* @return A NDIM-vector which holds a new random position.
+******************************************************************************/
+dVec MoveBase::newStagingPosition(const dVec &_neighborPos, const beadLocator &endIndex,
+        const int stageLength, const int k, iVec &wind) {
     
     /* The rescaled value of lambda used for staging */
     double f1 = 1.0 * (stageLength - k - 1);
@@ -308,7 +327,7 @@ dVec MoveBase::newStagingPosition(const beadLocator &neighborIndex, const beadLo
     
     /* We find the new 'midpoint' position which exactly samples the kinetic 
      * density matrix */
-    neighborPos = path(neighborIndex);
+    neighborPos = _neighborPos;
     newRanPos = (path(endIndex)+path.boxPtr->side*wind)-neighborPos;
     newRanPos *= f2;
     newRanPos += neighborPos;
@@ -440,15 +459,133 @@ dVec MoveBase::newFreeParticlePosition(const beadLocator &neighborIndex) {
 
     PIMC_ASSERT(path.worm.beadOn(neighborIndex));
 
+    return newFreeParticlePosition(path(neighborIndex));
+}
+
+/*************************************************************************//**
+ * Returns a new bead position which samples the free particle density matrix
+ * given the position of a neighboring bead.
+ *
+ * @param _neighborPos the position of a neighboring bead
+ * @return A randomly generated position which exactly samples 1/2 the
+ * kinetic action.
+******************************************************************************/
+dVec MoveBase::newFreeParticlePosition(const dVec &_neighborPos) {
+
     /* The Gaussian distributed random position */
     for (int i = 0; i < NDIM; i++)
-        newRanPos[i] = random.randNorm(path(neighborIndex)[i],sqrt2LambdaTau);
+        newRanPos[i] = random.randNorm(_neighborPos[i],sqrt2LambdaTau);
 
     path.boxPtr->putInside(newRanPos);
 
     return newRanPos;
 }
 
+/*************************************************************************//**
+ * Compute the potential action of a trajectory with early rejection.
+ *
+ * The action is accumulated bead by bead.  As soon as the partial sum plus
+ * a lower bound on the action of the remaining beads exceeds maxAction, the
+ * trajectory can no longer be accepted and we stop.  If the action is not
+ * local in imaginary time, or no lower bound is known, the full action is
+ * computed.
+ *
+ * @param startBead The first bead of the trajectory
+ * @param endBead The last bead of the trajectory
+ * @param maxAction The largest action which could still lead to acceptance
+ * @param action The potential action (partial if we stopped early)
+ * @return false if the trajectory was rejected before the full action was
+ * computed
+******************************************************************************/
+bool MoveBase::boundedPotentialAction(const beadLocator &startBead, 
+        const beadLocator &endBead, const double maxAction, double &action) {
+
+    if (!actionPtr->local) {
+        action = actionPtr->potentialAction(startBead,endBead);
+        return true;
+    }
+
+    /* The lower bound on the action of the whole trajectory */
+    double remainingBound = 0.0;
+    beadLocator beadIndex;
+    beadIndex = startBead;
+    do {
+        double bound = actionPtr->potentialActionLowerBound(beadIndex);
+        if (bound <= -BIG) {
+            action = actionPtr->potentialAction(startBead,endBead);
+            return true;
+        }
+        remainingBound += bound;
+        beadIndex = path.next(beadIndex);
+    } while (!all(beadIndex==path.next(endBead)));
+
+    /* Accumulate the action, replacing the bound by the actual value one bead
+     * at a time.  The final decision is left to the caller's Metropolis test,
+     * and a small tolerance guards against round-off in the running bound. */
+    action = 0.0;
+    beadIndex = startBead;
+    do {
+        remainingBound -= actionPtr->potentialActionLowerBound(beadIndex);
+        action += actionPtr->potentialAction(beadIndex);
+        beadIndex = path.next(beadIndex);
+        if (all(beadIndex==path.next(endBead)))
+            break;
+        if ((action + remainingBound) > (maxAction + EPS))
+            return false;
+    } while (true);
+
+    return true;
+}
+
+/*************************************************************************//**
+ * Compute the potential action of a set of beads evaluated at trial
+ * positions, without touching the path or the lookup table.
+ *
+ * As for boundedPotentialAction(), the sum is abandoned as soon as the
+ * running action plus the lower bound of the remaining beads exceeds
+ * maxAction.  The beads must all lie on distinct time slices so that the
+ * action of each depends only on its own trial position.  The result is
+ * accumulated onto the incoming value of action.
+ *
+ * @param beads The beads to be moved
+ * @param pos Their trial positions
+ * @param numBeads The number of beads in the list
+ * @param maxAction The largest action which can still be accepted
+ * @param action The accumulated trial action
+ * @return false if the move is certain to be rejected
+******************************************************************************/
+bool MoveBase::boundedTrialPotentialAction(const blitz::Array <beadLocator,1> &beads,
+        const blitz::Array <dVec,1> &pos, const int numBeads, const double maxAction, 
+        double &action) {
+
+    /* The lower bound on the action of the remaining beads */
+    double remainingBound = 0.0;
+    bool bounded = true;
+    for (int n = 0; n < numBeads; n++) {
+        double bound = actionPtr->potentialActionLowerBound(beads(n));
+        if (bound <= -BIG) {
+            bounded = false;
+            break;
+        }
+        remainingBound += bound;
+    }
+
+    if (!bounded) {
+        for (int n = 0; n < numBeads; n++)
+            action += actionPtr->trialPotentialAction(beads(n),pos(n));
+        return true;
+    }
+
+    for (int n = 0; n < numBeads; n++) {
+        remainingBound -= actionPtr->potentialActionLowerBound(beads(n));
+        action += actionPtr->trialPotentialAction(beads(n),pos(n));
+        if ((n < numBeads-1) && ((action + remainingBound) > (maxAction + EPS)))
+            return false;
+    }
+
+    return true;
+}
+
 /*************************************************************************//**
  * Returns a new bisection position which will exactly sample the kinetic
  * action. 
@@ -1100,6 +1237,10 @@ CenterOfMassMove::CenterOfMassMove (Path &_path, ActionBase *_actionPtr,
     /* We setup the original position array which will store the shift
      * of a single particle at a time so it can be undone later */
     originalPos.resize(1);
+
+    /* Trial positions are generated for a whole worldline at once */
+    wlBeads.resize(constants()->numTimeSlices());
+    newPos.resize(constants()->numTimeSlices());
 }
 
 /*************************************************************************//**
@@ -1138,8 +1279,6 @@ bool CenterOfMassMove::attemptMove() {
     beadLocator firstBead;
     firstBead = startSlice,random.randInt(path.numBeadsAtSlice(startSlice)-1);
 
-    bool startSubregionA,startSubregionB,endSubregionA,endSubregionB;
-
     /* Now we traverse the path backwards, until we find 1 of two
      * possibilities, either we reach a null bead, or we wrap around */
     startBead = firstBead;
@@ -1168,9 +1307,11 @@ bool CenterOfMassMove::attemptMove() {
     beadLocator beadIndex;
 
     /* Make sure the worldline to be moved is shorter than the number of time
-     * slices */
+     * slices, storing its beads in a contiguous list as we go */
     beadIndex = startBead;
     do {
+        if (wlLength < wlBeads.extent(blitz::firstDim))
+            wlBeads(wlLength) = beadIndex;
         ++wlLength;
         beadIndex = path.next(beadIndex);
     } while (!all(beadIndex==path.next(endBead)));
@@ -1187,57 +1328,78 @@ bool CenterOfMassMove::attemptMove() {
     for (int i = 0; i < NDIM; i++) 
         originalPos(0)[i] = constants()->comDelta()*(-0.5 + random.rand());
 
+    /* Generate the proposed positions of all beads in the worldline */
+    for (int n = 0; n < wlLength; n++) {
+        newPos(n) = path(wlBeads(n)) + originalPos(0);
+        path.boxPtr->putInBC(newPos(n));
+    }
+
     /* Here we test to see if any beads are placed outside the box (if we
      * don't have periodic boundary conditions).  If that is the case,
      * we don't continue */
-    dVec pos;
     if (int(sum(path.boxPtr->periodic)) != NDIM) {
-        beadIndex = startBead;
-        do {
-            pos = path(beadIndex) + originalPos(0);
-            path.boxPtr->putInBC(pos);
+        for (int n = 0; n < wlLength; n++) {
             for (int i = 0; i < NDIM; i++) {
-                if ((pos[i] < -0.5*path.boxPtr->side[i]) || (pos[i] >= 0.5*path.boxPtr->side[i]))
+                if ((newPos(n)[i] < -0.5*path.boxPtr->side[i]) || (newPos(n)[i] >= 0.5*path.boxPtr->side[i]))
                     return false;
             }
-            beadIndex = path.next(beadIndex);
-        } while (!all(beadIndex==path.next(endBead)));
+        }
     }
 
     /* Determine the old potential action of the path */
      oldAction = actionPtr->potentialAction(startBead,endBead);
 
-    /* Go through the worldline and update the position of all the beads */
-    beadIndex = startBead;
+    /* If the action can be computed at trial positions, we evaluate the 
+     * proposed worldline from the scratch buffer, and only write it to the
+     * path and lookup table if the move is accepted */
+    if (actionPtr->hasTrialPotentialAction() && !constants()->spatialSubregionOn()) {
+
+        double x = random.rand();
+        newAction = 0.0;
+        if (boundedTrialPotentialAction(wlBeads,newPos,wlLength,oldAction - log(x),newAction)
+                && (x < exp(-(newAction - oldAction))))  {
+            for (int n = 0; n < wlLength; n++)
+                path.updateBead(wlBeads(n),newPos(n));
+            keepMove();
+            checkMove(1,newAction-oldAction);
+        }
+        else {
+            success = false;
+            checkMove(2,0.0);
+        }
+        return success;
+    }
+
+    /* Otherwise, go through the worldline and update the position of all the beads */
+    bool startSubregionA,startSubregionB,endSubregionA,endSubregionB;
     startSubregionA = false;
     startSubregionB = false;
     endSubregionA = false;
     endSubregionB = false;
-    do {
+    for (int n = 0; n < wlLength; n++) {
+        beadIndex = wlBeads(n);
+
         /* Check if bead is in subregion A or B */
         if ((constants()->spatialSubregionOn())&&(!(startSubregionA||startSubregionB))){
             startSubregionA = path.inSubregionA(beadIndex);
             startSubregionB = path.inSubregionB(beadIndex);
         }
-        pos = path(beadIndex) + originalPos(0);
-        path.boxPtr->putInBC(pos);
-        path.updateBead(beadIndex,pos);
+        path.updateBead(beadIndex,newPos(n));
         if ((constants()->spatialSubregionOn())&&(!(endSubregionA||endSubregionB))){
             endSubregionA = path.inSubregionA(beadIndex);
             endSubregionB = path.inSubregionB(beadIndex);
         }
-        beadIndex = path.next(beadIndex);
-    } while (!all(beadIndex==path.next(endBead)));
+    }
     
     if ( (startSubregionA && endSubregionB)|| (startSubregionB && endSubregionA) ){
         undoMove();
         checkMove(2,0.0);
     } else{
-        /* Get the new potential action of the path */
-        newAction = actionPtr->potentialAction(startBead,endBead);
-
-        /* The metropolis acceptance step */
-        if (random.rand() < exp(-(newAction - oldAction)))  {
+        /* Get the new potential action of the path, stopping as soon as
+         * the metropolis test can no longer be passed */
+        double x = random.rand();
+        if (boundedPotentialAction(startBead,endBead,oldAction - log(x),newAction) 
+                && (x < exp(-(newAction - oldAction))))  {
             keepMove();
             checkMove(1,newAction-oldAction);
         }
@@ -1289,6 +1451,10 @@ StagingMove::StagingMove (Path &_path, ActionBase *_actionPtr,
 
     /* The maximum length of a staging move */
     stageLength = constants()->Mbar();
+
+    /* Scratch space for the trial stage */
+    newPos.resize(constants()->Mbar());
+    stageBeads.resize(constants()->Mbar());
 }
 
 /*************************************************************************//**
@@ -1361,6 +1527,40 @@ bool StagingMove::attemptMove() {
     /* Get the current action for the path segment to be updated */
     oldAction = actionPtr->potentialAction(startBead,path.prev(endBead));
 
+    /* If the action can be computed at trial positions, we generate the whole
+     * stage in a scratch buffer and only write it to the path and lookup table
+     * if the move is accepted */
+    if (actionPtr->hasTrialPotentialAction() && !constants()->spatialSubregionOn()) {
+        int numStageBeads = 0;
+        beadIndex = startBead;
+        do {
+            beadIndex = path.next(beadIndex);
+            stageBeads(numStageBeads) = beadIndex;
+            if (numStageBeads == 0)
+                newPos(0) = newStagingPosition(startBead,endBead,stageLength,0,wind);
+            else
+                newPos(numStageBeads) = newStagingPosition(newPos(numStageBeads-1),
+                        endBead,stageLength,numStageBeads,wind);
+            ++numStageBeads;
+        } while (!all(beadIndex==path.prev(endBead)));
+
+        /* The fixed start bead contributes the same action before and after */
+        double x = random.rand();
+        newAction = actionPtr->potentialAction(startBead);
+        if ( boundedTrialPotentialAction(stageBeads,newPos,numStageBeads,oldAction - log(x),newAction)
+                && (x < exp(-(newAction-oldAction))) ) {
+            for (int n = 0; n < numStageBeads; n++)
+                path.updateBead(stageBeads(n),newPos(n));
+            keepMove();
+            checkMove(1,newAction-oldAction);
+        }
+        else {
+            success = false;
+            checkMove(2,0.0);
+        }
+        return success;
+    }
+
     /* Perform the staging update, generating the new path and updating bead
      * positions, while storing the old one */
     beadIndex = startBead;
@@ -1379,11 +1579,11 @@ bool StagingMove::attemptMove() {
     } while (!all(beadIndex==path.prev(endBead)));
 
     if ( !movedIntoSubRegionA ) {
-        /* Get the new action for the updated path segment */
-        newAction = actionPtr->potentialAction(startBead,path.prev(endBead));
-
-        /* The actual Metropolis test */
-        if ( random.rand() < exp(-(newAction-oldAction)) ) {
+        /* Get the new action for the updated path segment, stopping as soon
+         * as the Metropolis test can no longer be passed */
+        double x = random.rand();
+        if ( boundedPotentialAction(startBead,path.prev(endBead),oldAction - log(x),newAction)
+                && (x < exp(-(newAction-oldAction))) ) {
             keepMove();
             checkMove(1,newAction-oldAction);
         }
@@ -1808,11 +2008,7 @@ void OpenMove::keepMove() {
     numAcceptedLevel(numLevels)++;
     
     /* Remove the beads and links from the gap */
-    beadLocator beadIndex;
-    beadIndex = path.next(headBead);
-    while (!all(beadIndex==tailBead)) {
-        beadIndex = path.delBeadGetNext(beadIndex);
-    } 
+    path.removeSegment(path.next(headBead),gapLength-1);
 
     /* Update all the properties of the worm */
     path.worm.update(path,headBead,tailBead);
@@ -1852,6 +2048,9 @@ CloseMove::CloseMove (Path &_path, ActionBase *_actionPtr,
 
     /* Initialize private data to zero */
     numAccepted = numAttempted = numToMove = 0;
+
+    /* Scratch space for the positions of a newly generated segment */
+    newPos.resize(constants()->Mbar());
 }
 
 /*************************************************************************//**
@@ -1970,12 +2169,16 @@ bool CloseMove::attemptMove() {
     else
     {
         /* Generate a new new trajectory */
-        beadLocator beadIndex;
-        beadIndex = path.worm.head;
-        for (int k = 0; k < (path.worm.gap-1); k++) {
-            beadIndex = path.addNextBead(beadIndex,
-                    newStagingPosition(beadIndex,path.worm.tail,path.worm.gap,k,wind));
+        int numNewBeads = path.worm.gap - 1;
+        if (numNewBeads > 0) {
+            newPos(0) = newStagingPosition(path.worm.head,path.worm.tail,path.worm.gap,0,wind);
+            for (int k = 1; k < numNewBeads; k++)
+                newPos(k) = newStagingPosition(newPos(k-1),path.worm.tail,path.worm.gap,k,wind);
         }
+
+        /* Add all the new beads to the path in a single segment */
+        beadLocator beadIndex;
+        beadIndex = path.insertSegment(path.worm.head,newPos,numNewBeads);
         path.next(beadIndex) = path.worm.tail;
         path.prev(path.worm.tail) = beadIndex;
 
@@ -2022,10 +2225,8 @@ void CloseMove::keepMove() {
 void CloseMove::undoMove() {
 
     /* Delete all the beads that were added. */
-    beadLocator beadIndex;
-    beadIndex = path.next(path.worm.head);
-    while (!all(beadIndex==path.worm.tail) && (!all(beadIndex==XXX)))
-        beadIndex = path.delBeadGetNext(beadIndex);
+    if (!all(path.next(path.worm.head)==path.worm.tail))
+        path.removeSegment(path.next(path.worm.head),path.worm.gap-1);
 
     path.next(path.worm.head) = XXX;
     path.prev(path.worm.tail) = XXX;
@@ -2052,6 +2253,9 @@ InsertMove::InsertMove (Path &_path, ActionBase *_actionPtr, MTRand &_random,
 
     /* Initialize private data to zero */
     numAccepted = numAttempted = numToMove = 0;
+
+    /* Scratch space for the positions of a newly generated segment */
+    newPos.resize(constants()->Mbar());
 }
 
 /*************************************************************************//**
@@ -2155,18 +2359,17 @@ bool InsertMove::attemptMove() {
     else {
 
         /* Generate the path for the proposed worm, setting the new head as special */
-        beadLocator beadIndex;
-        beadIndex = tailBead;
-        for (int k = 0; k < wormLength; k++) 
-            beadIndex = path.addNextBead(beadIndex,newFreeParticlePosition(beadIndex));
-        headBead = beadIndex;
+        newPos(0) = newFreeParticlePosition(tailBead);
+        for (int k = 1; k < wormLength; k++) 
+            newPos(k) = newFreeParticlePosition(newPos(k-1));
+        headBead = path.insertSegment(tailBead,newPos,wormLength);
         path.worm.special1 = headBead;
 
-        /* Compute the new path action */
-        newAction = actionPtr->potentialAction(tailBead,headBead);
-
-        /* Perform the metropolis test */
-        if ( random.rand() < norm*exp(-newAction + muShift) ) {
+        /* Compute the new path action, stopping as soon as the metropolis
+         * test can no longer be passed */
+        double x = random.rand();
+        if ( boundedPotentialAction(tailBead,headBead,muShift + log(norm) - log(x),newAction)
+                && (x < norm*exp(-newAction + muShift)) ) {
             keepMove();
             checkMove(1,newAction);
         }
@@ -2207,11 +2410,7 @@ void InsertMove::undoMove() {
 
     /* To undo an insert, we simply remove all the beads that we have
      * added and reset the worm state.*/
-    beadLocator beadIndex;
-    beadIndex = tailBead;
-    do {
-        beadIndex = path.delBeadGetNext(beadIndex);
-    } while (!all(beadIndex==XXX));
+    path.removeSegment(tailBead,wormLength+1);
 
     path.worm.reset();
 
@@ -2359,11 +2558,7 @@ void RemoveMove::keepMove() {
 
     /* We delete the worm from our data sets and reset all
      * worm properties.  */
-    beadLocator beadIndex;
-    beadIndex = path.worm.head;
-    do {
-        beadIndex = path.delBeadGetPrev(beadIndex);
-    } while (!all(beadIndex==XXX));
+    path.removeSegment(path.worm.head,path.worm.length+1,false);
 
     path.worm.reset();
 
@@ -2402,6 +2597,9 @@ AdvanceHeadMove::AdvanceHeadMove (Path &_path, ActionBase *_actionPtr,
 
     /* Initialize private data to zero */
     numAccepted = numAttempted = numToMove = 0;
+
+    /* Scratch space for the positions of a newly generated segment */
+    newPos.resize(constants()->Mbar());
 }
 
 /*************************************************************************//**
@@ -2502,11 +2700,10 @@ bool AdvanceHeadMove::attemptMove() {
     else {
 
         /* Generate the new path, assigning the new head */
-        beadLocator beadIndex;
-        beadIndex = path.worm.special1;
-        for (int k = 0; k < advanceLength; k++)
-            beadIndex = path.addNextBead(beadIndex,newFreeParticlePosition(beadIndex));
-        headBead = beadIndex;
+        newPos(0) = newFreeParticlePosition(path.worm.special1);
+        for (int k = 1; k < advanceLength; k++)
+            newPos(k) = newFreeParticlePosition(newPos(k-1));
+        headBead = path.insertSegment(path.worm.special1,newPos,advanceLength);
         path.worm.head = headBead;
 
         /* Compute the action for the updated path */
@@ -2557,10 +2754,7 @@ void AdvanceHeadMove::undoMove() {
     path.worm.head = path.worm.special1;
 
     /* We remove all the beads and links that have been added. */
-    beadLocator beadIndex;
-    beadIndex = path.next(path.worm.head);
-    while (!all(beadIndex==XXX))
-        beadIndex = path.delBeadGetNext(beadIndex);
+    path.removeSegment(path.next(path.worm.head),advanceLength);
     path.next(path.worm.head) = XXX;
 
     /* Reset the configuration to off-diagonal */
@@ -2713,11 +2907,7 @@ void AdvanceTailMove::keepMove() {
     numAcceptedLevel(numLevels)++;
 
     /* Delete beads and links */
-    beadLocator beadIndex;
-    beadIndex = path.prev(tailBead);
-    do {
-        beadIndex = path.delBeadGetPrev(beadIndex);
-    } while (!all(beadIndex==XXX));
+    path.removeSegment(path.prev(tailBead),advanceLength,false);
 
     /* Update all the changed properties of the inserted worm */
     path.worm.update(path,path.worm.head,tailBead);
@@ -2880,11 +3070,7 @@ void RecedeHeadMove::keepMove() {
     numAcceptedLevel(numLevels)++;
 
     /* Delete beads and links */
-    beadLocator beadIndex;
-    beadIndex = path.next(headBead);
-    do {
-        beadIndex = path.delBeadGetNext(beadIndex);
-    } while (!all(beadIndex==XXX));
+    path.removeSegment(path.next(headBead),recedeLength);
 
     /* Update all the changed properties of the inserted worm */
     path.worm.update(path,headBead,path.worm.tail);
@@ -2927,6 +3113,9 @@ RecedeTailMove::RecedeTailMove (Path &_path, ActionBase *_actionPtr,
 
     /* Initialize private data to zero */
     numAccepted = numAttempted = numToMove = 0;
+
+    /* Scratch space for the positions of a newly generated segment */
+    newPos.resize(constants()->Mbar());
 }
 
 /*************************************************************************//**
@@ -3029,11 +3218,10 @@ bool RecedeTailMove::attemptMove() {
     /* Otherwise, we perform a full trajectory updates */
     else {
         /* Generate the new path, assigning the new tail */
-        beadLocator beadIndex;
-        beadIndex = path.worm.special1;
-        for (int k = 0; k < recedeLength; k++)
-            beadIndex = path.addPrevBead(beadIndex,newFreeParticlePosition(beadIndex));
-        tailBead = beadIndex;
+        newPos(0) = newFreeParticlePosition(path.worm.special1);
+        for (int k = 1; k < recedeLength; k++)
+            newPos(k) = newFreeParticlePosition(newPos(k-1));
+        tailBead = path.insertSegment(path.worm.special1,newPos,recedeLength,false);
         path.worm.tail = tailBead;
 
         /* Get the action for the proposed path */
@@ -3084,10 +3272,7 @@ void RecedeTailMove::undoMove() {
     path.worm.tail = path.worm.special1;
 
     /* We remove all the beads and links that have been added. */
-    beadLocator beadIndex;
-    beadIndex = path.prev(path.worm.tail);
-    while (!all(beadIndex==XXX)) 
-        beadIndex = path.delBeadGetPrev(beadIndex);
+    path.removeSegment(path.prev(path.worm.tail),recedeLength,false);
     path.prev(path.worm.tail) = XXX;
 
     /* Reset the configuration to off-diagonal */
@@ -3449,10 +3634,11 @@ bool SwapHeadMove::attemptMove() {
                         beadIndex = path.next(beadIndex);
                     } while (!all(beadIndex==path.next(pivot)));
 
-                    /* Compute the potential action for the updated path */
-                    newAction = actionPtr->potentialAction(path.worm.special1,pivot);
-
-                    if ( random.rand() < exp(-(newAction - oldAction))) {
+                    /* Compute the potential action for the updated path,
+                     * stopping as soon as the move must be rejected */
+                    double x = random.rand();
+                    if ( boundedPotentialAction(path.worm.special1,pivot,oldAction - log(x),newAction)
+                            && (x < exp(-(newAction - oldAction))) ) {
                         keepMove();
                         checkMove(1,newAction-oldAction);
                     }
@@ -0,0 +1,243 @@
+/**
+ * @file numa.cpp
+ *
+ * @brief NumaArena class implementation.
+ */
+
+#include "numa.h"
+#include "constants.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+/* The preferred memory policy of mbind, as defined in <numaif.h> */
+#define PIMC_MPOL_PREFERRED 1
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// NUMA ARENA CLASS ----------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  Until initialized nothing is placed.
+******************************************************************************/
+NumaArena::NumaArena() :
+    placing(false),
+    replicating(false)
+{
+}
+
+/**************************************************************************//**
+ *  This public method gets an instance of the NumaArena object, only one
+ *  can ever exist at a time.
+******************************************************************************/
+NumaArena* NumaArena::getInstance ()
+{
+    static NumaArena inst;
+    return &inst;
+}
+
+/**************************************************************************//**
+ *  Detect the numa nodes and their cpus.
+ *
+ *  The nodes are read from sysfs, so placement is only supported on linux.
+ *
+ *  @param _placing Do we track per path arrays for the report?
+ *  @param _replicating Do we replicate shared tables on each node?
+******************************************************************************/
+void NumaArena::init(const bool _placing, const bool _replicating) {
+
+#ifdef __linux__
+    /* Read the cpus of each node, e.g. 0-7,16-23 */
+    for (int n = 0; ; n++) {
+        ifstream cpuList(str(format("/sys/devices/system/node/node%d/cpulist") % n));
+        if (!cpuList)
+            break;
+        vector <int> nCPU;
+        string range;
+        while (getline(cpuList, range, ',')) {
+            if (range.find_first_of("0123456789") == string::npos)
+                continue;
+            size_t dash = range.find('-');
+            int lo = stoi(range.substr(0,dash));
+            int hi = (dash == string::npos) ? lo : stoi(range.substr(dash+1));
+            for (int c = lo; c <= hi; c++)
+                nCPU.push_back(c);
+        }
+        nodeCPU.push_back(nCPU);
+    }
+
+    for (int n = 0; n < numNodes(); n++) {
+        for (int c : nodeCPU[n]) {
+            if (c >= int(cpuNode.size()))
+                cpuNode.resize(c+1,0);
+            cpuNode[c] = n;
+        }
+    }
+#endif
+
+    placing = (_placing || _replicating) && (numNodes() > 0);
+    replicating = _replicating && placing;
+}
+
+/**************************************************************************//**
+ *  The numa node of the calling thread.
+ *
+ *  The node is looked up on every call, as an unpinned thread may migrate.
+******************************************************************************/
+int NumaArena::node() {
+
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if ((cpu >= 0) && (cpu < int(cpuNode.size())))
+        return cpuNode[cpu];
+#endif
+    return 0;
+}
+
+/**************************************************************************//**
+ *  Map memory which prefers a node.
+ *
+ *  The mapping is private to the caller, so the policy only affects its own
+ *  pages, and is released with them.  Nothing has been touched yet, so
+ *  pages are allocated on the preferred node as they are filled, falling
+ *  back to other nodes if it is full.  If the policy cannot be set the
+ *  memory is still usable.
+ *
+ *  @param size The number of bytes
+ *  @param n The preferred node
+ *  @return The page aligned memory, or NULL if it could not be mapped
+******************************************************************************/
+void *NumaArena::allocate(const size_t size, const int n) {
+
+#if defined(__linux__) && defined(SYS_mbind)
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    const int bits = 8*sizeof(unsigned long);
+    vector <unsigned long> mask(n/bits + 1, 0);
+    mask[n/bits] = 1UL << (n % bits);
+
+    syscall(SYS_mbind, data, size, PIMC_MPOL_PREFERRED, mask.data(),
+            mask.size()*bits + 1, 0);
+    return data;
+#else
+    return NULL;
+#endif
+}
+
+/**************************************************************************//**
+ *  Track an array for the report.
+ *
+ *  @param array The array object
+ *  @param label A description of the array
+ *  @param shared Is the array shared between replicas?
+ *  @param data The first element
+ *  @param size The number of bytes
+ *  @param mapping The mapping owned by the arena (or NULL)
+ *  @param mappingSize The number of bytes mapped
+******************************************************************************/
+void NumaArena::track(const void *array, const string &label, const bool shared,
+        const void *data, const size_t size, void *mapping, const size_t mappingSize) {
+    Entry e = {label, ConstantParameters::binding(), shared, data, size,
+        mapping, mappingSize};
+    std::lock_guard<std::mutex> lock(entryMutex);
+    entry[array] = e;
+}
+
+/**************************************************************************//**
+ *  Stop tracking an array, which must be done before it is destroyed.
+ *
+ *  The memory of a replica is unmapped.
+ *
+ *  @param array The array object
+******************************************************************************/
+void NumaArena::forget(const void *array) {
+    std::lock_guard<std::mutex> lock(entryMutex);
+    auto e = entry.find(array);
+    if (e == entry.end())
+        return;
+#ifdef __linux__
+    if (e->second.mapping != NULL)
+        munmap(e->second.mapping, e->second.mappingSize);
+#endif
+    entry.erase(e);
+}
+
+/**************************************************************************//**
+ *  The fraction of the pages of a range of memory on each node.
+ *
+ *  At most 1024 evenly spaced pages are queried, and pages which have not
+ *  yet been touched are not counted.
+ *
+ *  @param data The start of the range
+ *  @param size The number of bytes
+ *  @return The fraction of pages on each node
+******************************************************************************/
+vector <double> NumaArena::locate(const void *data, const size_t size) {
+
+    vector <double> fraction(numNodes(), 0.0);
+
+#if defined(__linux__) && defined(SYS_move_pages)
+    size_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(page-1);
+    size_t numPages = (reinterpret_cast<uintptr_t>(data) + size - start + page - 1)/page;
+    size_t stride = std::max(size_t(1), numPages/1024);
+
+    vector <void *> pages;
+    for (size_t p = 0; p < numPages; p += stride)
+        pages.push_back(reinterpret_cast<void *>(start + p*page));
+    vector <int> status(pages.size(), -1);
+
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), NULL, status.data(), 0) != 0)
+        return fraction;
+
+    int numFound = 0;
+    for (int s : status) {
+        if ((s >= 0) && (s < numNodes())) {
+            fraction[s] += 1.0;
+            numFound++;
+        }
+    }
+    for (auto &f : fraction)
+        f /= std::max(numFound,1);
+#endif
+
+    return fraction;
+}
+
+/**************************************************************************//**
+ *  Report where the tracked arrays reside.
+ *
+ *  @param shared Report the shared tables, otherwise the arrays of the
+ *  calling replica
+******************************************************************************/
+void NumaArena::report(const bool shared) {
+
+    if (!placing)
+        return;
+
+    std::lock_guard<std::mutex> lock(entryMutex);
+    for (const auto &e : entry) {
+        if ((e.second.shared != shared) ||
+                (!shared && (e.second.owner != ConstantParameters::binding())))
+            continue;
+
+        vector <double> fraction = locate(e.second.data, e.second.size);
+        string where;
+        for (int n = 0; n < numNodes(); n++)
+            where += str(format(" node %d: %5.1f%%") % n % (100.0*fraction[n]));
+
+        cout << format("[PIMCID: %s] - NUMA %-36s %10.2f MB,%s") % constants()->id()
+            % e.second.label % (e.second.size/1048576.0) % where << endl;
+    }
+}
@@ -0,0 +1,246 @@
+/**
+ * @file observables.cpp
+ *
+ * @brief ObservablesCache class implementation.
+ */
+
+#include "observables.h"
+#include "path.h"
+#include "action.h"
+#include "threadpool.h"
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// OBSERVABLES CACHE CLASS ---------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  Every quantity starts out stale.
+ *
+ *  @param _path The path
+ *  @param _actionPtr The action
+******************************************************************************/
+ObservablesCache::ObservablesCache(const Path &_path, ActionBase *_actionPtr) :
+    path(_path),
+    actionPtr(_actionPtr),
+    configuration(1),
+    timing(false),
+    fillTime_(0.0),
+    linkConfig(0),
+    link2(_path.numTimeSlices,0.0),
+    worldlineConfig(0),
+    sliceW(_path.numTimeSlices),
+    sliceAz(_path.numTimeSlices,0.0),
+    sliceI(_path.numTimeSlices,0.0),
+    potentialConfig(_path.numTimeSlices,0),
+    V(_path.numTimeSlices,blitz::TinyVector<double,2>(0.0)),
+    dUdTauConfig(_path.numTimeSlices,0),
+    dUdTau(_path.numTimeSlices,0.0),
+    dUdLambdaConfig(_path.numTimeSlices,0),
+    dUdLambda(_path.numTimeSlices,0.0)
+{
+    W = 0.0;
+}
+
+/**************************************************************************//**
+ *  Start timing a fill of the cache.
+******************************************************************************/
+void ObservablesCache::beginFill() {
+    if (timing)
+        fillStart = std::chrono::steady_clock::now();
+}
+
+/**************************************************************************//**
+ *  Add the time of a fill of the cache to the total.
+******************************************************************************/
+void ObservablesCache::endFill() {
+    if (timing)
+        fillTime_ += std::chrono::duration<double>(std::chrono::steady_clock::now() 
+                - fillStart).count();
+}
+
+/**************************************************************************//**
+ *  Find the squared link lengths of each slice and the winding vector.
+ *
+ *  Both come from the same link of every bead, so they are found together.
+******************************************************************************/
+void ObservablesCache::computeLinks() {
+
+    beginFill();
+    W = 0.0;
+    beadLocator beadIndex;
+    dVec vel;
+    for (beadIndex[0] = 0; beadIndex[0] < path.numTimeSlices; beadIndex[0]++) {
+        double sum = 0.0;
+        for (beadIndex[1] = 0; beadIndex[1] < path.numBeadsAtSlice(beadIndex[0]); beadIndex[1]++) {
+            vel = path.getVelocity(beadIndex);
+            sum += dot(vel,vel);
+            W += vel;
+        }
+        link2[beadIndex[0]] = sum;
+    }
+    linkConfig = configuration;
+    endFill();
+}
+
+/**************************************************************************//**
+ *  The sum of the squared link lengths leaving a slice.
+ *
+ *  @param slice The time slice
+******************************************************************************/
+double ObservablesCache::linkSquared(const int slice) {
+    PIMC_ASSERT(slice >= 0 && slice < path.numTimeSlices);
+    if (linkConfig != configuration)
+        computeLinks();
+    return link2[slice];
+}
+
+/**************************************************************************//**
+ *  The sum of all links, unscaled by the size of the box.
+******************************************************************************/
+const dVec &ObservablesCache::winding() {
+    if (linkConfig != configuration)
+        computeLinks();
+    return W;
+}
+
+/**************************************************************************//**
+ *  The links of every bead.
+ *
+ *  The slices are swept concurrently by the thread pool, each writing its
+ *  own range of beads, and their totals are then summed in order.  The
+ *  squared links and winding vector come along for free.
+******************************************************************************/
+const ObservablesCache::Worldlines &ObservablesCache::worldlines() {
+
+    if (worldlineConfig == configuration)
+        return wl;
+
+    beginFill();
+    int numTimeSlices = path.numTimeSlices;
+    wl.offset.resize(numTimeSlices+1);
+    wl.offset[0] = 0;
+    for (int slice = 0; slice < numTimeSlices; slice++)
+        wl.offset[slice+1] = wl.offset[slice] + path.numBeadsAtSlice(slice);
+
+    int numBeads = wl.size();
+    wl.x.resize(numBeads);
+    wl.y.resize(numBeads);
+    wl.linkZ.resize(numBeads);
+    wl.area.resize(numBeads);
+    wl.inner.resize(numBeads);
+    wl.cell.resize(numBeads);
+
+    threadPool()->parallelFor(0, numTimeSlices, [this](const int slice) {sweepSlice(slice);});
+
+    W = 0.0;
+    wl.Az = wl.I = 0.0;
+    for (int slice = 0; slice < numTimeSlices; slice++) {
+        W += sliceW[slice];
+        wl.Az += sliceAz[slice];
+        wl.I += sliceI[slice];
+    }
+
+    linkConfig = worldlineConfig = configuration;
+    endFill();
+    return wl;
+}
+
+/**************************************************************************//**
+ *  Find the links of every bead of a slice.
+ *
+ *  @param slice The time slice
+******************************************************************************/
+void ObservablesCache::sweepSlice(const int slice) {
+
+    double periodicZ = path.boxPtr->periodic[NDIM-1];
+
+    beadLocator beadIndex;
+    beadIndex[0] = slice;
+    dVec pos1,pos2,vel;
+
+    double sum = 0.0;
+    double Az = 0.0;
+    double I = 0.0;
+    sliceW[slice] = 0.0;
+    for (int b = wl.offset[slice]; b < wl.offset[slice+1]; b++) {
+        beadIndex[1] = b - wl.offset[slice];
+
+        pos1 = path(beadIndex);
+        pos2 = path(path.next(beadIndex));
+        vel = path.getVelocity(beadIndex);
+
+        sum += dot(vel,vel);
+        sliceW[slice] += vel;
+
+        wl.x[b] = pos1[0];
+        wl.linkZ[b] = vel[NDIM-1]*periodicZ;
+        wl.cell[b] = path.boxPtr->gridIndex(pos1);
+#if NDIM > 1
+        wl.y[b] = pos1[1];
+        wl.area[b] = pos1[0]*pos2[1] - pos2[0]*pos1[1];
+        wl.inner[b] = pos1[0]*pos2[0] + pos1[1]*pos2[1];
+#else
+        wl.y[b] = 0.0;
+        wl.area[b] = 0.0;
+        wl.inner[b] = pos1[0]*pos2[0];
+#endif
+        Az += wl.area[b];
+        I += wl.inner[b];
+    }
+
+    link2[slice] = sum;
+    sliceAz[slice] = Az;
+    sliceI[slice] = I;
+}
+
+/**************************************************************************//**
+ *  The external and interaction potential at a slice.
+ *
+ *  @param slice The time slice
+******************************************************************************/
+const blitz::TinyVector<double,2> &ObservablesCache::potential(const int slice) {
+    PIMC_ASSERT(slice >= 0 && slice < path.numTimeSlices);
+    if (potentialConfig[slice] != configuration) {
+        beginFill();
+        V[slice] = actionPtr->potential(slice);
+        potentialConfig[slice] = configuration;
+        endFill();
+    }
+    return V[slice];
+}
+
+/**************************************************************************//**
+ *  The derivative of the potential action with respect to tau at a slice.
+ *
+ *  @param slice The time slice
+******************************************************************************/
+double ObservablesCache::derivPotentialActionTau(const int slice) {
+    PIMC_ASSERT(slice >= 0 && slice < path.numTimeSlices);
+    if (dUdTauConfig[slice] != configuration) {
+        beginFill();
+        dUdTau[slice] = actionPtr->derivPotentialActionTau(slice);
+        dUdTauConfig[slice] = configuration;
+        endFill();
+    }
+    return dUdTau[slice];
+}
+
+/**************************************************************************//**
+ *  The derivative of the potential action with respect to lambda at a slice.
+ *
+ *  @param slice The time slice
+******************************************************************************/
+double ObservablesCache::derivPotentialActionLambda(const int slice) {
+    PIMC_ASSERT(slice >= 0 && slice < path.numTimeSlices);
+    if (dUdLambdaConfig[slice] != configuration) {
+        beginFill();
+        dUdLambda[slice] = actionPtr->derivPotentialActionLambda(slice);
+        dUdLambdaConfig[slice] = configuration;
+        endFill();
+    }
+    return dUdLambda[slice];
+}
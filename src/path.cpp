@@ -7,6 +7,7 @@
 
 #include "path.h"
 #include "lookuptable.h"
+#include "numa.h"
 #include "communicator.h"
 
 // ---------------------------------------------------------------------------
@@ -107,6 +108,8 @@ Path::Path(const Container * _boxPtr, LookupTable &_lookup, int _numTimeSlices,
     /* Initialize the lookup table */
     lookup.resizeList(getNumParticles());
     lookup.updateGrid(*this);
+
+    placeMemory();
 }
 
 /*************************************************************************//**
@@ -115,10 +118,15 @@ Path::Path(const Container * _boxPtr, LookupTable &_lookup, int _numTimeSlices,
  * Kill all blitz arrays
 *****************************************************************************/
 Path::~Path () {
+    numaArena()->forget(&beads);
+    numaArena()->forget(&prevLink);
+    numaArena()->forget(&nextLink);
+    numaArena()->forget(&worm.beads);
     beads.free();
     prevLink.free();
     nextLink.free();
     numBeadsAtSlice.free();
+    segmentBeads.free();
 }
 
 /*************************************************************************//**
@@ -256,27 +264,8 @@ beadLocator Path::addBead(const int slice, const dVec &pos) {
 
     /* Here we check and see if we have enough free-space to add a bead.  If
      * not we have to grow all our data structures */
-    if (lastBeadIndex[1] == numWorldLines) {
-
-        /* Resize and initialize the main data array which holds all worldline 
-         * configurations */
-        beads.resizeAndPreserve(numTimeSlices,numWorldLines + 1);
-        beads(blitz::Range::all(),numWorldLines) = 0.0;
-
-        /* Resize and initialize the worm bead arrays which tells us
-         * whether or not we have a bead present */
-        worm.beads.resizeAndPreserve(numTimeSlices,numWorldLines + 1);
-        worm.beads(blitz::Range::all(),numWorldLines) = 0;
-
-        /* Resize and initialize the previous and next link arrays */
-        prevLink.resizeAndPreserve(numTimeSlices,numWorldLines + 1);
-        nextLink.resizeAndPreserve(numTimeSlices,numWorldLines + 1);
-        prevLink(blitz::Range::all(),numWorldLines) = XXX;
-        nextLink(blitz::Range::all(),numWorldLines) = XXX;
-
-        /* Resize the lookup table */
-        lookup.resizeList(numWorldLines + 1);
-    } 
+    if (lastBeadIndex[1] == numWorldLines)
+        reserveWorldLines(numWorldLines + 1);
 
     PIMC_ASSERT(!worm.beadOn(lastBeadIndex));
 
@@ -300,6 +289,233 @@ beadLocator Path::addBead(const int slice, const dVec &pos) {
 }
 
 
+/**************************************************************************//**
+ *  Grow all worldline data structures.
+ * 
+ *  The beads, worm beads, link arrays and lookup table lists are resized
+ *  (preserving their contents) such that they can hold the supplied number of
+ *  worldlines. The new entries are initialized to be empty and unlinked.
+ *  @param numWorldLines The number of worldlines we need to store
+******************************************************************************/
+void Path::reserveWorldLines(const int numWorldLines) {
+
+    int oldNumWorldLines = getNumParticles();
+    if (numWorldLines <= oldNumWorldLines)
+        return;
+
+    blitz::Range newWorldLines(oldNumWorldLines,numWorldLines-1);
+
+    /* Resize and initialize the main data array which holds all worldline 
+     * configurations */
+    beads.resizeAndPreserve(numTimeSlices,numWorldLines);
+    beads(blitz::Range::all(),newWorldLines) = 0.0;
+
+    /* Resize and initialize the worm bead arrays which tells us
+     * whether or not we have a bead present */
+    worm.beads.resizeAndPreserve(numTimeSlices,numWorldLines);
+    worm.beads(blitz::Range::all(),newWorldLines) = 0;
+
+    /* Resize and initialize the previous and next link arrays */
+    prevLink.resizeAndPreserve(numTimeSlices,numWorldLines);
+    nextLink.resizeAndPreserve(numTimeSlices,numWorldLines);
+    prevLink(blitz::Range::all(),newWorldLines) = XXX;
+    nextLink(blitz::Range::all(),newWorldLines) = XXX;
+
+    /* Resize the lookup table */
+    lookup.resizeList(numWorldLines);
+
+    placeMemory();
+}
+
+/**************************************************************************//**
+ *  Track the worldline arrays, whose pages are first touched (and so placed)
+ *  by the calling thread.
+ *
+ *  This is needed whenever they are reallocated.
+******************************************************************************/
+void Path::placeMemory() {
+    numaArena()->place(beads,"path beads");
+    numaArena()->place(prevLink,"path previous links");
+    numaArena()->place(nextLink,"path next links");
+    numaArena()->place(worm.beads,"path worm beads");
+}
+
+/**************************************************************************//**
+ *  Add a linked segment of beads to the worldline configuration.
+ * 
+ *  This is equivalent to numBeads successive calls to addNextBead (or
+ *  addPrevBead if forward is false) but the data structures are grown at most
+ *  once and the lookup table is updated for the whole segment in a single
+ *  pass.
+ *  @param startBead The existing bead that the segment is attached to
+ *  @param pos The spatial positions of the new beads (in imaginary time order
+ *  moving away from startBead)
+ *  @param numBeads The number of beads to add
+ *  @param forward Do we add beads at advancing (true) or receding time slices?
+ *  @return the last bead added to the segment
+******************************************************************************/
+beadLocator Path::insertSegment(const beadLocator &startBead, const blitz::Array<dVec,1> &pos,
+        const int numBeads, const bool forward) {
+
+    PIMC_ASSERT(numBeads <= pos.extent(blitz::firstDim));
+    PIMC_ASSERT(forward ? all(next(startBead)==XXX) : all(prev(startBead)==XXX));
+
+    if (numBeads == 0)
+        return startBead;
+
+    int shift = forward ? 1 : -1;
+
+    /* Find the largest number of worldlines we will need after the segment
+     * has been added.  Long segments may wrap around in imaginary time and 
+     * place more than one bead on a slice. */
+    int numWorldLines = getNumParticles();
+    int numWraps = numBeads / numTimeSlices;
+    int numRemaining = numBeads % numTimeSlices;
+    int numSlices = (numBeads < numTimeSlices) ? numBeads : numTimeSlices;
+    for (int k = 0; k < numSlices; k++) {
+        int slice = (startBead[0] + shift*(k+1)) % numTimeSlices;
+        if (slice < 0)
+            slice += numTimeSlices;
+        int numNeeded = numBeadsAtSlice(slice) + numWraps + (k < numRemaining);
+        if (numNeeded > numWorldLines)
+            numWorldLines = numNeeded;
+    }
+
+    /* Grow our data structures a single time if required */
+    reserveWorldLines(numWorldLines);
+
+    if (segmentBeads.extent(blitz::firstDim) < numBeads)
+        segmentBeads.resize(numBeads);
+
+    /* Add and link all the beads */
+    beadLocator beadIndex,neighborIndex;
+    neighborIndex = startBead;
+    for (int k = 0; k < numBeads; k++) {
+
+        int slice = neighborIndex[0] + shift;
+        if (slice >= numTimeSlices)
+            slice -= numTimeSlices;
+        else if (slice < 0)
+            slice += numTimeSlices;
+
+        beadIndex[0] = slice;
+        beadIndex[1] = numBeadsAtSlice(slice);
+        PIMC_ASSERT(!worm.beadOn(beadIndex));
+
+        worm.addBead(beadIndex);
+        ++numBeadsAtSlice(slice);
+        beads(beadIndex) = pos(k);
+
+        if (forward) {
+            next(neighborIndex) = beadIndex;
+            prev(beadIndex) = neighborIndex;
+            next(beadIndex) = XXX;
+        }
+        else {
+            prev(neighborIndex) = beadIndex;
+            next(beadIndex) = neighborIndex;
+            prev(beadIndex) = XXX;
+        }
+
+        segmentBeads(k) = beadIndex;
+        neighborIndex = beadIndex;
+    }
+
+    /* Update the number of active beads and the lookup table */
+    worm.numBeadsOn += numBeads;
+    lookup.addBeads(segmentBeads,pos,numBeads);
+
+    lastBeadIndex = beadIndex;
+    return beadIndex;
+}
+
+/**************************************************************************//**
+ *  Remove a linked segment of beads from the worldline configuration.
+ * 
+ *  Starting at startBead (inclusive) we delete up to length beads following
+ *  the next (or prev if forward is false) links, stopping early if we reach 
+ *  the end of a worldline.  The whole segment is taken out of the lookup 
+ *  table and unlinked first.  Each slice is then shrunk, and any hole left 
+ *  below its new size is filled by a surviving bead from above it, which 
+ *  is relabelled in place.
+ *  @param startBead The first bead to be removed
+ *  @param length The maximum number of beads to remove
+ *  @param forward Do we follow next (true) or prev links?
+ *  @return the bead linked to the last removed bead (XXX at a worldline end)
+******************************************************************************/
+beadLocator Path::removeSegment(const beadLocator &startBead, const int length, 
+        const bool forward) {
+
+    if (segmentBeads.extent(blitz::firstDim) < length)
+        segmentBeads.resize(length);
+
+    /* Find the beads of the segment */
+    beadLocator beadIndex;
+    beadIndex = startBead;
+    int numBeads = 0;
+    while ((numBeads < length) && !all(beadIndex==XXX)) {
+        segmentBeads(numBeads) = beadIndex;
+        beadIndex = forward ? next(beadIndex) : prev(beadIndex);
+        ++numBeads;
+    }
+
+    /* Remove them from the lookup table, unlink and switch them off */
+    lookup.delBeads(segmentBeads,numBeads);
+    for (int k = 0; k < numBeads; k++) {
+        const beadLocator &cBead = segmentBeads(k);
+        if (!all(next(cBead)==XXX))
+            prev(next(cBead)) = XXX;
+        if (!all(prev(cBead)==XXX))
+            next(prev(cBead)) = XXX;
+        next(cBead) = XXX;
+        prev(cBead) = XXX;
+        worm.delBead(cBead);
+        --numBeadsAtSlice(cBead[0]);
+    }
+    worm.numBeadsOn -= numBeads;
+
+    /* Fill the holes below the new size of each slice */
+    for (int k = 0; k < numBeads; k++) {
+        const beadLocator &hole = segmentBeads(k);
+        lastBeadIndex = hole;
+        if (hole[1] >= numBeadsAtSlice(hole[0]))
+            continue;
+
+        /* The surviving beads above the new size are all moved down */
+        lastBeadIndex[1] = numBeadsAtSlice(hole[0]);
+        while (!worm.beadOn(lastBeadIndex))
+            ++lastBeadIndex[1];
+
+        lookup.moveBead(lastBeadIndex,hole);
+        beads(hole) = beads(lastBeadIndex);
+        worm.addBead(hole);
+
+        prev(hole) = prev(lastBeadIndex);
+        next(hole) = next(lastBeadIndex);
+        if (!all(next(lastBeadIndex)==XXX))
+            prev(next(lastBeadIndex)) = hole;
+        if (!all(prev(lastBeadIndex)==XXX))
+            next(prev(lastBeadIndex)) = hole;
+
+        if (all(worm.head==lastBeadIndex))
+            worm.head = hole;
+        if (all(worm.tail==lastBeadIndex))
+            worm.tail = hole;
+        if (all(worm.special1==lastBeadIndex))
+            worm.special1 = hole;
+        if (all(worm.special2==lastBeadIndex))
+            worm.special2 = hole;
+        if (all(beadIndex==lastBeadIndex))
+            beadIndex = hole;
+
+        next(lastBeadIndex) = XXX;
+        prev(lastBeadIndex) = XXX;
+        worm.delBead(lastBeadIndex);
+    }
+
+    return beadIndex;
+}
+
 /**************************************************************************//**
  *  Delete a bead and move backwards.
  * 
@@ -317,6 +533,131 @@ beadLocator Path::delBeadGetPrev(const beadLocator &beadIndex) {
     return prevBead;
 }
 
+/**************************************************************************//**
+ *  Exchange the worldline configuration with another path.
+ *
+ *  Both paths must be diagonal and have the same number of time slices.  The
+ *  bead, link and worm arrays are swapped by reference, and the lookup tables
+ *  of both paths are then rebuilt for their new configurations.
+ *
+ *  @param other The path we exchange configurations with
+******************************************************************************/
+void Path::exchangeConfiguration(Path &other) {
+
+    PIMC_ASSERT(worm.isConfigDiagonal && other.worm.isConfigDiagonal);
+    PIMC_ASSERT(numTimeSlices == other.numTimeSlices);
+
+    /* Swap the array references without copying any data */
+    blitz::Array<dVec,2> tempBeads;
+    tempBeads.reference(beads);
+    beads.reference(other.beads);
+    other.beads.reference(tempBeads);
+
+    blitz::Array<beadLocator,2> tempLink;
+    tempLink.reference(prevLink);
+    prevLink.reference(other.prevLink);
+    other.prevLink.reference(tempLink);
+
+    tempLink.reference(nextLink);
+    nextLink.reference(other.nextLink);
+    other.nextLink.reference(tempLink);
+
+    blitz::Array<unsigned int,2> tempWormBeads;
+    tempWormBeads.reference(worm.beads);
+    worm.beads.reference(other.worm.beads);
+    other.worm.beads.reference(tempWormBeads);
+
+    blitz::Array<int,1> tempNumBeads;
+    tempNumBeads.reference(numBeadsAtSlice);
+    numBeadsAtSlice.reference(other.numBeadsAtSlice);
+    other.numBeadsAtSlice.reference(tempNumBeads);
+
+    /* Update the worm and the lookup table for each path */
+    for (Path *pathPtr : {this, &other}) {
+        pathPtr->worm.resetNumBeadsOn();
+        pathPtr->worm.reset();
+        pathPtr->lookup.resizeList(pathPtr->getNumParticles());
+        pathPtr->lookup.updateGrid(*pathPtr);
+    }
+}
+
+/**************************************************************************//**
+ *  Copy a blitz array, only reallocating when its shape has changed.
+******************************************************************************/
+template <class T, int N>
+static void copyArray(blitz::Array<T,N> &dest, const blitz::Array<T,N> &src) {
+    if (any(dest.shape() != src.shape()))
+        dest.resize(src.shape());
+    dest = src;
+}
+
+/**************************************************************************//**
+ *  Copy the worldline configuration into a snapshot.
+ *
+ *  @param snapshot The snapshot to be overwritten
+******************************************************************************/
+void Path::saveSnapshot(PathSnapshot &snapshot) const {
+
+    copyArray(snapshot.beads,beads);
+    copyArray(snapshot.prevLink,prevLink);
+    copyArray(snapshot.nextLink,nextLink);
+    copyArray(snapshot.wormBeads,worm.beads);
+    copyArray(snapshot.numBeadsAtSlice,numBeadsAtSlice);
+
+    snapshot.head = worm.head;
+    snapshot.tail = worm.tail;
+    snapshot.special1 = worm.special1;
+    snapshot.special2 = worm.special2;
+    snapshot.maxWormCost = worm.maxWormCost;
+    snapshot.sep = worm.sep;
+    snapshot.length = worm.length;
+    snapshot.gap = worm.gap;
+    snapshot.isConfigDiagonal = worm.isConfigDiagonal;
+    snapshot.numBeadsOn = worm.numBeadsOn;
+
+    snapshot.breakSlice = breakSlice;
+    snapshot.brokenWorldlinesL = brokenWorldlinesL;
+    snapshot.brokenWorldlinesR = brokenWorldlinesR;
+    snapshot.closedWorldlines = closedWorldlines;
+}
+
+/**************************************************************************//**
+ *  Replace the worldline configuration with a snapshot.
+ *
+ *  The lookup table is rebuilt for the new configuration.
+ *
+ *  @param snapshot The snapshot to be loaded
+******************************************************************************/
+void Path::loadSnapshot(const PathSnapshot &snapshot) {
+
+    copyArray(beads,snapshot.beads);
+    copyArray(prevLink,snapshot.prevLink);
+    copyArray(nextLink,snapshot.nextLink);
+    copyArray(worm.beads,snapshot.wormBeads);
+    copyArray(numBeadsAtSlice,snapshot.numBeadsAtSlice);
+
+    worm.head = snapshot.head;
+    worm.tail = snapshot.tail;
+    worm.special1 = snapshot.special1;
+    worm.special2 = snapshot.special2;
+    worm.maxWormCost = snapshot.maxWormCost;
+    worm.sep = snapshot.sep;
+    worm.length = snapshot.length;
+    worm.gap = snapshot.gap;
+    worm.isConfigDiagonal = snapshot.isConfigDiagonal;
+    worm.numBeadsOn = snapshot.numBeadsOn;
+
+    breakSlice = snapshot.breakSlice;
+    brokenWorldlinesL = snapshot.brokenWorldlinesL;
+    brokenWorldlinesR = snapshot.brokenWorldlinesR;
+    closedWorldlines = snapshot.closedWorldlines;
+
+    lookup.resizeList(getNumParticles());
+    lookup.updateGrid(*this);
+
+    placeMemory();
+}
+
 /**************************************************************************//**
  *  Delete a bead and move forwards.
  * 
@@ -18,59 +18,29 @@
 #include "setup.h"
 #include "cmc.h"
 #include "move.h"
+#include "threadpool.h"
+#include "numa.h"
 
-/**
- * Main driver.
- * Read in all program options from the user using boost::program_options and setup the simulation
- * cell, initial conditions and both the interaction and external potential. Either equilibrate or
- * restart a simulation, then start measuring. We output all the simulation parameters to disk as a
- * log file so that it can be restart again assigning it a unique PIMCID.
- * @see http://www.boost.org/doc/libs/release/doc/html/program_options.html
- */
-int main (int argc, char *argv[]) {
-
-    /* Get initial time */
-    time_t start_time = time(NULL);
-    time_t current_time; //current time
-    bool wallClockReached = false;
-
-    uint32 seed = 139853;   // The seed for the random number generator
+#include <thread>
+#include <mutex>
+#include <unistd.h>
+#include <sys/wait.h>
 
-    Setup setup;
-
-    /* Attempt to parse the command line options */
-    try {
-        setup.getOptions(argc,argv);
-    }
-    catch(exception& ex) {
-        cerr << "error: " << ex.what() << "\n";
-        return 1;
-    }
-    catch(...) {
-        cerr << "Exception of unknown type!\n";
-    }
+/* Serializes access to the shared setup object when building replicas */
+static std::mutex setupMutex;
 
-    /* Parse the setup options and possibly exit */
-    if (setup.parseOptions())
-        return 1;
-
-    /* The global random number generator, we add the process number to the seed (for
-     * use in parallel simulations.*/
-    seed = setup.seed(seed);
-    MTRand random(seed);
-
-    /* Get the simulation box */
-    Container *boxPtr = setup.cell();
-
-    /* Create the worldlines */
-    if (setup.worldlines())
-        return 1;
-
-    /* Setup the simulation constants */
-    setup.setConstants();
-
-    /* Setup the simulation communicator */
-    setup.communicator();
+/**
+ * Perform a single simulation.
+ * Create the worldlines, actions, moves and estimators, then either equilibrate or restart and
+ * measure until the requested number of bins have been stored.  The simulation cell and the
+ * interaction and external potentials are owned by the caller, and may be shared read-only between
+ * a number of replicas running concurrently on separate threads.  Replicas on a tempering ladder
+ * periodically exchange configurations through exchangePtr.
+ */
+void simulate(Setup &setup, int argc, char *argv[], const uint32 seed, MTRand &random,
+        Container *boxPtr, PotentialBase *interactionPotentialPtr,
+        PotentialBase *externalPotentialPtr, const time_t start_time,
+        ReplicaExchange *exchangePtr = NULL, const int r = 0) {
 
     /* Get number of paths to use */
     int Npaths = constants()->Npaths();
@@ -83,15 +53,6 @@ int main (int argc, char *argv[]) {
                     constants()->initialNumParticles()));
     }
     
-    /* Create and initialize the potential pointers */
-    PotentialBase *interactionPotentialPtr = setup.interactionPotential(boxPtr);
-    PotentialBase *externalPotentialPtr = setup.externalPotential(boxPtr);
-    if ((constants()->extPotentialType() == "graphenelut3dtobinary") ||
-            (constants()->extPotentialType() == "graphenelut3dtotext") ||
-            (constants()->extPotentialType() == "graphenelut3dgenerate") ) {
-        return 99;
-    }
-
     /* Get the initial conditions associated with the external potential */
     /* Must use the copy constructor as we return a copy */
     blitz::Array<dVec,1> initialPos = 
@@ -105,6 +66,10 @@ int main (int argc, char *argv[]) {
        CMC.run(constants()->numEqSteps(),0);
     }
 
+    /* The setup object may be modified while building the updates, so only
+     * one replica at a time can use it */
+    std::unique_lock<std::mutex> setupLock(setupMutex);
+
     /* Setup the path data variable */
     boost::ptr_vector<Path> pathPtrVec;
     for(int i=0; i<Npaths; i++){
@@ -113,29 +78,42 @@ int main (int argc, char *argv[]) {
                          initialPos,constants()->numBroken()));
     }
     
-    /* The Trial Wave Function (constant for pimc) */
-    WaveFunctionBase *waveFunctionPtr = setup.waveFunction(pathPtrVec.front(),lookupPtrVec.front());
+    /* Each path has its own random number stream, so that multiple paths can
+     * be updated concurrently, the first path uses the global one */
+    boost::ptr_vector<MTRand> randomPtrVec;
+    vector<MTRand*> pathRandom(1,&random);
+    for(int i=1; i<Npaths; i++){
+        randomPtrVec.push_back(new MTRand(random));
+        randomPtrVec.back().seedPath(seed,i);
+        pathRandom.push_back(&randomPtrVec.back());
+    }
+
+    /* The Trial Wave Function (constant for pimc), one for each path so that
+     * it is evaluated on that path's own beads and lookup table */
+    vector<WaveFunctionBase*> waveFunctionPtr;
+    for(int i=0; i<Npaths; i++)
+        waveFunctionPtr.push_back(setup.waveFunction(pathPtrVec[i],lookupPtrVec[i]));
 
     /* Setup the action */
     boost::ptr_vector<ActionBase> actionPtrVec;
     for(int i=0; i<Npaths; i++){
         actionPtrVec.push_back(
                 setup.action(pathPtrVec[i],lookupPtrVec[i],externalPotentialPtr,
-                             interactionPotentialPtr,waveFunctionPtr) );
+                             interactionPotentialPtr,waveFunctionPtr[i]) );
     }
 
     /* The list of Monte Carlo updates (moves) that will be performed */
     boost::ptr_vector< boost::ptr_vector<MoveBase> > movesPtrVec;
     for(int i=0; i<Npaths;i++){
         movesPtrVec.push_back(
-                setup.moves(pathPtrVec[i],&actionPtrVec[i],random));
+                setup.moves(pathPtrVec[i],&actionPtrVec[i],*pathRandom[i]));
     }
 
     /* The list of estimators that will be performed */
     boost::ptr_vector< boost::ptr_vector<EstimatorBase> > estimatorsPtrVec;
     for(int i=0; i<Npaths;i++){
         estimatorsPtrVec.push_back(
-                setup.estimators(pathPtrVec[i],&actionPtrVec[i],random));
+                setup.estimators(pathPtrVec[i],&actionPtrVec[i],*pathRandom[i]));
 
         /* Add labels to estimator output files for multiple paths */
         if(i > 0) {
@@ -149,96 +127,449 @@ int main (int argc, char *argv[]) {
         estimatorsPtrVec.push_back(setup.estimators(pathPtrVec,actionPtrVec,random));
     }
 
+    /* Expensive estimators may be sampled asynchronously.  Each worker has its
+     * own copy of the path, lookup table and action to measure them on. */
+    int numWorkers = setup.numEstimatorWorkers();
+    boost::ptr_vector<LookupTable> workerLookupPtrVec;
+    boost::ptr_vector<Path> workerPathPtrVec;
+    vector<WaveFunctionBase*> workerWaveFunctionPtr;
+    boost::ptr_vector<ActionBase> workerActionPtrVec;
+    boost::ptr_vector<estimator_vector> workerEstimatorsPtrVec;
+    EstimatorPipeline *pipelinePtr = NULL;
+    if (numWorkers > 0) {
+        pipelinePtr = new EstimatorPipeline(pathPtrVec.front(),
+                setup.params["snapshot_buffer"].as<int>());
+        for (int w = 0; w < numWorkers; w++) {
+            workerLookupPtrVec.push_back(
+                    new LookupTable(boxPtr,constants()->numTimeSlices(),
+                        constants()->initialNumParticles()));
+            workerPathPtrVec.push_back(
+                    new Path(boxPtr,workerLookupPtrVec.back(),constants()->numTimeSlices(),
+                        initialPos,constants()->numBroken()));
+            workerWaveFunctionPtr.push_back(
+                    setup.waveFunction(workerPathPtrVec.back(),workerLookupPtrVec.back()));
+            workerActionPtrVec.push_back(
+                    setup.action(workerPathPtrVec.back(),workerLookupPtrVec.back(),
+                        externalPotentialPtr,interactionPotentialPtr,workerWaveFunctionPtr.back()));
+            workerEstimatorsPtrVec.push_back(
+                    setup.asyncEstimators(workerPathPtrVec.back(),&workerActionPtrVec.back(),
+                        random,w));
+            pipelinePtr->addWorker(workerPathPtrVec.back(),workerActionPtrVec.back(),
+                    workerEstimatorsPtrVec.back());
+        }
+    }
+
+    /* The worm constant and chemical potential may be relaxed by running a
+     * number of trial chains concurrently.  Each has its own copy of the 
+     * path, lookup table, action, moves and random number generator. */
+    int numChains = setup.params["relax_chains"].as<int>();
+    boost::ptr_vector<LookupTable> chainLookupPtrVec;
+    boost::ptr_vector<Path> chainPathPtrVec;
+    vector<WaveFunctionBase*> chainWaveFunctionPtr;
+    boost::ptr_vector<ActionBase> chainActionPtrVec;
+    boost::ptr_vector<MTRand> chainRandomPtrVec;
+    boost::ptr_vector<move_vector> chainMovesPtrVec;
+    TrialChains *trialPtr = NULL;
+    if ((numChains > 1) && (setup.params("relax") || setup.params("relaxmu")) 
+            && !constants()->restart()) {
+        trialPtr = new TrialChains;
+        for (int c = 0; c < numChains; c++) {
+            chainLookupPtrVec.push_back(
+                    new LookupTable(boxPtr,constants()->numTimeSlices(),
+                        constants()->initialNumParticles()));
+            chainPathPtrVec.push_back(
+                    new Path(boxPtr,chainLookupPtrVec.back(),constants()->numTimeSlices(),
+                        initialPos,constants()->numBroken()));
+            chainWaveFunctionPtr.push_back(
+                    setup.waveFunction(chainPathPtrVec.back(),chainLookupPtrVec.back()));
+            chainActionPtrVec.push_back(
+                    setup.action(chainPathPtrVec.back(),chainLookupPtrVec.back(),
+                        externalPotentialPtr,interactionPotentialPtr,chainWaveFunctionPtr.back()));
+            chainRandomPtrVec.push_back(new MTRand(random));
+            chainRandomPtrVec.back().seedPath(seed,Npaths+c);
+            chainMovesPtrVec.push_back(
+                    setup.moves(chainPathPtrVec.back(),&chainActionPtrVec.back(),
+                        chainRandomPtrVec.back()));
+            trialPtr->addChain(chainPathPtrVec.back(),chainMovesPtrVec.back(),
+                    chainRandomPtrVec.back());
+        }
+    }
+
+    /* Local copies of the options needed while sampling */
+    bool startWithState = !setup.params["start_with_state"].as<string>().empty();
+    bool relax = setup.params("relax");
+    bool relaxmu = setup.params("relaxmu");
+    bool canonical = setup.params("canonical");
+    int numOutput = setup.params["output_config"].as<int>();
+    int numBinsStored = setup.params["number_bins_stored"].as<int>();
+    int exchangeFrequency = setup.params["tempering_frequency"].as<int>();
+    setupLock.unlock();
+
     /* Setup the pimc object */
-    PathIntegralMonteCarlo pimc(pathPtrVec,random,movesPtrVec,estimatorsPtrVec,
-                                !setup.params["start_with_state"].as<string>().empty());
+    PathIntegralMonteCarlo pimc(pathPtrVec,random,actionPtrVec,movesPtrVec,estimatorsPtrVec,
+            startWithState,pathRandom,pipelinePtr,trialPtr);
 
-    /* A silly banner */
-    if (PIGS)
-        cout << endl 
-             << " _____    _____    _____    _____"   << endl 
-             << "|  __ \\  |_   _|  / ____|  / ____|" << endl
-             << "| |__) |   | |   | |  __  | (___"    << endl
-             << "|  ___/    | |   | | |_ |  \\___ \\" << endl
-             << "| |       _| |_  | |__| |  ____) |"  << endl
-             << "|_|      |_____|  \\_____| |_____/"  << endl
-             << endl;  
-    else 
-        cout << endl
-             << "  _____    _____   __  __    _____"    << endl
-             << " |  __ \\  |_   _| |  \\/  |  / ____|" << endl
-             << " | |__) |   | |   | \\  / | | |     "  << endl
-             << " |  ___/    | |   | |\\/| | | |     "  << endl
-             << " | |       _| |_  | |  | | | |____ "   << endl
-             << " |_|      |_____| |_|  |_|  \\_____|"  << endl
-             << endl;
+    /* Report where the path and lookup table arrays of this replica landed */
+    numaArena()->report(false);
+
+    /* Join the tempering ladder */
+    if (exchangePtr)
+        exchangePtr->join(r,pathPtrVec.front(),actionPtrVec.front());
 
     /* If this is a fresh run, we equilibrate and output simulation parameters to disk */
     if (!constants()->restart()) {
 
         /* Equilibrate */
         cout << format("[PIMCID: %s] - Pre-Equilibration Stage.") % constants()->id() << endl;
-        for (uint32 n = 0; n < constants()->numEqSteps(); n++) 
-            pimc.equilStep(n,setup.params("relax"),setup.params("relaxmu"));
+        for (uint32 n = 0; n < constants()->numEqSteps(); n++) {
+            pimc.equilStep(n,relax,relaxmu);
+            if (exchangePtr && (((n+1) % exchangeFrequency) == 0))
+                exchangePtr->exchange(r);
+        }
 
         /* If we have relaxed the chemical potential, need to update file names 
          * in the grand canonical ensemble */
-        if (!setup.params("canonical") && setup.params("relaxmu")) {
+        if (!canonical && relaxmu) {
+            pimc.flushState();
             communicate()->updateNames();
         }
 
         /* Output simulation details/parameters */
+        setupLock.lock();
         setup.outputOptions(argc,argv,seed,boxPtr,lookupPtrVec.front().getNumNNGrid());
+        setupLock.unlock();
     }
 
     cout << format("[PIMCID: %s] - Measurement Stage.") % constants()->id() << endl;
 
+    /* Start sampling any asynchronous estimators */
+    if (pipelinePtr)
+        pipelinePtr->start();
+
+    /* Time steps and checkpoints against the wall clock and signals */
+    CheckpointScheduler scheduler(start_time, setup.params["checkpoint_interval"].as<double>());
+    bool stopped = false;
+
     /* Sample */
     int oldNumStored = 0;
     int outNum = 0;
-    int numOutput = setup.params["output_config"].as<int>();
     uint32 n = 0;
     do {
+        scheduler.startStep();
         pimc.step();
-        if (pimc.numStoredBins > oldNumStored) {
+        bool binStored = (pimc.numStoredBins > oldNumStored);
+        scheduler.endStep(binStored);
+        if (binStored) {
             oldNumStored = pimc.numStoredBins;
             cout << format("[PIMCID: %s] - Bin #%5d stored to disk.") % constants()->id() 
                 % oldNumStored << endl;
         }
         n++;
 
+        /* Attempt to exchange configurations with neighboring replicas */
+        if (exchangePtr && ((n % exchangeFrequency) == 0))
+            exchangePtr->exchange(r);
+
         /* Output configurations to disk */
         if ((numOutput > 0) && ((n % numOutput) == 0)) {
             pathPtrVec.front().outputConfig(outNum);
             outNum++;
         }
         
-        /* Check if we've reached the wall clock limit*/
-        if(constants()->wallClockOn()){
-            current_time = time(NULL);
-            if ( uint32(current_time)  > (uint32(start_time) + constants()->wallClock()) ){
-                wallClockReached = true;
-                break;
-            }
+        /* Checkpoint when requested, as soon as we can restart from the state */
+        if (scheduler.checkpointDue() && pimc.isDiagonal()) {
+            scheduler.startCheckpoint();
+            pimc.checkpoint();
+            scheduler.endCheckpoint();
+            cout << format("[PIMCID: %s] - Checkpoint saved to disk.") % constants()->id() << endl;
         }
-    } while (pimc.numStoredBins < setup.params["number_bins_stored"].as<int>());
-    if (wallClockReached)
+
+        /* Check if we need to stop before the wall clock limit, or were asked to */
+        if (scheduler.stopDue(binStored)) {
+            stopped = true;
+            break;
+        }
+    } while ((pimc.numStoredBins < numBinsStored) || 
+            ((constants()->targetError() > 0.0) && !pimc.targetReached()));
+    if (stopped && scheduler.signalled())
+        cout << format("[PIMCID: %s] - Stopped by signal.") % constants()->id() << endl;
+    else if (stopped)
         cout << format("[PIMCID: %s] - Wall clock limit reached.") % constants()->id() << endl;
+    else if (constants()->targetError() > 0.0)
+        cout << format("[PIMCID: %s] - Target error of %s reached.") % constants()->id()
+            % constants()->targetQuantity() << endl;
     else
         cout << format("[PIMCID: %s] - Measurement complete.") % constants()->id() << endl;
 
+    /* Leave the tempering ladder so the remaining replicas can continue */
+    if (exchangePtr)
+        exchangePtr->retire(r);
+
     /* Output Results */
     if (!constants()->saveStateFiles())
         pimc.saveState(1);
     pimc.finalOutput();
+    if (exchangePtr)
+        exchangePtr->output(r);
+
+    /* Free up memory, stopping any estimator workers first */
+    delete pipelinePtr;
+    for (auto wfPtr : workerWaveFunctionPtr)
+        delete wfPtr;
+    delete trialPtr;
+    for (auto wfPtr : chainWaveFunctionPtr)
+        delete wfPtr;
+    for (auto wfPtr : waveFunctionPtr)
+        delete wfPtr;
+
+    initialPos.free();
+}
+
+/**
+ * Perform a replica simulation on the current thread.
+ * Each replica has its own copy of the constants (and hence its own PIMCID), output files and
+ * random number stream, while sharing the cell and potentials of the main process.  On a
+ * tempering ladder the replica also has its own temperature and chemical potential.
+ */
+void replica(Setup &setup, int argc, char *argv[], const int r, const uint32 baseSeed,
+        Container *boxPtr, PotentialBase *interactionPotentialPtr,
+        PotentialBase *externalPotentialPtr, const time_t start_time,
+        ReplicaExchange *exchangePtr) {
+
+    ConstantParameters::bindReplica();
+    Communicator::bindReplica();
+    threadPool()->pinReplica(r);
+
+    uint32 seed,process;
+    bool counterBased;
+    {
+        std::lock_guard<std::mutex> setupLock(setupMutex);
+        setup.temperingConstants(r);
+        setup.communicator();
+        seed = setup.seed(baseSeed,r);
+        process = setup.process(r);
+        counterBased = (setup.params["rng"].as<string>() == "pimc_philox");
+    }
+
+    /* The replica's random number generator */
+    MTRand random(seed);
+    if (counterBased)
+        random.seedStream(baseSeed,process);
+
+    simulate(setup,argc,argv,seed,random,boxPtr,interactionPotentialPtr,
+            externalPotentialPtr,start_time,exchangePtr,r);
+
+    Communicator::unbindReplica();
+    ConstantParameters::unbindReplica();
+}
+
+/**
+ * Main driver.
+ * Read in all program options from the user using boost::program_options and setup the simulation
+ * cell, initial conditions and both the interaction and external potential. Either equilibrate or
+ * restart a simulation, then start measuring. We output all the simulation parameters to disk as a
+ * log file so that it can be restart again assigning it a unique PIMCID.
+ * @see http://www.boost.org/doc/libs/release/doc/html/program_options.html
+ */
+int main (int argc, char *argv[]) {
+
+    /* Get initial time */
+    time_t start_time = time(NULL);
+
+    uint32 seed = 139853;   // The seed for the random number generator
+
+    Setup setup;
+
+    /* Attempt to parse the command line options */
+    try {
+        setup.getOptions(argc,argv);
+    }
+    catch(exception& ex) {
+        cerr << "error: " << ex.what() << "\n";
+        return 1;
+    }
+    catch(...) {
+        cerr << "Exception of unknown type!\n";
+    }
+
+    /* Parse the setup options and possibly exit */
+    if (setup.parseOptions())
+        return 1;
+
+    /* In ensemble mode we fork a number of workers, each a simulation with
+     * its own process number (and hence seed), which stream their estimator
+     * bins back through a pipe.  This process only aggregates them.  We fork
+     * before any threads are started. */
+    int numEnsemble = setup.params["ensemble"].as<int>();
+    vector<int> ensembleFd;
+    vector<pid_t> ensemblePid;
+    bool ensembleWorker = false;
+    if (numEnsemble > 1) {
+        vector<int> readFd(numEnsemble), writeFd(numEnsemble);
+        vector<pid_t> workerPid(numEnsemble);
+        for (int k = 0; k < numEnsemble; k++) {
+            int pipeFd[2];
+            if (pipe(pipeFd) != 0) {
+                cerr << "ERROR: Unable to create a pipe for the ensemble." << endl;
+                return 1;
+            }
+            readFd[k] = pipeFd[0];
+            writeFd[k] = pipeFd[1];
+        }
+
+        int k = 0;
+        for (; k < numEnsemble; k++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                cerr << "ERROR: Unable to fork an ensemble worker." << endl;
+                return 1;
+            }
+            if (pid == 0)
+                break;
+            workerPid[k] = pid;
+        }
+
+        if (k < numEnsemble) {
+            /* A worker keeps only the write end of its own pipe */
+            for (int j = 0; j < numEnsemble; j++) {
+                close(readFd[j]);
+                if (j != k)
+                    close(writeFd[j]);
+            }
+            EnsembleChannel::open(writeFd[k]);
+            ensembleWorker = true;
+
+            uint32 process = setup.params["process"].as<uint32>();
+            setup.params.set<uint32>("process",numEnsemble*process + k);
+            if (!setup.params("ensemble_raw"))
+                communicate()->setBaseDir(str(format("OUTPUT/ensemble-%d-%d") % getppid() % k));
+            if (!freopen("/dev/null","w",stdout))
+                cerr << "Unable to silence ensemble worker " << k << endl;
+        }
+        else {
+            for (int j = 0; j < numEnsemble; j++)
+                close(writeFd[j]);
+            ensembleFd = readFd;
+            ensemblePid = workerPid;
+        }
+    }
+
+    /* Start the shared thread pool */
+    threadPool()->init(setup.params["threads"].as<int>(),
+            setup.params["thread_affinity"].as<string>());
+
+    /* Place per path arrays on numa nodes, and replicate shared tables */
+    numaArena()->init(setup.params("numa"),setup.params("numa_replicate"));
+
+    /* The global random number generator, we add the process number to the seed (for
+     * use in parallel simulations.*/
+    uint32 baseSeed = seed;
+    seed = setup.seed(seed);
+    MTRand random(seed);
+
+    /* A counter-based generator is instead keyed by the seed and process
+     * number, giving an independent stream for each */
+    if (setup.params["rng"].as<string>() == "pimc_philox")
+        random.seedStream(baseSeed,setup.process());
+
+    /* Get the simulation box */
+    Container *boxPtr = setup.cell();
+
+    /* Create the worldlines */
+    if (setup.worldlines())
+        return 1;
+
+    /* Setup the simulation constants */
+    setup.setConstants();
+
+    /* Setup the simulation communicator */
+    setup.communicator();
+
+    /* The aggregator of an ensemble merges bins until all workers are done */
+    if (!ensembleFd.empty()) {
+        cout << format("[PIMCID: %s] - Aggregating %d ensemble workers.") % constants()->id()
+            % numEnsemble << endl;
+        EnsembleAggregator aggregator(ensembleFd,ensemblePid);
+        aggregator.run();
+
+        cout << format("[PIMCID: %s] - Merged %d bins.") % constants()->id() 
+            % aggregator.numMerged() << endl;
+        if (aggregator.numFailed() > 0)
+            cout << format("[PIMCID: %s] - %d ensemble workers died, see the log file.") 
+                % constants()->id() % aggregator.numFailed() << endl;
+
+        delete boxPtr;
+        return 1;
+    }
+
+    /* Create and initialize the potential pointers */
+    PotentialBase *interactionPotentialPtr = setup.interactionPotential(boxPtr);
+    PotentialBase *externalPotentialPtr = setup.externalPotential(boxPtr);
+    if ((constants()->extPotentialType() == "graphenelut3dtobinary") ||
+            (constants()->extPotentialType() == "graphenelut3dtotext") ||
+            (constants()->extPotentialType() == "graphenelut3dgenerate") ) {
+        return 99;
+    }
+
+    /* Report where any shared lookup tables landed */
+    numaArena()->report(true);
+
+    /* A silly banner */
+    if (PIGS)
+        cout << endl 
+             << " _____    _____    _____    _____"   << endl 
+             << "|  __ \\  |_   _|  / ____|  / ____|" << endl
+             << "| |__) |   | |   | |  __  | (___"    << endl
+             << "|  ___/    | |   | | |_ |  \\___ \\" << endl
+             << "| |       _| |_  | |__| |  ____) |"  << endl
+             << "|_|      |_____|  \\_____| |_____/"  << endl
+             << endl;  
+    else 
+        cout << endl
+             << "  _____    _____   __  __    _____"    << endl
+             << " |  __ \\  |_   _| |  \\/  |  / ____|" << endl
+             << " | |__) |   | |   | \\  / | | |     "  << endl
+             << " |  ___/    | |   | |\\/| | | |     "  << endl
+             << " | |       _| |_  | |  | | | |____ "   << endl
+             << " |_|      |_____| |_|  |_|  \\_____|"  << endl
+             << endl;
+
+    /* Either perform a single simulation, or run a number of independent
+     * replicas on their own threads, sharing the cell and potentials */
+    int numReplicas = setup.params["replicas"].as<int>();
+    if (numReplicas == 1)
+        simulate(setup,argc,argv,seed,random,boxPtr,interactionPotentialPtr,
+                externalPotentialPtr,start_time);
+    else {
+        /* Replicas on a tempering ladder exchange configurations */
+        bool tempering = setup.params("tempering_temperatures") || 
+            setup.params("tempering_chemical_potentials");
+        ReplicaExchange exchange(numReplicas,random.randInt());
+
+        vector<std::thread> replicaThreads;
+        for (int r = 0; r < numReplicas; r++)
+            replicaThreads.emplace_back(replica,std::ref(setup),argc,argv,r,baseSeed,boxPtr,
+                    interactionPotentialPtr,externalPotentialPtr,start_time,
+                    tempering ? &exchange : NULL);
+        for (auto &thread : replicaThreads)
+            thread.join();
+
+        if (tempering)
+            exchange.printSummary();
+    }
+
+    /* An ensemble worker signals the aggregator that it is done, and only
+     * keeps its own files if asked to */
+    if (ensembleWorker) {
+        EnsembleChannel::close();
+        if (!setup.params("ensemble_raw"))
+            communicate()->discard();
+    }
 
     /* Free up memory */
     delete interactionPotentialPtr;
     delete externalPotentialPtr;
     delete boxPtr;
-    delete waveFunctionPtr;
-
-    initialPos.free();
 
     return 1;
 }
@@ -9,6 +9,10 @@
 #include "path.h"
 #include "lookuptable.h"
 #include "move.h"
+#include "action.h"
+#include "threadpool.h"
+#include "observables.h"
+#include <thread>
 
 // ---------------------------------------------------------------------------
 // ---------------------------------------------------------------------------
@@ -22,14 +26,24 @@
 *  Here we initialize all data structures, moves and estimators that will be
 *  required with peforming a path integral quantum monte carlo simulation.
 *  The initialization depends on whether or not we are restarting, or starting
-*  from a user supplied state.
+*  from a user supplied state.  Each path has its own random number generator
+*  (the first is the global one) so that multiple paths may be updated 
+*  concurrently.  If trial chains are supplied, C0 and μ are relaxed by 
+*  running them concurrently.
 ******************************************************************************/
 PathIntegralMonteCarlo::PathIntegralMonteCarlo (boost::ptr_vector<Path> &_pathPtrVec,
-        MTRand &_random, boost::ptr_vector<move_vector> &_movePtrVec,
-        boost::ptr_vector<estimator_vector> &_estimatorPtrVec, const bool _startWithState) :
+        MTRand &_random, boost::ptr_vector<ActionBase> &_actionPtrVec,
+        boost::ptr_vector<move_vector> &_movePtrVec,
+        boost::ptr_vector<estimator_vector> &_estimatorPtrVec, const bool _startWithState,
+        const vector<MTRand*> &_pathRandom, EstimatorPipeline *_pipelinePtr,
+        TrialChains *_trialPtr) :
     random(_random),
+    pathRandom(_pathRandom),
+    pipeline(_pipelinePtr),
+    trial(_trialPtr),
     binSize(constants()->binSize()),
     Npaths(_pathPtrVec.size()),
+    stateWriter(constants()->syncStateFiles()),
     pathPtrVec(_pathPtrVec),
     path(pathPtrVec.front()),
     movePtrVec(_movePtrVec),
@@ -40,8 +54,12 @@ PathIntegralMonteCarlo::PathIntegralMonteCarlo (boost::ptr_vector<Path> &_pathPt
     /* Are we starting from a saved state? */
     startWithState = _startWithState;
     
-    /* Initialize stateStrings */
-    stateStrings.resize(Npaths);
+    /* Initialize the double buffered stateStrings */
+    for (int b = 0; b < 2; b++) {
+        stateStrings[b].resize(Npaths);
+        stateTicket[b] = 0;
+    }
+    stateBuffer = 0;
     
     /* We keep simulating until we have stored a certain number of measurements */
     numStoredBins = 0;
@@ -97,6 +115,9 @@ PathIntegralMonteCarlo::PathIntegralMonteCarlo (boost::ptr_vector<Path> &_pathPt
     muFactor = 1.0;
     sgnAveN = 0;
 
+    /* The spread of trial values is set when a relaxation begins */
+    trialSpread = 0.0;
+
     /* Used for optimization of μ search */
     bestPN = 0;
     bestmu = constants()->mu();
@@ -147,14 +168,33 @@ PathIntegralMonteCarlo::PathIntegralMonteCarlo (boost::ptr_vector<Path> &_pathPt
     if (startWithState || constants()->restart())
         loadState();
 
+    /* The estimators of each path share the observables of its configuration */
+    for (uint32 pIdx = 0; pIdx < Npaths; pIdx++) {
+        observables.push_back(new ObservablesCache(pathPtrVec[pIdx],&_actionPtrVec[pIdx]));
+        for (auto &est : estimatorPtrVec[pIdx])
+            est.shareObservables(&observables[pIdx]);
+    }
+
     /* Setup all the estimators for measurement i/o */
     for (auto &&estPtr : estimatorPtrVec) 
         for (auto &est : estPtr)
             est.prepare();
+    if (pipeline)
+        for (auto estPtr : pipeline->estimatorPtr)
+            for (auto &est : *estPtr)
+                est.prepare();
 
     /* Make a list of estimator names for the 0th estimator */
     for (auto estimatorPtr = estimator.begin(); estimatorPtr != estimator.end(); ++estimatorPtr) 
         estimatorIndex[estimatorPtr->getName()] = std::distance(estimator.begin(), estimatorPtr);
+
+    /* With a measurement budget, the estimators are timed over the first bin */
+    estimatorsScheduled = (constants()->estimatorBudget() <= 0.0);
+    updateCost = 0.0;
+    cacheCost = 0.0;
+    numTimedSteps = 0;
+    sampleCost.assign(estimator.size(),0.0);
+    observables.front().setTiming(!estimatorsScheduled);
 }
 
 /**************************************************************************//**
@@ -169,7 +209,6 @@ PathIntegralMonteCarlo::~PathIntegralMonteCarlo () {
 ******************************************************************************/
 string PathIntegralMonteCarlo::update(const double x, const int sweep, const int pathIdx=0) { 
 
-    success = false;
     string moveName = "NONE";
     int index;
 
@@ -183,11 +222,52 @@ string PathIntegralMonteCarlo::update(const double x, const int sweep, const int
 
     /* Perform the move */
     moveName = movePtrVec[pathIdx].at(index).getName();
-    success = movePtrVec[pathIdx].at(index).attemptMove();
+    movePtrVec[pathIdx].at(index).attemptMove();
 
     return moveName;
 }
 
+/**************************************************************************//**
+ *  Perform all updates and measurements of a single path.
+ *
+ *  Only the path, its moves, estimators and random number generator are
+ *  touched, so different paths may be updated on different threads.
+******************************************************************************/
+void PathIntegralMonteCarlo::updatePath(const uint32 pIdx) {
+
+    typedef std::chrono::steady_clock clock;
+
+    /* Only the first path is timed, until the frequencies are chosen */
+    bool timed = (pIdx == 0) && !estimatorsScheduled;
+    clock::time_point start = clock::now();
+
+    /* We run through all moves, making sure that we could have touched each bead at least once */
+    for (int n = 0; n < numUpdates ; n++)
+        update(pathRandom[pIdx]->rand(),n,pIdx);
+
+    /* Perform all measurements on the new configuration */
+    observables[pIdx].invalidate();
+    if (!timed) {
+        for (auto& est : estimatorPtrVec[pIdx])
+            est.sample();
+        return;
+    }
+
+    updateCost += std::chrono::duration<double>(clock::now() - start).count();
+    ++numTimedSteps;
+
+    /* The shared observables are charged to the cache, not to the estimator
+     * which happens to fill it */
+    for (uint32 n = 0; n < estimator.size(); n++) {
+        double fill = observables[pIdx].fillTime();
+        start = clock::now();
+        estimator[n].sample();
+        fill = observables[pIdx].fillTime() - fill;
+        sampleCost[n] += std::chrono::duration<double>(clock::now() - start).count() - fill;
+        cacheCost += fill;
+    }
+}
+
 
 /**************************************************************************//**
  *  Diagonal Equilibration
@@ -551,6 +631,277 @@ double PathIntegralMonteCarlo::linearRegressionC0() {
     }
 }
 
+/**************************************************************************//**
+ *  Least squares fit of y = a0 + a1 x.
+ *
+ *  @return false if the x values are degenerate
+******************************************************************************/
+static bool linearFit(const vector<double> &x, const vector<double> &y, 
+        double &a0, double &a1) {
+
+    double sumX,sumY,sumX2,sumXY,sum1;
+    sum1 = sumX = sumY = sumXY = sumX2 = 0.0;
+
+    for (size_t i = 0; i < x.size(); i++) {
+        sumX += x[i];
+        sumX2 += x[i]*x[i];
+        sumY += y[i];
+        sumXY += x[i]*y[i];
+        sum1 += 1.0;
+    }
+
+    double denom = sum1*sumX2 - sumX*sumX;
+    if (abs(denom) < EPS)
+        return false;
+
+    a0 = (sumY*sumX2 - sumX*sumXY)/denom;
+    a1 = (sum1*sumXY - sumY*sumX)/denom;
+    return true;
+}
+
+/**************************************************************************//**
+ *  Relax the chemical potential using concurrent trial chains.
+ * 
+ *  A ladder of μ values is run from the current configuration.  If the
+ *  number distribution of any chain peaks at the target number of particles
+ *  we are done, otherwise the average number of particles is fit linearly 
+ *  in μ and we jump to the target, narrowing the ladder.  If the target lies
+ *  outside the ladder, it is moved past its end and widened.
+******************************************************************************/
+bool PathIntegralMonteCarlo::equilStepRelaxmuTrial() {
+
+    int numChains = trial->size();
+
+    /* Print a message when starting the relaxation */
+    if (!relaxmuMessage) {
+        relaxmuMessage = true;
+        trialSpread = 1.0;
+        cout << format("[PIMCID: %s] - Relax Chemical Potential (%d trial chains).") 
+            % constants()->id() % numChains << endl;
+    }
+
+    /* An evenly spaced ladder centered on the current μ */
+    for (int c = 0; c < numChains; c++)
+        trial->value[c] = constants()->mu() + trialSpread*(c - 0.5*(numChains-1));
+
+    runTrialChains(true,numMuAttempted);
+
+    /* Find the chain closest to the target, and any whose peak is there */
+    int best = -1;
+    int found = -1;
+    bool allBelow = true;
+    bool allAbove = true;
+    for (int c = 0; c < numChains; c++) {
+        cout << format("%8.5f\t%5d\t%10.3f\n") % trial->value[c] % trial->peakN[c] 
+            % trial->aveN[c];
+        allBelow = allBelow && (trial->aveN[c] < N0);
+        allAbove = allAbove && (trial->aveN[c] > N0);
+        if ((best < 0) || (abs(trial->aveN[c]-N0) < abs(trial->aveN[best]-N0)))
+            best = c;
+        if ((trial->peakN[c] == N0) && 
+                ((found < 0) || (abs(trial->aveN[c]-N0) < abs(trial->aveN[found]-N0))))
+            found = c;
+    }
+
+    /* If we have shifted the peak to the desired value, exit */
+    if (found >= 0) {
+        constants()->setmu(trial->value[found]);
+        cout << format("Converged on μ = %8.5f\n\n") % constants()->mu();
+        return true;
+    }
+
+    double mu;
+    if (allBelow) {
+        mu = trial->value.back() + trialSpread;
+        trialSpread *= 1.61803399;
+    }
+    else if (allAbove) {
+        mu = trial->value.front() - trialSpread;
+        trialSpread *= 1.61803399;
+    }
+    else {
+        double a0,a1;
+        mu = trial->value[best];
+        if (linearFit(trial->value,trial->aveN,a0,a1) && (a1 > 0.0))
+            mu = std::min(std::max((N0-a0)/a1,trial->value.front()),trial->value.back());
+        trialSpread *= 0.5;
+    }
+    cout << format("Shifting μ to %8.5f\n") % mu;
+    constants()->setmu(mu);
+
+    return false;
+}
+
+/**************************************************************************//**
+ *  Relax the worm constant C0 using concurrent trial chains.
+ * 
+ *  A geometric ladder of C0 values is run from the current configuration.
+ *  If the diagonal fraction of any chain is close enough to the target we
+ *  are done, otherwise it is fit linearly in ln C0 and we jump to the target,
+ *  narrowing the ladder.  If the target lies outside the ladder, it is moved
+ *  past its end and widened.
+******************************************************************************/
+bool PathIntegralMonteCarlo::equilStepRelaxC0Trial() {
+
+    int numChains = trial->size();
+
+    /* Print a message when starting the relaxation */
+    if (!relaxC0Message) {
+        relaxC0Message = true;
+        trialSpread = 1.61803399;
+        cout << format("[PIMCID: %s] - Relax Worm Constant (%d trial chains).\n") 
+            % constants()->id() % numChains << endl;
+    }
+
+    /* A geometric ladder centered on the current C0 */
+    for (int c = 0; c < numChains; c++)
+        trial->value[c] = constants()->C0() * pow(trialSpread, c - 0.5*(numChains-1));
+
+    runTrialChains(false,numStepsAttempted);
+
+    /* Find the chain closest to the target, the diagonal fraction decreases
+     * with C0 */
+    int best = -1;
+    bool allBelow = true;
+    bool allAbove = true;
+    vector<double> lnC0(numChains);
+    for (int c = 0; c < numChains; c++) {
+        cout << format("%4.2f\t%8.5f\n") % trial->diagFrac[c] % trial->value[c];
+        lnC0[c] = log(trial->value[c]);
+        allBelow = allBelow && (trial->diagFrac[c] < targetDiagFrac);
+        allAbove = allAbove && (trial->diagFrac[c] > targetDiagFrac);
+        if ((best < 0) || (abs(trial->diagFrac[c]-targetDiagFrac) 
+                    < abs(trial->diagFrac[best]-targetDiagFrac)))
+            best = c;
+    }
+
+    if ( (trial->diagFrac[best] > (targetDiagFrac-0.05)) 
+            && (trial->diagFrac[best] <= (targetDiagFrac+0.05)) ) {
+        constants()->setC0(trial->value[best]);
+        cout << format("\nConverged on C0 = %8.5f\n\n") % constants()->C0();
+        return true;
+    }
+
+    double C0;
+    if (allBelow) {
+        C0 = trial->value.front() / trialSpread;
+        trialSpread *= 1.61803399;
+    }
+    else if (allAbove) {
+        C0 = trial->value.back() * trialSpread;
+        trialSpread *= 1.61803399;
+    }
+    else {
+        double a0,a1;
+        C0 = trial->value[best];
+        if (linearFit(lnC0,trial->diagFrac,a0,a1) && (a1 < 0.0))
+            C0 = exp(std::min(std::max((targetDiagFrac-a0)/a1,lnC0.front()),lnC0.back()));
+        trialSpread = sqrt(trialSpread);
+    }
+    C0 = std::min(std::max(C0,1.0E-4),1.0E4);
+    cout << format("Shifting C0 to %8.5f\t%5d\t%8.6f\n") % C0 
+        % path.getTrueNumParticles() 
+        % (1.0*path.getTrueNumParticles()/path.boxPtr->volume);
+    constants()->setC0(C0);
+
+    return false;
+}
+
+/**************************************************************************//**
+ *  Run all trial chains concurrently from the current configuration.
+ *
+ *  @param varymu Are the trial values chemical potentials (or C0)?
+ *  @param numTrialUpdates The number of updates performed by each chain
+******************************************************************************/
+void PathIntegralMonteCarlo::runTrialChains(const bool varymu, const int numTrialUpdates) {
+
+    PathSnapshot snapshot;
+    path.saveSnapshot(snapshot);
+
+    ThreadPool::TaskGroup chainTasks;
+    for (int c = 0; c < trial->size(); c++)
+        threadPool()->run(chainTasks, [&,c] {
+            trialChain(c,snapshot,varymu,numTrialUpdates);
+        });
+    threadPool()->wait(chainTasks);
+}
+
+/**************************************************************************//**
+ *  A single trial chain.
+ *
+ *  The chain works on a private copy of the constants holding its trial
+ *  value, and the first tenth of its updates are discarded before measuring
+ *  the diagonal fraction and number distribution.  The (thread local) move
+ *  counters of the thread running it are left untouched.
+ *
+ *  @param c The chain index
+ *  @param snapshot The starting configuration
+ *  @param varymu Is the trial value a chemical potential (or C0)?
+ *  @param numTrialUpdates The number of updates to perform
+******************************************************************************/
+void PathIntegralMonteCarlo::trialChain(const int c, const PathSnapshot &snapshot, 
+        const bool varymu, const int numTrialUpdates) {
+
+    ConstantParameters *constantsPtr = ConstantParameters::binding();
+    ConstantParameters::bindCopy(constants());
+    uint32 accepted = MoveBase::totAccepted;
+    uint32 attempted = MoveBase::totAttempted;
+
+    if (varymu)
+        constants()->setmu(trial->value[c]);
+    else
+        constants()->setC0(trial->value[c]);
+
+    Path &chainPath = *trial->pathPtr[c];
+    move_vector &chainMove = *trial->movePtr[c];
+    MTRand &chainRandom = *trial->randomPtr[c];
+    chainPath.loadSnapshot(snapshot);
+
+    int numBurnIn = numTrialUpdates/10;
+    int numMeasured = 0;
+    int numDiag = 0;
+    vector <int> numProb;
+
+    for (int n = 0; n < numTrialUpdates; n++) {
+
+        /* Determine the index of the move to be performed */
+        double x = chainRandom.rand();
+        int index;
+        if (chainPath.worm.isConfigDiagonal)
+            index = std::lower_bound(attemptDiagProb.begin(),attemptDiagProb.end(),x)
+                - attemptDiagProb.begin();
+        else 
+            index = std::lower_bound(attemptOffDiagProb.begin(),attemptOffDiagProb.end(),x)
+                - attemptOffDiagProb.begin();
+        chainMove.at(index).attemptMove();
+
+        if (n < numBurnIn)
+            continue;
+
+        /* Accumulate the diagonal fraction and number distribution */
+        numMeasured++;
+        if (chainPath.worm.isConfigDiagonal)
+            numDiag++;
+
+        size_t cN = round(1.0*chainPath.worm.getNumBeadsOn()/constants()->numTimeSlices());
+        if (cN >= numProb.size())
+            numProb.resize(cN+1,0);
+        numProb[cN]++;
+    }
+
+    trial->diagFrac[c] = 1.0*numDiag/numMeasured;
+    trial->peakN[c] = std::max_element(numProb.begin(),numProb.end()) - numProb.begin();
+    double sumN = 0.0;
+    for (size_t N = 0; N < numProb.size(); N++)
+        sumN += 1.0*N*numProb[N];
+    trial->aveN[c] = sumN/numMeasured;
+
+    MoveBase::totAccepted = accepted;
+    MoveBase::totAttempted = attempted;
+    ConstantParameters::unbindReplica();
+    ConstantParameters::attach(constantsPtr);
+}
+
 /**************************************************************************//**
  *  Equilibration.
  * 
@@ -629,9 +980,9 @@ void PathIntegralMonteCarlo::equilStep(const uint32 iStep, const bool relaxC0, c
     else {
         /* Perform possible parameter relaxation schemes */
         if (relaxmu && !foundmu)
-            foundmu = equilStepRelaxmu();
+            foundmu = (trial && (N0 > 0)) ? equilStepRelaxmuTrial() : equilStepRelaxmu();
         else if (relaxC0 && !foundC0) {
-            foundC0 = equilStepRelaxC0();
+            foundC0 = trial ? equilStepRelaxC0Trial() : equilStepRelaxC0();
         }
         /* Otherwise (or after converged) equilibrate */
         else {
@@ -684,23 +1035,53 @@ void PathIntegralMonteCarlo::equilStep(const uint32 iStep, const bool relaxC0, c
  *  complicated multi-step operation which consists of various types of moves.  
  *  They can in general occur at different frequencies. We also measure all 
  *  estimators.
+ *
+ *  With multiple paths, each path is updated and measured as a task of the 
+ *  thread pool with its own random number generator.  All tasks are finished
+ *  before any output and before the multi-path estimators are sampled, so 
+ *  the results only depend on the seed.
 ******************************************************************************/
 void PathIntegralMonteCarlo::step() {
 
-    string moveName;
-
-    /* perform updates on each set of paths */
-    for (uint32 pIdx=0; pIdx<Npaths; pIdx++) {
+    /* perform updates on each set of paths, publishing the configuration for
+     * any asynchronous estimators */
+    if (Npaths == 1) {
+        updatePath(0);
+        if (pipeline)
+            pipeline->publish();
+    }
+    else {
+        /* The other paths are updated by the thread pool.  Whichever thread
+         * runs them, the (thread local) move counters they accumulate are
+         * taken back and added to ours */
+        vector<uint32> numAccepted(Npaths,0);
+        vector<uint32> numAttempted(Npaths,0);
+
+        ThreadPool::TaskGroup pathTasks;
+        for (uint32 pIdx = 1; pIdx < Npaths; pIdx++) {
+            threadPool()->run(pathTasks, [&,pIdx] {
+                uint32 accepted = MoveBase::totAccepted;
+                uint32 attempted = MoveBase::totAttempted;
+
+                updatePath(pIdx);
+
+                numAccepted[pIdx] = MoveBase::totAccepted - accepted;
+                numAttempted[pIdx] = MoveBase::totAttempted - attempted;
+                MoveBase::totAccepted = accepted;
+                MoveBase::totAttempted = attempted;
+            });
+        }
+        updatePath(0);
 
-        /* We run through all moves, making sure that we could have touched each bead at least once */
-        for (int n = 0; n < numUpdates ; n++)  {
-            moveName = update(random.rand(),n,pIdx);
+        threadPool()->wait(pathTasks);
+        for (uint32 pIdx = 1; pIdx < Npaths; pIdx++) {
+            MoveBase::totAccepted += numAccepted[pIdx];
+            MoveBase::totAttempted += numAttempted[pIdx];
         }
+    }
+
+    for (uint32 pIdx=0; pIdx<Npaths; pIdx++) {
 
-        /* Perform all measurements */
-        for (auto& est : estimatorPtrVec[pIdx])
-            est.sample();
-        
         /* Every binSize measurements, we output averages to disk and record the
          * state of the simulation on disk.  */
         if (estimatorPtrVec[pIdx].size() > 0){
@@ -711,10 +1092,24 @@ void PathIntegralMonteCarlo::step() {
                     if (est.getNumAccumulated() >= binSize)
                         est.output();
                 }
+
+                /* Asynchronous estimators are output once they have caught up */
+                if (pipeline && (pIdx == 0)) {
+                    pipeline->drain();
+                    for (auto estPtr : pipeline->estimatorPtr)
+                        for (auto& est : *estPtr)
+                            if (est.getNumAccumulated() >= binSize)
+                                est.output();
+                }
+
                 if(Npaths==1) 
                     saveState();
-                if (pIdx == 0)
+                if (pIdx == 0) {
                     ++numStoredBins;
+                    outputSummary();
+                    if (!estimatorsScheduled)
+                        scheduleEstimators();
+                }
             }
         }
     }
@@ -793,6 +1188,14 @@ void PathIntegralMonteCarlo::finalOutput() {
             % cestimator.getNumSampled() % cestimator.getTotNumAccumulated();
     
     }
+    if (pipeline) {
+        pipeline->drain();
+        for (auto estPtr : pipeline->estimatorPtr)
+            for (auto &cestimator : *estPtr)
+                communicate()->file("log")->stream() << format("%-33s\t:\t%16d\t%16d\n") 
+                    % cestimator.getName() % cestimator.getNumSampled() 
+                    % cestimator.getTotNumAccumulated();
+    }
     communicate()->file("log")->stream() << endl;
     communicate()->file("log")->stream() << "---------- End Estimator Data ------------------" << endl;
 }
@@ -800,14 +1203,20 @@ void PathIntegralMonteCarlo::finalOutput() {
 /**************************************************************************//**
 *  Save the state of the simulation to disk, including all path, worm,
 *  move and estimator data.
+*
+*  The state is serialized into one of two buffers, which are written in the
+*  background.  A buffer is only reused once its previous write is on disk,
+*  and the final save waits for all writes to finish.
 ******************************************************************************/
 void PathIntegralMonteCarlo::saveState(const int finalSave) {
 
-    stringstream stateStrStrm;
-    
     /* We only update the string during the simulation */
     if (!finalSave) {
 
+        /* Switch buffers, waiting for the last write from the new one */
+        stateBuffer = 1 - stateBuffer;
+        stateWriter.wait(stateTicket[stateBuffer]);
+
         for(uint32 pIdx=0; pIdx<Npaths; pIdx++){
 
             stateStrStrm.str("");
@@ -841,15 +1250,22 @@ void PathIntegralMonteCarlo::saveState(const int finalSave) {
             /* Output the worm data */
             stateStrStrm << pathPtrVec[pIdx].worm.beads << endl;
 
-            /* Save the state of the random number generator */
-            uint32 randomState[random.SAVE];
-            random.save(randomState);
-            for (int i = 0; i < random.SAVE; i++)
+            /* Save the state of the random number generator of this path */
+            uint32 randomState[MTRand::SAVE];
+            pathRandom[pIdx]->save(randomState);
+            for (int i = 0; i < pathRandom[pIdx]->saveSize(); i++)
                 stateStrStrm << randomState[i] << " ";
             stateStrStrm << endl;
 
+            /* Save the blocking accumulators, so error analysis survives a
+             * restart */
+            vector <EstimatorBase*> blocked = blockedEstimators(pIdx);
+            stateStrStrm << "blocking " << blocked.size() << endl;
+            for (auto est : blocked)
+                est->saveBlocking(stateStrStrm);
+
             /* store the state string */
-            stateStrings[pIdx] = stateStrStrm.str();
+            stateStrings[stateBuffer][pIdx].assign(stateStrStrm.str());
 
         } // for pidx
     }
@@ -864,16 +1280,193 @@ void PathIntegralMonteCarlo::saveState(const int finalSave) {
             if(pIdx > 0)
                 stateFileName += str(format("%d") % (pIdx+1));
 
-            /* Prepare the state file for writing */
-            communicate()->file(stateFileName.c_str())->reset();
+            /* Hand the stateString to the writer, which replaces the file */
+            stateTicket[stateBuffer] = stateWriter.submit(
+                    communicate()->file(stateFileName.c_str()),
+                    &stateStrings[stateBuffer][pIdx]);
+        }
+    }
+
+    /* The last state must be on disk before we finish */
+    if (finalSave)
+        stateWriter.flush();
+}
+
+/**************************************************************************//**
+ *  Are all paths in a diagonal configuration?
+ *
+ *  Only then can a state be saved and restarted from.
+******************************************************************************/
+bool PathIntegralMonteCarlo::isDiagonal() {
+    for (uint32 pIdx=0; pIdx<Npaths; pIdx++)
+        if (!pathPtrVec[pIdx].worm.isConfigDiagonal)
+            return false;
+    return true;
+}
+
+/**************************************************************************//**
+ *  Refresh the blocking summary file.
+ *
+ *  The mean, error and integrated autocorrelation time of every scalar
+ *  estimator of the first path are rewritten after each of its bins.
+******************************************************************************/
+void PathIntegralMonteCarlo::outputSummary() {
+
+    if (!constants()->blocking())
+        return;
 
-            /* Write the stateString to disk */
-            communicate()->file(stateFileName.c_str())->stream() << stateStrings[pIdx];
+    string summary = str(format("#%-39s%16s%16s%16s%16s%16s\n") % "quantity" % "mean" 
+            % "error" % "tau_int" % "bins" % "converged");
+    for (const auto &est : estimator)
+        summary += est.summary();
+    if (pipeline)
+        for (auto estPtr : pipeline->estimatorPtr)
+            for (const auto &est : *estPtr)
+                summary += est.summary();
 
-            /* Rename and copy the file. */
-            communicate()->file(stateFileName.c_str())->rename();
+    communicate()->file("summary")->replace(summary,false);
+}
+
+/**************************************************************************//**
+ *  The estimators whose blocking accumulators are saved with a path.
+ *
+ *  These are the estimators of the path, followed by those sampled
+ *  asynchronously for the first path.  Their order is the same when saving
+ *  and loading.
+******************************************************************************/
+vector <EstimatorBase*> PathIntegralMonteCarlo::blockedEstimators(const int pIdx) {
+
+    vector <EstimatorBase*> blocked;
+    for (auto &est : estimatorPtrVec[pIdx])
+        blocked.push_back(&est);
+    if (pipeline && (pIdx == 0))
+        for (auto estPtr : pipeline->estimatorPtr)
+            for (auto &est : *estPtr)
+                blocked.push_back(&est);
+    return blocked;
+}
+
+/**************************************************************************//**
+ *  Choose the sampling frequencies of the estimators from their cost.
+ *
+ *  Over the first bin the updates and every estimator of the first path are
+ *  timed, giving the cost per step of each estimator were it measured every
+ *  step.  With a budget f, measurements may take f/(1-f) of the update time.
+ *  The observables shared between estimators are timed apart from them, and
+ *  taken off the budget first.  Estimators sharing a file must output their
+ *  bins together, so they are scheduled as one.  The cheapest are given
+ *  their equal share of the budget first, leaving whatever they don't need
+ *  to the more expensive ones, whose frequencies are raised to fit.  No
+ *  frequency is ever lowered.  The chosen frequencies are written to the
+ *  log.
+ *
+ *  The first estimator counts the measurements of a bin, so raising its
+ *  frequency would stretch every bin.  The estimators sharing its file are
+ *  left at their frequency.
+******************************************************************************/
+void PathIntegralMonteCarlo::scheduleEstimators() {
+
+    estimatorsScheduled = true;
+    observables.front().setTiming(false);
+    if ((numTimedSteps == 0) || (updateCost <= 0.0))
+        return;
+
+    /* The cost per step of the estimators of each file at frequency 1 */
+    map <string,double> labelCost;
+    map <string,int> labelFrequency;
+    for (uint32 n = 0; n < estimator.size(); n++) {
+        string label = estimator[n].getLabel();
+        labelCost[label] += sampleCost[n]*estimator[n].getFrequency()/numTimedSteps;
+        labelFrequency[label] = std::max(labelFrequency[label],estimator[n].getFrequency());
+    }
+
+    /* The estimators of the first file keep their frequency */
+    string binLabel = estimator.front().getLabel();
+    vector < std::pair<double,string> > order;
+    for (auto &cost : labelCost)
+        if (cost.first != binLabel)
+            order.push_back(std::make_pair(cost.second,cost.first));
+    std::sort(order.begin(),order.end());
+
+    /* Share out what is left of the budget, cheapest first */
+    double budget = constants()->estimatorBudget();
+    double remaining = budget/(1.0-budget) * updateCost/numTimedSteps
+        - cacheCost/numTimedSteps - labelCost[binLabel]/labelFrequency[binLabel];
+    remaining = std::max(remaining,0.0);
+    int numLeft = order.size();
+    for (auto &cost : order) {
+        int &frequency = labelFrequency[cost.second];
+        if ((frequency > 0) && (cost.first > 0.0)) {
+            double share = remaining/numLeft;
+            if (cost.first > share*frequency)
+                frequency = int(std::min(ceil(cost.first/share),1.0E9));
+            remaining -= cost.first/frequency;
         }
+        numLeft--;
+    }
+
+    /* Record the choice */
+    communicate()->file("log")->stream() << endl;
+    communicate()->file("log")->stream() << "---------- Begin Estimator Frequencies ---------" << endl;
+    communicate()->file("log")->stream() << endl;
+    communicate()->file("log")->stream() << format("%-29s\t:\t%7.5f\n") % "Budget" % budget;
+    communicate()->file("log")->stream() << format("%-29s\t:\t%7.3E s\n") % "Update" 
+        % (updateCost/numTimedSteps);
+    communicate()->file("log")->stream() << format("%-29s\t:\t%7.3E s\n") % "Shared Observables" 
+        % (cacheCost/numTimedSteps);
+    for (uint32 n = 0; n < estimator.size(); n++) {
+        communicate()->file("log")->stream() << format("%-29s\t:\t%7d\t(%7.3E s)\n") 
+            % estimator[n].getName() % labelFrequency[estimator[n].getLabel()]
+            % (sampleCost[n]*estimator[n].getFrequency()/numTimedSteps);
     }
+    communicate()->file("log")->stream() << endl;
+    communicate()->file("log")->stream() << "---------- End Estimator Frequencies -----------" << endl;
+    communicate()->file("log")->stream() << endl;
+
+    /* All paths measure the same estimators */
+    for (uint32 pIdx = 0; pIdx < Npaths; pIdx++)
+        for (auto &est : estimatorPtrVec[pIdx])
+            est.setFrequency(labelFrequency[est.getLabel()]);
+}
+
+/**************************************************************************//**
+ *  Has the blocking error of the target quantity been reached?
+ *
+ *  Only a converged error counts, so that we never stop on an error which
+ *  is still growing with the block size.
+******************************************************************************/
+bool PathIntegralMonteCarlo::targetReached() {
+
+    if (constants()->targetError() <= 0.0)
+        return false;
+
+    double error;
+    bool converged;
+    for (const auto &est : estimator)
+        if (est.blockingError(constants()->targetQuantity(),error,converged))
+            return converged && (error <= constants()->targetError());
+    if (pipeline)
+        for (auto estPtr : pipeline->estimatorPtr)
+            for (const auto &est : *estPtr)
+                if (est.blockingError(constants()->targetQuantity(),error,converged))
+                    return converged && (error <= constants()->targetError());
+
+    return false;
+}
+
+/**************************************************************************//**
+ *  Save the current state to disk outside of a bin boundary.
+ *
+ *  The state is written even if we only save states at the end of the 
+ *  simulation, and we return once it is on disk.  Estimators are not output,
+ *  so any partially accumulated bin is not part of the checkpoint.
+******************************************************************************/
+void PathIntegralMonteCarlo::checkpoint() {
+    saveState();
+    if (!constants()->saveStateFiles())
+        saveState(1);
+    else
+        flushState();
 }
 
 /**************************************************************************//**
@@ -1025,6 +1618,7 @@ void PathIntegralMonteCarlo::loadState() {
         pathPtrVec[pIdx].nextLink.resize(numTimeSlices,numWorldLines);
         pathPtrVec[pIdx].prevLink.resize(numTimeSlices,numWorldLines);
         pathPtrVec[pIdx].worm.beads.resize(numTimeSlices,numWorldLines);
+        pathPtrVec[pIdx].placeMemory();
 
         /* A temporary container for the beads array */
 	blitz::Array <dVec,2> tempBeads;
@@ -1108,10 +1702,27 @@ void PathIntegralMonteCarlo::loadState() {
         /* Load the state of the random number generator, only if we are restarting 
          * the simulation */
         if (constants()->restart()) {
-            uint32 randomState[random.SAVE];
-            for (int i = 0; i < random.SAVE; i++) 
+            uint32 randomState[MTRand::SAVE];
+            for (int i = 0; i < MTRand::SAVE; i++) 
+                randomState[i] = 0;
+            for (int i = 0; i < pathRandom[pIdx]->saveSize(); i++) 
                 communicate()->file(fileInitStr)->stream() >> randomState[i];
-            random.load(randomState);
+
+            /* Older state files only contain the Mersenne Twister state
+             * vector and position, leaving the normal deviate buffer empty */
+            communicate()->file(fileInitStr)->stream().clear();
+            pathRandom[pIdx]->load(randomState);
+
+            /* Restore the blocking accumulators, if they were saved for the
+             * same estimators */
+            size_t numBlocked;
+            vector <EstimatorBase*> blocked = blockedEstimators(pIdx);
+            if ((communicate()->file(fileInitStr)->stream() >> tempString >> numBlocked)
+                    && (tempString == "blocking") && (numBlocked == blocked.size())) {
+                for (auto est : blocked)
+                    est->loadBlocking(communicate()->file(fileInitStr)->stream());
+            }
+            communicate()->file(fileInitStr)->stream().clear();
         }
 
         /* Reset the number of on beads */
@@ -1410,3 +2021,541 @@ string PathIntegralMonteCarlo::printHistogram() {
 
     return histogramDisplay;
 }
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ESTIMATOR PIPELINE CLASS --------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+*  Constructor.
+*
+*  @param _path The path whose configurations are published
+*  @param _numSlots The number of snapshots in the ring buffer
+******************************************************************************/
+EstimatorPipeline::EstimatorPipeline (const Path &_path, const int _numSlots) :
+    path(_path),
+    numSlots(_numSlots),
+    numPublished(0),
+    stopping(false)
+{
+    for (int n = 0; n < numSlots; n++)
+        slot.push_back(new PathSnapshot);
+}
+
+/**************************************************************************//**
+*  Destructor.
+******************************************************************************/
+EstimatorPipeline::~EstimatorPipeline () {
+    stop();
+}
+
+/**************************************************************************//**
+*  Add a worker.
+*
+*  The estimators must have been built on the supplied path and action, and
+*  the worker overwrites the path with each snapshot in turn.
+******************************************************************************/
+void EstimatorPipeline::addWorker(Path &_path, ActionBase &_action, estimator_vector &_estimator) {
+    workerPathPtr.push_back(&_path);
+    estimatorPtr.push_back(&_estimator);
+    numConsumed.push_back(0);
+
+    workerObservables.push_back(new ObservablesCache(_path,&_action));
+    for (auto &est : _estimator)
+        est.shareObservables(&workerObservables.back());
+}
+
+/**************************************************************************//**
+*  Start the worker threads.
+*
+*  Workers share the constants and output files of the calling thread.
+******************************************************************************/
+void EstimatorPipeline::start() {
+    for (uint32 w = 0; w < workerPathPtr.size(); w++)
+        worker.emplace_back(&EstimatorPipeline::work,this,w,constants(),communicate());
+}
+
+/**************************************************************************//**
+*  The number of snapshots sampled by the slowest worker.
+*
+*  Must be called with the pipeline mutex held.
+******************************************************************************/
+uint64_t EstimatorPipeline::minConsumed() {
+    return *std::min_element(numConsumed.begin(),numConsumed.end());
+}
+
+/**************************************************************************//**
+*  Publish the current configuration of the path.
+*
+*  We only block if the slowest worker has not yet finished with the slot 
+*  that is to be overwritten.
+******************************************************************************/
+void EstimatorPipeline::publish() {
+
+    if (worker.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(pipelineMutex);
+    consumed.wait(lock, [&] { return (numPublished - minConsumed()) < uint64_t(numSlots); });
+    uint64_t next = numPublished;
+    lock.unlock();
+
+    /* No worker reads this slot until it has been published */
+    path.saveSnapshot(slot[next % numSlots]);
+
+    lock.lock();
+    ++numPublished;
+    lock.unlock();
+    published.notify_all();
+}
+
+/**************************************************************************//**
+*  Wait until every published configuration has been sampled.
+******************************************************************************/
+void EstimatorPipeline::drain() {
+    std::unique_lock<std::mutex> lock(pipelineMutex);
+    consumed.wait(lock, [&] { return worker.empty() || (minConsumed() == numPublished); });
+}
+
+/**************************************************************************//**
+*  Sample all outstanding configurations and stop the workers.
+******************************************************************************/
+void EstimatorPipeline::stop() {
+
+    drain();
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        stopping = true;
+    }
+    published.notify_all();
+
+    for (auto &thread : worker)
+        thread.join();
+    worker.clear();
+}
+
+/**************************************************************************//**
+*  The worker loop.
+*
+*  Load each published snapshot in order into the private path and sample
+*  all estimators of this worker.
+******************************************************************************/
+void EstimatorPipeline::work(const int w, ConstantParameters *constantsPtr, 
+        Communicator *communicatorPtr) {
+
+    ConstantParameters::attach(constantsPtr);
+    Communicator::attach(communicatorPtr);
+    threadPool()->unpin();
+
+    std::unique_lock<std::mutex> lock(pipelineMutex);
+    while (true) {
+        published.wait(lock, [&] { return stopping || (numConsumed[w] < numPublished); });
+        if (numConsumed[w] == numPublished)
+            break;
+        uint64_t next = numConsumed[w];
+        lock.unlock();
+
+        workerPathPtr[w]->loadSnapshot(slot[next % numSlots]);
+        workerObservables[w].invalidate();
+        for (auto &est : *estimatorPtr[w])
+            est.sample();
+
+        lock.lock();
+        ++numConsumed[w];
+        consumed.notify_all();
+    }
+    lock.unlock();
+
+    Communicator::detach();
+    ConstantParameters::detach();
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// TRIAL CHAINS CLASS --------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+ *  Add a chain updating its own path.
+ *
+ *  @param _path The path of the chain
+ *  @param _move The moves acting on the path
+ *  @param _random The random number generator used by the moves
+******************************************************************************/
+void TrialChains::addChain(Path &_path, move_vector &_move, MTRand &_random) {
+    pathPtr.push_back(&_path);
+    movePtr.push_back(&_move);
+    randomPtr.push_back(&_random);
+    value.push_back(0.0);
+    diagFrac.push_back(0.0);
+    aveN.push_back(0.0);
+    peakN.push_back(0);
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// REPLICA EXCHANGE CLASS ----------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+/**************************************************************************//**
+*  Constructor.
+*
+*  @param _numReplicas The number of replicas on the ladder
+*  @param seed The seed for the swap decisions
+******************************************************************************/
+ReplicaExchange::ReplicaExchange (const int _numReplicas, const uint32 seed) :
+    numReplicas(_numReplicas),
+    numActive(_numReplicas),
+    numArrived(0),
+    round(0),
+    random(seed),
+    pathPtr(_numReplicas,NULL),
+    actionPtr(_numReplicas,NULL),
+    active(_numReplicas,true),
+    diagonal(_numReplicas,false),
+    tau(_numReplicas,0.0),
+    mu(_numReplicas,0.0),
+    kinetic(_numReplicas,0.0),
+    bareU(_numReplicas,0.0),
+    corU(_numReplicas,0.0),
+    numBeads(_numReplicas,0),
+    numAttempted(_numReplicas,0),
+    numAccepted(_numReplicas,0),
+    lambda(0.0)
+{
+}
+
+/**************************************************************************//**
+*  Register the path and action of a replica.
+*
+*  Must be called from the thread of the replica, as its temperature and 
+*  chemical potential are taken from the bound constants.
+******************************************************************************/
+void ReplicaExchange::join(const int r, Path &_path, ActionBase &_action) {
+
+    std::lock_guard<std::mutex> lock(exchangeMutex);
+    pathPtr[r] = &_path;
+    actionPtr[r] = &_action;
+    tau[r] = constants()->tau();
+    mu[r] = constants()->mu();
+    lambda = constants()->lambda();
+}
+
+/**************************************************************************//**
+*  Wait at the barrier for all active replicas, and attempt swaps.
+*
+*  The pieces of the action of the current configuration are measured by
+*  each replica on its own thread before arriving.  The last replica to 
+*  arrive attempts all swaps for the round and then releases the others.
+******************************************************************************/
+void ReplicaExchange::exchange(const int r) {
+
+    Path &path = *pathPtr[r];
+    bool isDiagonal = path.worm.isConfigDiagonal;
+
+    /* Measure the pieces of the action with a known tau dependence */
+    double K = 0.0;
+    double U = 0.0;
+    double dU = 0.0;
+    int N = 0;
+    if (isDiagonal) {
+        beadLocator beadIndex;
+        for (beadIndex[0] = 0; beadIndex[0] < path.numTimeSlices; ++beadIndex[0]) {
+            for (beadIndex[1] = 0; beadIndex[1] < path.numBeadsAtSlice(beadIndex[0]); ++beadIndex[1]) {
+                dVec vel = path.getVelocity(beadIndex);
+                K += dot(vel,vel);
+            }
+        }
+        N = path.worm.getNumBeadsOn();
+        isDiagonal = actionPtr[r]->potentialActionComponents(U,dU);
+    }
+
+    std::unique_lock<std::mutex> lock(exchangeMutex);
+
+    diagonal[r] = isDiagonal;
+    kinetic[r] = K;
+    bareU[r] = U;
+    corU[r] = dU;
+    numBeads[r] = N;
+    tau[r] = constants()->tau();
+    mu[r] = constants()->mu();
+
+    uint32 myRound = round;
+    ++numArrived;
+    if (numArrived == numActive)
+        attemptExchanges();
+    else
+        roundDone.wait(lock, [&] { return round != myRound; });
+}
+
+/**************************************************************************//**
+*  Remove a replica from the ladder.
+*
+*  If all other active replicas are already waiting, the pending round is 
+*  completed so that they may continue.
+******************************************************************************/
+void ReplicaExchange::retire(const int r) {
+
+    std::lock_guard<std::mutex> lock(exchangeMutex);
+    active[r] = false;
+    --numActive;
+    if ((numArrived > 0) && (numArrived == numActive))
+        attemptExchanges();
+}
+
+/**************************************************************************//**
+*  The action of configuration c evaluated with the parameters of replica r.
+*
+*  For a diagonal configuration with a fixed number of time slices, 
+*  S = K/(4 lambda tau) + (NDIM/2) n ln(4 pi lambda tau) + tau U + tau^3 dU
+*    - mu tau n
+*  where K is the sum of squared link lengths and n the number of beads 
+*  (and hence links).
+******************************************************************************/
+double ReplicaExchange::action(const int r, const int c) {
+
+    double t = tau[r];
+    return kinetic[c]/(4.0*lambda*t) 
+        + 0.5*NDIM*numBeads[c]*log(4.0*M_PI*lambda*t)
+        + t*bareU[c] + t*t*t*corU[c] 
+        - mu[r]*t*numBeads[c];
+}
+
+/**************************************************************************//**
+*  Attempt configuration swaps between neighboring replicas.
+*
+*  We alternate between even and odd pairs on successive rounds, only 
+*  considering pairs where both replicas are active and diagonal.  Must be
+*  called with the exchange mutex held, and releases all waiting replicas.
+******************************************************************************/
+void ReplicaExchange::attemptExchanges() {
+
+    for (int a = round % 2; a < numReplicas - 1; a += 2) {
+        int b = a + 1;
+        if (!(active[a] && active[b] && diagonal[a] && diagonal[b]))
+            continue;
+
+        numAttempted[a]++;
+        double deltaAction = action(a,b) + action(b,a) - action(a,a) - action(b,b);
+        if (random.rand() < exp(-deltaAction)) {
+            numAccepted[a]++;
+            pathPtr[a]->exchangeConfiguration(*pathPtr[b]);
+        }
+    }
+
+    numArrived = 0;
+    ++round;
+    roundDone.notify_all();
+}
+
+/**************************************************************************//**
+*  Output the swap acceptance data to the log file of a replica.
+*
+*  Must be called from the thread of the replica.
+******************************************************************************/
+void ReplicaExchange::output(const int r) {
+
+    std::lock_guard<std::mutex> lock(exchangeMutex);
+
+    communicate()->file("log")->stream() << endl;
+    communicate()->file("log")->stream() << "---------- Begin Replica Exchange Data ---------" << endl;
+    communicate()->file("log")->stream() << endl;
+    for (int a = std::max(r-1,0); a < std::min(r+1,numReplicas-1); a++) {
+        double ratio = (numAttempted[a] == 0) ? 0.0 : 
+            (1.0*numAccepted[a])/(1.0*numAttempted[a]);
+        communicate()->file("log")->stream() << format("%-12s %3d <-> %-8d\t:\t%7.5f\t(%d/%d)\n") 
+            % "Replica" % a % (a+1) % ratio % numAccepted[a] % numAttempted[a];
+    }
+    communicate()->file("log")->stream() << endl;
+    communicate()->file("log")->stream() << "---------- End Replica Exchange Data -----------" << endl;
+}
+
+/**************************************************************************//**
+*  Output the swap acceptance data for the entire ladder.
+******************************************************************************/
+void ReplicaExchange::printSummary() {
+
+    std::lock_guard<std::mutex> lock(exchangeMutex);
+
+    cout << endl << "Replica exchange acceptance:" << endl;
+    for (int a = 0; a < numReplicas-1; a++) {
+        double ratio = (numAttempted[a] == 0) ? 0.0 : 
+            (1.0*numAccepted[a])/(1.0*numAttempted[a]);
+        cout << format("  %3d <-> %-3d : %7.5f (%d/%d)") % a % (a+1) % ratio 
+            % numAccepted[a] % numAttempted[a] << endl;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// CHECKPOINT SCHEDULER CLASS ------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+volatile sig_atomic_t CheckpointScheduler::numTerminate = 0;
+volatile sig_atomic_t CheckpointScheduler::numCheckpoint = 0;
+
+/**************************************************************************//**
+ *  Count the signals received, they are acted on at the next safe point.
+******************************************************************************/
+void CheckpointScheduler::handleSignal(int sig) {
+    if (sig == SIGTERM)
+        numTerminate = numTerminate + 1;
+    else
+        numCheckpoint = numCheckpoint + 1;
+}
+
+/**************************************************************************//**
+*  Constructor.
+*
+*  Installs the signal handlers, which are shared by all replicas, each of
+*  which responds to every signal.
+*
+*  @param start_time The start of the simulation
+*  @param _interval The number of seconds between checkpoints (or 0)
+******************************************************************************/
+CheckpointScheduler::CheckpointScheduler (const time_t start_time, const double _interval) :
+    seenTerminate(numTerminate),
+    seenCheckpoint(numCheckpoint),
+    wallClockOn(constants()->wallClockOn()),
+    interval(_interval),
+    stepTime(0.0),
+    binTime(0.0),
+    checkpointTime(0.0),
+    requested(false),
+    stopAfterCheckpoint(false),
+    terminated(false)
+{
+    clock::time_point now = clock::now();
+    stepStart = binStart = checkpointStart = lastCheckpoint = now;
+
+    /* Convert the wall clock limit to the steady clock */
+    double left = difftime(start_time + time_t(constants()->wallClock()), time(NULL));
+    deadline = now + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(left));
+
+    std::signal(SIGTERM, &CheckpointScheduler::handleSignal);
+    std::signal(SIGUSR1, &CheckpointScheduler::handleSignal);
+}
+
+/**************************************************************************//**
+ *  Start timing a step.
+******************************************************************************/
+void CheckpointScheduler::startStep() {
+    stepStart = clock::now();
+}
+
+/**************************************************************************//**
+ *  Finish timing a step.
+ *
+ *  We keep a running average of the step duration, and the duration of the
+ *  last complete bin.
+ *
+ *  @param binStored Was a bin stored during the step?
+******************************************************************************/
+void CheckpointScheduler::endStep(const bool binStored) {
+    clock::time_point now = clock::now();
+    double dt = std::chrono::duration<double>(now - stepStart).count();
+    stepTime = (stepTime > 0.0) ? 0.9*stepTime + 0.1*dt : dt;
+
+    if (binStored) {
+        binTime = std::chrono::duration<double>(now - binStart).count();
+        binStart = now;
+    }
+}
+
+/**************************************************************************//**
+ *  Start timing a checkpoint.
+******************************************************************************/
+void CheckpointScheduler::startCheckpoint() {
+    checkpointStart = clock::now();
+}
+
+/**************************************************************************//**
+ *  Finish timing a checkpoint.
+ *
+ *  We keep the longest duration, as a slow file system is rarely fast for
+ *  long.
+******************************************************************************/
+void CheckpointScheduler::endCheckpoint() {
+    lastCheckpoint = clock::now();
+    checkpointTime = std::max(checkpointTime,
+            std::chrono::duration<double>(lastCheckpoint - checkpointStart).count());
+    requested = false;
+}
+
+/**************************************************************************//**
+ *  Should we checkpoint at the next diagonal configuration?
+ *
+ *  This is the case once the interval has passed, or a signal was received.
+******************************************************************************/
+bool CheckpointScheduler::checkpointDue() {
+
+    if (numCheckpoint != seenCheckpoint) {
+        seenCheckpoint = numCheckpoint;
+        requested = true;
+    }
+
+    if (numTerminate != seenTerminate) {
+        seenTerminate = numTerminate;
+        requested = terminated = stopAfterCheckpoint = true;
+    }
+
+    if ((interval > 0.0) && 
+            (std::chrono::duration<double>(clock::now() - lastCheckpoint).count() >= interval))
+        requested = true;
+
+    return requested;
+}
+
+/**************************************************************************//**
+ *  Should we stop?
+ *
+ *  We stop after a requested final checkpoint, or at a bin boundary if a 
+ *  further bin would not finish before the wall clock limit.  If not even a 
+ *  few steps fit, we checkpoint now and stop after it.
+ *
+ *  @param binStored Was a bin stored during the last step?
+******************************************************************************/
+bool CheckpointScheduler::stopDue(const bool binStored) {
+
+    if (stopAfterCheckpoint && !requested)
+        return true;
+
+    if (!wallClockOn)
+        return false;
+
+    double left = remaining();
+    if (left <= 0.0)
+        return true;
+
+    if (binStored && (binTime > 0.0) && (left < 1.1*binTime + finalTime()))
+        return true;
+
+    if (left < 2.0*stepTime + checkpointTime + finalTime())
+        requested = stopAfterCheckpoint = true;
+
+    return false;
+}
+
+/**************************************************************************//**
+ *  The number of seconds until the wall clock limit.
+******************************************************************************/
+double CheckpointScheduler::remaining() {
+    return std::chrono::duration<double>(deadline - clock::now()).count();
+}
+
+/**************************************************************************//**
+ *  The predicted duration of the final state save and output.
+ *
+ *  We allow for two checkpoints and a small margin, as we have no
+ *  measurement before the first checkpoint.
+******************************************************************************/
+double CheckpointScheduler::finalTime() {
+    double margin = std::min(10.0, 0.05*constants()->wallClock());
+    return 2.0*checkpointTime + margin;
+}
@@ -9,6 +9,8 @@
 #include "path.h"
 #include "lookuptable.h"
 #include "communicator.h"
+#include "numa.h"
+#include "threadpool.h"
 
 #include <boost/math/special_functions/ellint_1.hpp>
 #include <boost/math/special_functions/ellint_2.hpp>
@@ -147,6 +149,7 @@ blitz::Array<double,1> PotentialBase::getExcLen() {
  * Constructor.
 ******************************************************************************/
 TabulatedPotential::TabulatedPotential() { 
+    minLookupV = -BIG;
     extV = 0.0;
     extdVdr = 0.0;
     extd2Vdr2 = 0.0;
@@ -164,6 +167,8 @@ TabulatedPotential::~TabulatedPotential() {
 /**************************************************************************//**
  *  Given a discretization factor and the system size, create and fill
  *  the lookup tables for the potential and its derivative.
+ *
+ *  The entries are independent, and are filled by the thread pool.
 ******************************************************************************/
 void TabulatedPotential::initLookupTable(const double _dr, const double maxSep) {
 
@@ -178,14 +183,19 @@ void TabulatedPotential::initLookupTable(const double _dr, const double maxSep)
     lookupdVdr = 0.0;
     lookupd2Vdr2 = 0.0;
 
-    double r = 0;
-
-    for (int n = 0; n < tableLength; n++) {
+    threadPool()->parallelFor(0, tableLength, [this](const int n) {
+        double r = n*dr;
         lookupV(n)    = valueV(r);
         lookupdVdr(n) = valuedVdr(r);
         lookupd2Vdr2(n) = valued2Vdr2(r);
-        r += dr;
-    }
+    }, 1024);
+
+    /* The smallest value that can be returned from the table */
+    minLookupV = tableMin();
+    if (extV[0] < minLookupV)
+        minLookupV = extV[0];
+    if (extV[1] < minLookupV)
+        minLookupV = extV[1];
 
     /* r = 0.0; */
     /* for (int n = 0; n < tableLength; n++) { */
@@ -216,6 +226,17 @@ void TabulatedPotential::initLookupTable(const double _dr, const double maxSep)
 
 }
 
+/**************************************************************************//**
+ *  The smallest value in the lookup table of the potential.
+ *
+ *  The reduction is done by the thread pool in fixed chunks.
+******************************************************************************/
+double TabulatedPotential::tableMin() {
+    return threadPool()->parallelReduce(0, tableLength, BIG, 
+            [this](const int n) {return lookupV(n);},
+            [](const double a, const double b) {return std::min(a,b);}, 1024);
+}
+
 /**************************************************************************//**
  *  Use the Newton-Gregory forward difference method to do a 2-point lookup
  *  on the potential table.  
@@ -829,11 +850,7 @@ PlatedLJCylinderPotential::PlatedLJCylinderPotential(const double Ro_, const dou
     initLookupTable(dR,Ri);
     
     /* Find the minimun of the potential */
-    minV = 1.0E5;
-    for (int n = 0; n < tableLength; n++) {
-        if (lookupV(n) < minV)
-            minV = lookupV(n);
-    }
+    minV = std::min(1.0E5,tableMin());
 
     /* The extremal values for the lookup table */
     extV = valueV(0.0),valueV(Ri);
@@ -1062,11 +1079,7 @@ LJCylinderPotential::LJCylinderPotential(const double radius, const double densi
     initLookupTable(dR,R);
     
     /* Find the minimun of the potential */
-    minV = 1.0E5;
-    for (int n = 0; n < tableLength; n++) {
-        if (lookupV(n) < minV)
-            minV = lookupV(n);
-    }
+    minV = std::min(1.0E5,tableMin());
 
     /* The extremal values for the lookup table */
     extV = valueV(0.0),valueV(R);
@@ -3039,6 +3052,13 @@ GrapheneLUT3DPotential::GrapheneLUT3DPotential (string graphenelut3d_file_prefix
     zmin          = LUTinfo( 9  );
     zmax          = LUTinfo( 10 );
     V_zmin        = LUTinfo( 11 );
+
+    /* The tables are shared by all threads, and may be copied to each numa node */
+    numaArena()->replicate(V3d, nodeV3d, "graphene potential table");
+    numaArena()->replicate(gradV3d_x, nodeGradV3d_x, "graphene x gradient table");
+    numaArena()->replicate(gradV3d_y, nodeGradV3d_y, "graphene y gradient table");
+    numaArena()->replicate(gradV3d_z, nodeGradV3d_z, "graphene z gradient table");
+    numaArena()->replicate(grad2V3d, nodeGrad2V3d, "graphene laplacian table");
 }
 
 
@@ -3046,6 +3066,11 @@ GrapheneLUT3DPotential::GrapheneLUT3DPotential (string graphenelut3d_file_prefix
  * Destructor.
 ******************************************************************************/
 GrapheneLUT3DPotential::~GrapheneLUT3DPotential() {
+    for (auto table : {&V3d, &gradV3d_x, &gradV3d_y, &gradV3d_z, &grad2V3d})
+        numaArena()->forget(table);
+    for (auto nodeTable : {&nodeV3d, &nodeGradV3d_x, &nodeGradV3d_y, &nodeGradV3d_z, &nodeGrad2V3d})
+        for (auto &table : *nodeTable)
+            numaArena()->forget(&table);
     V3d.free(); // Potential lookup table
     gradV3d_x.free(); // gradient of potential x direction lookup table
     gradV3d_y.free(); // gradient of potential y direction lookup table
@@ -3076,7 +3101,7 @@ double GrapheneLUT3DPotential::V(const dVec &r) {
 
     cartesian_to_uc(_r, A11, A12, A21, A22);
     put_in_uc(_r, cell_length_a, cell_length_b);
-    double _V = trilinear_interpolation(V3d, _r, dx, dy, dz);
+    double _V = trilinear_interpolation(numaArena()->local(V3d,nodeV3d), _r, dx, dy, dz);
     //double _V = direct_lookup(V3d, _r, dx, dy, dz);
     //std::cout << _r << " " << _V << std::endl;
     
@@ -3100,9 +3125,9 @@ dVec GrapheneLUT3DPotential::gradV(const dVec &r) {
 
     cartesian_to_uc(_r, A11, A12, A21, A22);
     put_in_uc(_r, cell_length_a, cell_length_b);
-    double _gradV_x = trilinear_interpolation(gradV3d_x, _r, dx, dy, dz);
-    double _gradV_y = trilinear_interpolation(gradV3d_y, _r, dx, dy, dz);
-    double _gradV_z = trilinear_interpolation(gradV3d_z, _r, dx, dy, dz);
+    double _gradV_x = trilinear_interpolation(numaArena()->local(gradV3d_x,nodeGradV3d_x), _r, dx, dy, dz);
+    double _gradV_y = trilinear_interpolation(numaArena()->local(gradV3d_y,nodeGradV3d_y), _r, dx, dy, dz);
+    double _gradV_z = trilinear_interpolation(numaArena()->local(gradV3d_z,nodeGradV3d_z), _r, dx, dy, dz);
     //double _gradV_x = direct_lookup(gradV3d_x, _r, dx, dy, dz);
     //double _gradV_y = direct_lookup(gradV3d_y, _r, dx, dy, dz);
     //double _gradV_z = direct_lookup(gradV3d_z, _r, dx, dy, dz);
@@ -3129,7 +3154,7 @@ double GrapheneLUT3DPotential::grad2V(const dVec &r) {
 
     cartesian_to_uc(_r, A11, A12, A21, A22);
     put_in_uc(_r, cell_length_a, cell_length_b);
-    _grad2V = trilinear_interpolation(grad2V3d, _r, dx, dy, dz);
+    _grad2V = trilinear_interpolation(numaArena()->local(grad2V3d,nodeGrad2V3d), _r, dx, dy, dz);
     //_grad2V = direct_lookup(grad2V3d, _r, dx, dy, dz);
     return _grad2V;
 }
@@ -3506,8 +3531,8 @@ double GrapheneLUT3DPotentialGenerate::grad2Vg_64(
 double GrapheneLUT3DPotentialGenerate::V_64(
         double x, double y, double z, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
-        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, blitz::Array<int,1> g_i_array,
-        blitz::Array<int,1> g_j_array, blitz::Array<double,1> g_magnitude_array ) {
+        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, const blitz::Array<int,1> &g_i_array,
+        const blitz::Array<int,1> &g_j_array, const blitz::Array<double,1> &g_magnitude_array ) {
     bool flag_1 = false;
     bool flag_2 = false;
     bool flag_3 = false;
@@ -3562,8 +3587,8 @@ double GrapheneLUT3DPotentialGenerate::V_64(
 double GrapheneLUT3DPotentialGenerate::gradV_x_64(
         double x, double y, double z, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
-        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, blitz::Array<int,1> g_i_array,
-        blitz::Array<int,1> g_j_array, blitz::Array<double,1> g_magnitude_array ) {
+        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, const blitz::Array<int,1> &g_i_array,
+        const blitz::Array<int,1> &g_j_array, const blitz::Array<double,1> &g_magnitude_array ) {
     bool flag_1 = false;
     bool flag_2 = false;
     bool flag_3 = false;
@@ -3613,8 +3638,8 @@ double GrapheneLUT3DPotentialGenerate::gradV_x_64(
 double GrapheneLUT3DPotentialGenerate::gradV_y_64(
         double x, double y, double z, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
-        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, blitz::Array<int,1> g_i_array,
-        blitz::Array<int,1> g_j_array, blitz::Array<double,1> g_magnitude_array ) {
+        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, const blitz::Array<int,1> &g_i_array,
+        const blitz::Array<int,1> &g_j_array, const blitz::Array<double,1> &g_magnitude_array ) {
     bool flag_1 = false;
     bool flag_2 = false;
     bool flag_3 = false;
@@ -3664,8 +3689,8 @@ double GrapheneLUT3DPotentialGenerate::gradV_y_64(
 double GrapheneLUT3DPotentialGenerate::gradV_z_64(
         double x, double y, double z, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
-        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, blitz::Array<int,1> g_i_array,
-        blitz::Array<int,1> g_j_array, blitz::Array<double,1> g_magnitude_array ) {
+        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, const blitz::Array<int,1> &g_i_array,
+        const blitz::Array<int,1> &g_j_array, const blitz::Array<double,1> &g_magnitude_array ) {
     bool flag_1 = false;
     bool flag_2 = false;
     bool flag_3 = false;
@@ -3715,8 +3740,8 @@ double GrapheneLUT3DPotentialGenerate::gradV_z_64(
 double GrapheneLUT3DPotentialGenerate::grad2V_64(
         double x, double y, double z, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
-        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, blitz::Array<int,1> g_i_array,
-        blitz::Array<int,1> g_j_array, blitz::Array<double,1> g_magnitude_array ) {
+        blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n, const blitz::Array<int,1> &g_i_array,
+        const blitz::Array<int,1> &g_j_array, const blitz::Array<double,1> &g_magnitude_array ) {
     bool flag_1 = false;
     bool flag_2 = false;
     bool flag_3 = false;
@@ -3897,12 +3922,12 @@ GrapheneLUT3DPotentialGenerate::get_g_magnitudes(
 
 
 void GrapheneLUT3DPotentialGenerate::calculate_V3D_64(
-        blitz::Array<double,3> V3D, blitz::Array<double,2> xy_x, blitz::Array<double,2> xy_y,
-        blitz::Array<double,1> z_range, double sigma, double epsilon,
+        blitz::Array<double,3> &V3D, const blitz::Array<double,2> &xy_x, const blitz::Array<double,2> &xy_y,
+        const blitz::Array<double,1> &z_range, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double x;
     double y;
     double z;
@@ -3920,12 +3945,12 @@ void GrapheneLUT3DPotentialGenerate::calculate_V3D_64(
 }
 
 void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_x_64(
-        blitz::Array<double,3> V3D, blitz::Array<double,2> xy_x, blitz::Array<double,2> xy_y,
-        blitz::Array<double,1> z_range, double sigma, double epsilon,
+        blitz::Array<double,3> &V3D, const blitz::Array<double,2> &xy_x, const blitz::Array<double,2> &xy_y,
+        const blitz::Array<double,1> &z_range, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double x;
     double y;
     double z;
@@ -3942,12 +3967,12 @@ void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_x_64(
 }
 
 void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_y_64(
-        blitz::Array<double,3> V3D, blitz::Array<double,2> xy_x, blitz::Array<double,2> xy_y,
-        blitz::Array<double,1> z_range, double sigma, double epsilon,
+        blitz::Array<double,3> &V3D, const blitz::Array<double,2> &xy_x, const blitz::Array<double,2> &xy_y,
+        const blitz::Array<double,1> &z_range, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double x;
     double y;
     double z;
@@ -3964,12 +3989,12 @@ void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_y_64(
 }
 
 void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_z_64(
-        blitz::Array<double,3> V3D, blitz::Array<double,2> xy_x, blitz::Array<double,2> xy_y,
-        blitz::Array<double,1> z_range, double sigma, double epsilon,
+        blitz::Array<double,3> &V3D, const blitz::Array<double,2> &xy_x, const blitz::Array<double,2> &xy_y,
+        const blitz::Array<double,1> &z_range, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double x;
     double y;
     double z;
@@ -3986,12 +4011,12 @@ void GrapheneLUT3DPotentialGenerate::calculate_gradV3D_z_64(
 }
 
 void GrapheneLUT3DPotentialGenerate::calculate_grad2V3D_64(
-        blitz::Array<double,3> V3D, blitz::Array<double,2> xy_x, blitz::Array<double,2> xy_y,
-        blitz::Array<double,1> z_range, double sigma, double epsilon,
+        blitz::Array<double,3> &V3D, const blitz::Array<double,2> &xy_x, const blitz::Array<double,2> &xy_y,
+        const blitz::Array<double,1> &z_range, double sigma, double epsilon,
         double area_lattice, blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double x;
     double y;
     double z;
@@ -4011,8 +4036,8 @@ std::pair<double, double> GrapheneLUT3DPotentialGenerate::get_z_min_V_min(double
         double sigma, double epsilon, double area_lattice,
         blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
 
     double z_min_limit = 1.0;
     double z_max_limit = 5.0;
@@ -4031,8 +4056,8 @@ std::pair<double, double> GrapheneLUT3DPotentialGenerate::get_z_V_to_find(
         double sigma, double epsilon, double area_lattice,
         blitz::TinyVector<double,2> b_1, blitz::TinyVector<double,2> b_2,
         blitz::TinyVector<double,2> g_m, blitz::TinyVector<double,2> g_n,
-        blitz::Array<int,1> g_i_array, blitz::Array<int,1> g_j_array,
-        blitz::Array<double,1> g_magnitude_array ) {
+        const blitz::Array<int,1> &g_i_array, const blitz::Array<int,1> &g_j_array,
+        const blitz::Array<double,1> &g_magnitude_array ) {
     double V_to_find = 10000.0;
     blitz::TinyVector<double,2> center_of_hexagon(0.0, 0.0);
     blitz::TinyVector<double,2> above_A_site(b_1[0],b_1[1]);
@@ -301,6 +301,10 @@ Setup::Setup() :
     wavevectorTypeName = {"int","float","max_int", "max_float", "file_int", "file_float", "help"};
     wavevectorTypeNames = getList(wavevectorTypeName);
 
+    /* Define the allowed scattering estimator backends */
+    scatteringBackendName = {"auto", "cpu", "gpu"};
+    scatteringBackendNames = getList(scatteringBackendName);
+
     /* Define the allowed action names */
     actionName = {"primitive", "li_broughton", "gsf", "pair_product"};
     actionNames = getList(actionName);
@@ -310,9 +314,13 @@ Setup::Setup() :
     waveFunctionNames = getList(waveFunctionName);
 
     /* Define the allowed random number generator names */
-    randomGeneratorName = {"boost_mt19937","std_mt19937", "pimc_mt19937"};
+    randomGeneratorName = {"boost_mt19937","std_mt19937", "pimc_mt19937", "pimc_philox"};
     randomGeneratorNames = getList(randomGeneratorName);
 
+    /* Define the allowed thread affinity policies */
+    threadAffinityName = {"none", "compact", "scatter", "numa"};
+    threadAffinityNames = getList(threadAffinityName);
+
     /* Get the allowed estimator names */
     estimatorName = estimatorFactory()->getNames();
     vector<string> multiEstimatorName = multiEstimatorFactory()->getNames();
@@ -320,6 +328,15 @@ Setup::Setup() :
             multiEstimatorName.end());
     estimatorNames = getList(estimatorName,'\n');
 
+    /* Define the estimators which may be sampled asynchronously.  These are
+     * expensive and write to their own output file. */
+    asyncEstimatorName = {"local superfluid", "one body density matrix",
+        "pair correlation function", "static structure factor", 
+        "intermediate scattering function", "cylinder one body density matrix",
+        "cylinder pair correlation function", "cylinder static structure factor",
+        "pigs one body density matrix"};
+    asyncEstimatorNames = getList(asyncEstimatorName,'\n');
+
     /* Get the allowed move names */
     moveName = moveFactory()->getNames(); 
     moveNames = getList(moveName);
@@ -347,10 +364,22 @@ void Setup::initParameters() {
     params.add<bool>("dimension","output currently compiled dimension",oClass);
     params.add<int>("output_config,o","number of output configurations",oClass,0);
     params.add<uint32>("process,p","process or cpu number",oClass,0);
+    params.add<int>("replicas","number of independent replicas run concurrently in this process",oClass,1);
+    params.add<int>("ensemble","number of worker processes forked with distinct seeds, whose estimator bins are merged",oClass,1);
+    params.add<bool>("ensemble_raw","keep the output files of each ensemble worker",oClass);
+    params.add<int>("threads","number of threads in the shared thread pool (0 for all hardware threads)",oClass,1);
+    params.add<bool>("numa","report on which numa nodes path, lookup table and shared arrays reside",oClass);
+    params.add<bool>("numa_replicate","replicate shared read-only lookup tables on each numa node",oClass);
+    params.add<string>("thread_affinity",str(format("pinning of the main thread, thread pool workers and (numa) replicas:\n%s") % threadAffinityNames).c_str(),oClass,"none");
+    params.add<string>("tempering_temperatures","space separated ladder of replica temperatures for parallel tempering [kelvin]",oClass);
+    params.add<string>("tempering_chemical_potentials","space separated ladder of replica chemical potentials for parallel tempering [kelvin]",oClass);
+    params.add<int>("tempering_frequency","number of steps between replica exchange attempts",oClass,1);
     params.add<string>("restart,R","restart running simulation with PIMCID",oClass);
     params.add<double>("wall_clock,W","set wall clock limit in hours",oClass);
+    params.add<double>("checkpoint_interval","seconds between state checkpoints, independent of the bin size (0 for none)",oClass,0.0);
     params.add<string>("start_with_state,s", "start simulation with a supplied state file.",oClass,"");
     params.add<bool>("no_save_state","Only save a state file at the end of a simulation",oClass);
+    params.add<bool>("no_sync_state","Do not fsync state files before they replace the previous one",oClass);
     params.add<bool>("estimator_list","Output a list of estimators in xml format.",oClass);
     params.add<bool>("update_list","Output a list of updates in xml format.",oClass);
     params.add<string>("label","a label to append to all estimator files.",oClass,"");
@@ -418,6 +447,7 @@ void Setup::initParameters() {
     oClass = "algorithm";
     params.add<bool>("relax","perform a worm constant relaxation",oClass);
     params.add<bool>("relaxmu", "perform a chemical potential relaxation to target a fixed density",oClass);
+    params.add<int>("relax_chains","number of concurrent trial chains used to relax C0 or mu",oClass,1);
     params.add<int>("number_time_slices,P","number of time slices",oClass);
     params.add<int>("window","set particle number window",oClass);
     params.add<double>("gaussian_window_width", "set gaussian ensemble weight",oClass);
@@ -437,13 +467,20 @@ void Setup::initParameters() {
     oClass = "measurement";
     params.add<uint32>("number_eq_steps,E", "number of equilibration steps",oClass,1);
     params.add<int>("number_bins_stored,S", "number of estimator bins stored",oClass,1);
+    params.add<bool>("blocking", "keep online blocking error bars of the scalar estimators in a summary file",oClass);
+    params.add<double>("target_error", "stop once the blocking error of target_quantity is below this value (implies blocking)",oClass,0.0);
+    params.add<string>("target_quantity", "the estimator:quantity checked against target_error",oClass,"energy:E");
     params.add<uint32>("bin_size", "number of updates per bin",oClass,uint32{100});
     params.add<double>("estimator_radius,w", "maximum radius for cylinder estimators",oClass,2.0); 
     params.add<int>("virial_window,V", "centroid virial energy estimator window",oClass,5);
+    params.add<int>("pair_correlation_bins", "number of bins of the pair correlation function",oClass,NPCFSEP);
+    params.add<double>("pair_correlation_radius", "maximum separation of the pair correlation function (0 for half the periodic diagonal); only radii up to a third of the smallest side avoid comparing all pairs",oClass,0.0);
+    params.add<int>("obdm_separations", "number of separations of the one body density matrix",oClass,NOBDMSEP);
     params.add<int>("number_broken", "number of broken world-lines",oClass,0);
     params.add<double>("spatial_subregion", "define a spatial subregion",oClass);
     params.add<string>("wavevector","input for wavevectors (set --wavevector_type=help for more info)",oClass);
     params.add<string>("wavevector_type",str(format("wavevctor input types:\n%s") % wavevectorTypeNames).c_str(),oClass);
+    params.add<string>("scattering_backend",str(format("backend of the scattering estimators:\n%s") % scatteringBackendNames).c_str(),oClass,"auto");
 
     /* The updates, measurement defaults, and ensemble can depend on PIGS vs PIMC */
     vector<string> estimatorsToMeasure;
@@ -468,6 +505,12 @@ void Setup::initParameters() {
                 % moveNames).c_str(), "algorithm",movesToPerform);
     params.add<vector<string>>("estimator,e", str(format("estimators to be measured:\n%s") 
                 % estimatorNames).c_str(),"measurement",estimatorsToMeasure);
+    params.add<vector<string>>("async_estimator", str(format("estimators to be sampled on worker threads:\n%s") 
+                % asyncEstimatorNames).c_str(),"measurement");
+    params.add<int>("estimator_threads","number of worker threads for asynchronous estimators","measurement",1);
+    params.add<int>("snapshot_buffer","number of configurations buffered for asynchronous estimators","measurement",4);
+    params.add<vector<string>>("estimator_frequency","sampling frequency of an estimator as name=k, measured every k steps","measurement");
+    params.add<double>("estimator_budget","target fraction of the step time spent measuring, met by timing the first bin and raising the frequencies of expensive estimators (0 for fixed)","measurement",0.0);
 
 }
 
@@ -735,9 +778,75 @@ bool Setup::parseOptions() {
         }
     }
 
+    /* Asynchronous estimators must be measured, and be safe to run on a copy
+     * of the path */
+    if (params("async_estimator")) {
+        for (string name : params["async_estimator"].as<vector<string>>()) {
+            if (!isStringInVector(name,asyncEstimatorName)) {
+                cerr << endl << "ERROR: Cannot sample estimator asynchronously: " << name << endl;
+                cerr << "Action: set async_estimator to one of:" << endl
+                    << "\t[" << asyncEstimatorNames << "]" <<  endl;
+                return true;
+            }
+            if (!isStringInVector(name,params["estimator"].as<vector<string>>())) {
+                cerr << endl << "ERROR: Asynchronous estimator is not measured: " << name << endl;
+                cerr << "Action: add " << name << " to the estimator list." << endl;
+                return true;
+            }
+        }
+
+        /* Binning is driven by the first synchronous estimator */
+        bool haveSync = false;
+        for (string name : params["estimator"].as<vector<string>>())
+            if (!isStringInVector(name,params["async_estimator"].as<vector<string>>()))
+                haveSync = true;
+        if (!haveSync) {
+            cerr << endl << "ERROR: All estimators are asynchronous!" << endl;
+            cerr << "Action: measure at least one estimator synchronously." << endl;
+            return true;
+        }
+
+        if (params["number_paths"].as<int>() > 1) {
+            cerr << endl << "ERROR: Asynchronous estimators require a single path!" << endl;
+            cerr << "Action: remove async_estimator or set number_paths = 1." << endl;
+            return true;
+        }
+
+        if ((params["estimator_threads"].as<int>() < 1) || (params["snapshot_buffer"].as<int>() < 1)) {
+            cerr << endl << "ERROR: Need at least one estimator thread and snapshot!" << endl;
+            cerr << "Action: set estimator_threads >= 1 and snapshot_buffer >= 1." << endl;
+            return true;
+        }
+    }
+
+    /* Sampling frequencies are given as name=k for a measured estimator */
+    if (params("estimator_frequency")) {
+        for (string entry : params["estimator_frequency"].as<vector<string>>()) {
+            size_t equals = entry.rfind('=');
+            string name = entry.substr(0,equals);
+            int k = (equals == string::npos) ? 0 : atoi(entry.substr(equals+1).c_str());
+            if (!isStringInVector(name,params["estimator"].as<vector<string>>()) || (k < 1)) {
+                cerr << endl << "ERROR: Invalid estimator frequency: " << entry << endl << endl;
+                cerr << "Action: set estimator_frequency to name=k with k >= 1 for a measured estimator." << endl;
+                return true;
+            }
+            estimatorFrequency[name] = k;
+        }
+    }
+
+    if ((params["estimator_budget"].as<double>() < 0.0) || (params["estimator_budget"].as<double>() >= 1.0)) {
+        cerr << endl << "ERROR: Invalid estimator budget!" << endl << endl;
+        cerr << "Action: set 0 <= estimator_budget < 1." << endl;
+        return true;
+    }
+
     /* If we are measuring some type of scattering function, we need to supply the correct wavevector options. */
     if ( isStringInVector("intermediate scattering function",params["estimator"].as<vector<string>>()) || 
-         isStringInVector("static structure factor",params["estimator"].as<vector<string>>()) ) {
+         isStringInVector("static structure factor",params["estimator"].as<vector<string>>()) ||
+         isStringInVector(IntermediateScatteringFunctionEstimatorGpu::name,params["estimator"].as<vector<string>>()) ||
+         isStringInVector(ElasticScatteringEstimatorGpu::name,params["estimator"].as<vector<string>>()) ||
+         isStringInVector(StaticStructureFactorGPUEstimator::name,params["estimator"].as<vector<string>>()) ||
+         isStringInVector(CylinderStaticStructureFactorGPUEstimator::name,params["estimator"].as<vector<string>>()) ) {
 
         if (!(params("wavevector") && params("wavevector_type"))) {
             cerr << endl << "ERROR: you didn't include wavevectors that are needed for your scattering-type estimator: " << endl << endl;
@@ -832,6 +941,198 @@ bool Setup::parseOptions() {
         }
     }
 
+    if (params["checkpoint_interval"].as<double>() < 0.0) {
+        cerr << endl << "ERROR: Negative checkpoint interval!" << endl << endl;
+        cerr << "Action: set checkpoint_interval >= 0." << endl;
+        return true;
+    }
+
+    if ((params["pair_correlation_bins"].as<int>() < 1) || (params["pair_correlation_radius"].as<double>() < 0.0)) {
+        cerr << endl << "ERROR: Invalid pair correlation histogram!" << endl << endl;
+        cerr << "Action: set pair_correlation_bins >= 1 and pair_correlation_radius >= 0." << endl;
+        return true;
+    }
+
+    if (params["target_error"].as<double>() < 0.0) {
+        cerr << endl << "ERROR: Negative target error!" << endl << endl;
+        cerr << "Action: set target_error >= 0." << endl;
+        return true;
+    }
+
+    if (params["target_error"].as<double>() > 0.0) {
+        string target = params["target_quantity"].as<string>();
+        size_t colon = target.find(':');
+        if ((colon == string::npos) || 
+                !isStringInVector(target.substr(0,colon),params["estimator"].as<vector<string>>())) {
+            cerr << endl << "ERROR: The target quantity " << target << " is not measured!" << endl << endl;
+            cerr << "Action: set target_quantity to estimator:quantity for a measured scalar estimator." << endl;
+            return true;
+        }
+    }
+
+    if (params["obdm_separations"].as<int>() < 1) {
+        cerr << endl << "ERROR: Invalid number of one body density matrix separations!" << endl << endl;
+        cerr << "Action: set obdm_separations >= 1." << endl;
+        return true;
+    }
+
+    /* An ensemble of forked workers, each a single simulation */
+    if (params["ensemble"].as<int>() < 1) {
+        cerr << endl << "ERROR: Need at least one ensemble worker!" << endl << endl;
+        cerr << "Action: set ensemble >= 1." << endl;
+        return true;
+    }
+
+    if ((params["ensemble"].as<int>() > 1) && 
+            ((params["replicas"].as<int>() > 1) || params("tempering_temperatures") 
+             || params("tempering_chemical_potentials") || params("restart"))) {
+        cerr << endl << "ERROR: Ensemble workers must be fresh single simulations!" << endl << endl;
+        cerr << "Action: remove replicas, tempering and restart options, or remove ensemble." << endl;
+        return true;
+    }
+
+    /* The shared thread pool */
+    if (params["threads"].as<int>() < 0) {
+        cerr << endl << "ERROR: Invalid number of threads!" << endl << endl;
+        cerr << "Action: set threads >= 0." << endl;
+        return true;
+    }
+
+    if (!isStringInVector(params["thread_affinity"].as<string>(),threadAffinityName)) {
+        cerr << endl << "ERROR: Invalid thread affinity!" << endl << endl;
+        cerr << "Action: choose a valid thread affinity:" << endl
+            << "\t[" << threadAffinityNames << "]" <<  endl;
+        return true;
+    }
+
+    if (!isStringInVector(params["scattering_backend"].as<string>(),scatteringBackendName)) {
+        cerr << endl << "ERROR: Invalid scattering backend!" << endl << endl;
+        cerr << "Action: choose a valid scattering backend:" << endl
+            << "\t[" << scatteringBackendNames << "]" <<  endl;
+        return true;
+    }
+
+#ifndef USE_GPU
+    if (params["scattering_backend"].as<string>() == "gpu") {
+        cerr << endl << "ERROR: This build has no GPU support!" << endl << endl;
+        cerr << "Action: set scattering_backend to auto or cpu, or rebuild with a GPU backend." << endl;
+        return true;
+    }
+#endif
+
+    /* Replicas are independent simulations sharing a single process */
+    if (params["replicas"].as<int>() < 1) {
+        cerr << endl << "ERROR: Need at least one replica!" << endl << endl;
+        cerr << "Action: set replicas >= 1." << endl;
+        return true;
+    }
+
+    /* Parallel tempering runs one replica for each rung of the ladder */
+    if (params("tempering_temperatures") || params("tempering_chemical_potentials")) {
+
+        if (PIGS) {
+            cerr << endl << "ERROR: Parallel tempering requires a finite temperature!" << endl << endl;
+            cerr << "Action: remove tempering options." << endl;
+            return true;
+        }
+
+        /* Read the ladders */
+        temperingT.clear();
+        temperingMu.clear();
+        double val;
+        if (params("tempering_temperatures")) {
+            istringstream ladder(params["tempering_temperatures"].as<string>());
+            while (ladder >> val)
+                temperingT.push_back(val);
+        }
+        if (params("tempering_chemical_potentials")) {
+            istringstream ladder(params["tempering_chemical_potentials"].as<string>());
+            while (ladder >> val)
+                temperingMu.push_back(val);
+        }
+
+        if (!temperingT.empty() && !temperingMu.empty() && 
+                (temperingT.size() != temperingMu.size())) {
+            cerr << endl << "ERROR: Tempering ladders have different lengths!" << endl << endl;
+            cerr << "Action: supply the same number of temperatures and chemical potentials." << endl;
+            return true;
+        }
+
+        /* A missing ladder is filled with the base value */
+        int numRungs = std::max(temperingT.size(),temperingMu.size());
+        if (temperingT.empty())
+            temperingT.assign(numRungs,params["temperature"].as<double>());
+        if (temperingMu.empty())
+            temperingMu.assign(numRungs,params["chemical_potential"].as<double>());
+
+        if (numRungs < 2) {
+            cerr << endl << "ERROR: Need at least two rungs on the tempering ladder!" << endl << endl;
+            cerr << "Action: supply a space separated list of values." << endl;
+            return true;
+        }
+
+        if (*std::min_element(temperingT.begin(),temperingT.end()) <= 0.0) {
+            cerr << endl << "ERROR: Tempering temperatures must be positive!" << endl << endl;
+            cerr << "Action: change tempering_temperatures." << endl;
+            return true;
+        }
+
+        /* Swaps require the tau dependence of the action, which is only
+         * known for local actions.  The action itself is checked again once
+         * it is built. */
+        if (params["action"].as<string>() == "pair_product") {
+            cerr << endl << "ERROR: Parallel tempering requires an action of the form "
+                 << "tau*U + tau^3*dU!" << endl << endl;
+            cerr << "Action: change the action or remove tempering options." << endl;
+            return true;
+        }
+
+        if (params("relaxmu") && params("tempering_chemical_potentials")) {
+            cerr << endl << "ERROR: Cannot relax the chemical potential of a tempering ladder!" << endl << endl;
+            cerr << "Action: remove relaxmu or tempering_chemical_potentials." << endl;
+            return true;
+        }
+
+        if (params["number_paths"].as<int>() > 1) {
+            cerr << endl << "ERROR: Parallel tempering requires a single path!" << endl << endl;
+            cerr << "Action: set number_paths = 1." << endl;
+            return true;
+        }
+
+        if (params["tempering_frequency"].as<int>() < 1) {
+            cerr << endl << "ERROR: Invalid tempering frequency!" << endl << endl;
+            cerr << "Action: set tempering_frequency >= 1." << endl;
+            return true;
+        }
+
+        if ((params["replicas"].as<int>() != 1) && (params["replicas"].as<int>() != numRungs)) {
+            cerr << endl << "ERROR: Number of replicas does not match the tempering ladder!" << endl << endl;
+            cerr << "Action: remove replicas or set it to " << numRungs << "." << endl;
+            return true;
+        }
+        params.set<int>("replicas",numRungs);
+    }
+
+    /* Trial chains are run on copies of a single path */
+    if (params["relax_chains"].as<int>() < 1) {
+        cerr << endl << "ERROR: Need at least one relaxation chain!" << endl << endl;
+        cerr << "Action: set relax_chains >= 1." << endl;
+        return true;
+    }
+
+    if ((params["relax_chains"].as<int>() > 1) && (params["number_paths"].as<int>() > 1)) {
+        cerr << endl << "ERROR: Concurrent relaxation chains require a single path!" << endl << endl;
+        cerr << "Action: remove relax_chains or set number_paths = 1." << endl;
+        return true;
+    }
+
+    /* Each replica has its own PIMCID, and must be restarted on its own */
+    if ((params["replicas"].as<int>() > 1) && params("restart")) {
+        cerr << endl << "ERROR: Cannot restart multiple replicas at once!" << endl << endl;
+        cerr << "Action: restart each replica using the command in its log file." << endl;
+        return true;
+    }
+
     if (params("validate")) {
         cerr << "SUCCESS: All command line and/or xml options have been verified." << endl;
         cerr << "Action: remove --validate flag to proceed with simulation." << endl;
@@ -847,10 +1148,38 @@ bool Setup::parseOptions() {
  *
  * We add the process number to a fixed initial random seed.
  * @param startSeed The fixed initial seed
+ * @param replica The replica number within this process
  * @return A seed shifted by the process number
 ******************************************************************************/
-uint32 Setup::seed (const uint32 startSeed) {
-    return startSeed + params["process"].as<uint32>();
+uint32 Setup::seed (const uint32 startSeed, const int replica) {
+    return startSeed + process(replica);
+}
+
+/**************************************************************************//**
+ * Return a unique process number for a replica.
+ *
+ * The replicas run by each process are numbered consecutively, such that
+ * with a single replica this is simply the process number.
+ * @param replica The replica number within this process
+ * @return The global replica number
+******************************************************************************/
+uint32 Setup::process (const int replica) {
+    return params["replicas"].as<int>()*params["process"].as<uint32>() + replica;
+}
+
+/**************************************************************************//**
+ * Set the temperature and chemical potential of a tempering replica.
+ *
+ * Must be called from the thread of the replica after its constants have
+ * been bound.  The number of time slices is shared by the entire ladder, so
+ * the imaginary time step changes with temperature.
+ * @param replica The replica number within this process
+******************************************************************************/
+void Setup::temperingConstants (const int replica) {
+    if (temperingT.empty())
+        return;
+    constants()->setT(temperingT[replica]);
+    constants()->setmu(temperingMu[replica]);
 }
 
 /**************************************************************************//**
@@ -1097,7 +1426,7 @@ void Setup::setConstants() {
 ******************************************************************************/
 void Setup::communicator() {
         
-    communicate()->init(params["imaginary_time_step"].as<double>(),
+    communicate()->init(constants()->tau(),
             (params["output_config"].as<int>() > 0),params["start_with_state"].as<string>(),
             params["fixed"].as<string>());
 }
@@ -1304,6 +1633,15 @@ ActionBase * Setup::action(const Path &path, LookupTable &lookup,
                 constants()->actionType(),constants()->endFactor(),period);
     }
 
+    /* Replica swaps evaluate the action at the temperature of another rung */
+    if ((params("tempering_temperatures") || params("tempering_chemical_potentials")) 
+            && !actionPtr->hasPotentialActionComponents()) {
+        cerr << endl << "ERROR: Parallel tempering requires an action of the form "
+             << "tau*U + tau^3*dU!" << endl << endl;
+        cerr << "Action: change the action or remove tempering options." << endl;
+        exit(EXIT_FAILURE);
+    }
+
     return actionPtr;
 }
 
@@ -1390,14 +1728,24 @@ boost::ptr_vector<EstimatorBase> * Setup::estimators(Path &path,
     /* Create the list of estimator pointers */
     boost::ptr_vector<EstimatorBase>* estimatorPtr = new boost::ptr_vector<EstimatorBase>();
 
+    /* Asynchronous estimators are built separately */
+    vector<string> asyncEstimators;
+    if (params("async_estimator"))
+        asyncEstimators = params["async_estimator"].as<vector<string>>();
+
     /* Instatiate the single path estimators */
     for (auto& name : params["estimator"].as<vector<string>>()) {
 
+        if (isStringInVector(name,asyncEstimators))
+            continue;
+
         if (name.find("multi") == string::npos)
             estimatorPtr->push_back(estimatorFactory()->Create(name,path,
                         actionPtr,random,params["estimator_radius"].as<double>()));
     }
 
+    setFrequencies(*estimatorPtr,true);
+
     /* We determine where a line break is needed for all estimators writing to
      * a common estimator file */
     for (const auto & common : {"estimator","cyl_estimator"}) {
@@ -1410,6 +1758,79 @@ boost::ptr_vector<EstimatorBase> * Setup::estimators(Path &path,
     return estimatorPtr;
 }
 
+/*************************************************************************//**
+* The number of worker threads used for asynchronous estimators.
+******************************************************************************/
+int Setup::numEstimatorWorkers() {
+    if (!params("async_estimator"))
+        return 0;
+    return std::min(params["estimator_threads"].as<int>(),
+            int(params["async_estimator"].as<vector<string>>().size()));
+}
+
+/*************************************************************************//**
+* Create the list of asynchronous estimators sampled by a worker thread
+*
+* Estimators are dealt out to the workers in turn.
+*
+* @param path A reference to the worker's copy of the path
+* @param actionPtr The action of the worker's copy of the path
+* @param random The random number generator
+* @param worker The worker number
+* @return a list of single path estimators
+******************************************************************************/
+boost::ptr_vector<EstimatorBase> * Setup::asyncEstimators(Path &path, 
+        ActionBase *actionPtr, MTRand &random, const int worker) {
+
+    boost::ptr_vector<EstimatorBase>* estimatorPtr = new boost::ptr_vector<EstimatorBase>();
+
+    int n = 0;
+    for (auto& name : params["async_estimator"].as<vector<string>>()) {
+        if ((n % numEstimatorWorkers()) == worker)
+            estimatorPtr->push_back(estimatorFactory()->Create(name,path,
+                        actionPtr,random,params["estimator_radius"].as<double>()));
+        n++;
+    }
+    setFrequencies(*estimatorPtr);
+
+    return estimatorPtr;
+}
+
+/*************************************************************************//**
+* Apply the requested sampling frequencies to a list of estimators.
+*
+* Estimators writing to a common file must output their bins together, so
+* they are all given the largest frequency of any of them.  When the first
+* estimator of the list counts the measurements of a bin, the estimators
+* sharing its file are left alone, as raising their frequency would stretch
+* every bin.
+*
+* @param estimatorList The estimators
+* @param binning Does the first estimator drive the binning?
+******************************************************************************/
+void Setup::setFrequencies(boost::ptr_vector<EstimatorBase> &estimatorList, 
+        const bool binning) {
+
+    string binLabel;
+    if (binning && !estimatorList.empty())
+        binLabel = estimatorList.front().getLabel();
+
+    map<string,int> labelFrequency;
+    for (auto &est : estimatorList) {
+        if (estimatorFrequency.count(est.getName())) {
+            if (est.getLabel() == binLabel)
+                cerr << "WARNING: Ignoring the frequency of " << est.getName() 
+                    << ", which shares the file of the estimator that drives binning." << endl;
+            else
+                est.setFrequency(estimatorFrequency[est.getName()]);
+        }
+        labelFrequency[est.getLabel()] = std::max(labelFrequency[est.getLabel()],est.getFrequency());
+    }
+
+    for (auto &est : estimatorList)
+        est.setFrequency(labelFrequency[est.getLabel()]);
+}
+
 /*************************************************************************//**
 * Create a list of double path estimators to be measured
 *
@@ -1432,6 +1853,7 @@ boost::ptr_vector<EstimatorBase> * Setup::estimators(
                         pathPtrVec[1],&actionPtrVec[0],&actionPtrVec[1],random,
                         params["estimator_radius"].as<double>()));
     }
+    setFrequencies(*multiEstimatorPtr);
     
     return multiEstimatorPtr;
 }
@@ -1552,6 +1974,7 @@ void Setup::outputOptions(int argc, char *argv[], const uint32 _seed,
     /* Construct the command that would be required to restart the simulation */
     bool outputC0 = false;
     bool outputmu = false;
+    bool outputT = false;
     bool outputD = false;
     bool outputd = false;
     bool outputEstimator = false;
@@ -1572,6 +1995,17 @@ void Setup::outputOptions(int argc, char *argv[], const uint32 _seed,
             communicate()->file("log")->stream() << format("-u %21.15e ") % constants()->mu();
             outputmu = true;
         }
+        else if ((arg == "--replicas") || (arg == "--tempering_temperatures") ||
+                (arg == "--tempering_chemical_potentials") || (arg == "--tempering_frequency")) {
+            /* do nothing, each replica is restarted on its own */
+        }
+        else if ((arg == "-T") || (arg == "--temperature")) {
+            communicate()->file("log")->stream() << format("-T %21.15e ") % constants()->T();
+            outputT = true;
+        }
+        else if ((arg == "-t") || (arg == "--imaginary_time_step")) {
+            communicate()->file("log")->stream() << format("-t %21.15e ") % constants()->tau();
+        }
         else if ((arg == "-p") || (arg == "--process")) {
             communicate()->file("log")->stream() << format("-p %03d ") % params["process"].as<uint32>();
         }
@@ -1604,6 +2038,10 @@ void Setup::outputOptions(int argc, char *argv[], const uint32 _seed,
     if (!outputmu)
         communicate()->file("log")->stream() << format("-u %21.15e ") % constants()->mu();
 
+    /* A tempering replica may not be at the temperature we specified */
+    if (!outputT && !temperingT.empty())
+        communicate()->file("log")->stream() << format("-T %21.15e ") % constants()->T();
+
     /* If we haven't specified the center of mass Delta, output it now */
     if (!outputD)
         communicate()->file("log")->stream() << format("-D %21.15e ") % constants()->comDelta();
@@ -1736,7 +2174,7 @@ void Setup::outputOptions(int argc, char *argv[], const uint32 _seed,
         }
     }
     communicate()->file("log")->stream() << 
-        format("%-24s\t:\t%7.5f\n") % "Temperature" % params["temperature"].as<double>();
+        format("%-24s\t:\t%7.5f\n") % "Temperature" % constants()->T();
     communicate()->file("log")->stream() << 
         format("%-24s\t:\t%7.5f\n") % "Chemical Potential" % constants()->mu();
     communicate()->file("log")->stream() << 
@@ -0,0 +1,356 @@
+/**
+ * @file threadpool.cpp
+ *
+ * @brief ThreadPool class implementation.
+ */
+
+#include "threadpool.h"
+#include "constants.h"
+#include "communicator.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// THREAD POOL CLASS ---------------------------------------------------------
+// ---------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+
+thread_local int ThreadPool::workerIndex_ = -1;
+
+/**************************************************************************//**
+ *  Constructor.
+ *
+ *  The pool starts without any workers, in which case all tasks are run on
+ *  the thread that submits them.
+******************************************************************************/
+ThreadPool::ThreadPool() :
+    numWorkers(0),
+    nextQueue(0),
+    numQueued(0),
+    stopping(false)
+{
+}
+
+/**************************************************************************//**
+ *  Destructor.
+ *
+ *  Finish all queued tasks and stop the workers.
+******************************************************************************/
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(activityMutex);
+        stopping = true;
+    }
+    activity.notify_all();
+    for (auto &thread : worker)
+        thread.join();
+}
+
+/**************************************************************************//**
+ *  This public method gets an instance of the ThreadPool object, only one
+ *  can ever exist at a time.
+******************************************************************************/
+ThreadPool* ThreadPool::getInstance ()
+{
+    static ThreadPool inst;
+    return &inst;
+}
+
+/**************************************************************************//**
+ *  Start the workers.
+ *
+ *  The calling thread is pinned along with the workers.  Threads it starts
+ *  later inherit its cpus, and should call unpin() (or pinReplica()) if they
+ *  are not part of the pool.
+ *
+ *  @param numThreads The total number of threads including the caller, if 0
+ *  we use all hardware threads
+ *  @param affinity How workers are pinned: none, compact, scatter or numa
+******************************************************************************/
+void ThreadPool::init(const int numThreads, const string &affinity) {
+
+    PIMC_ASSERT(worker.empty());
+
+    int total = numThreads;
+    if (total < 1)
+        total = std::max(1,int(std::thread::hardware_concurrency()));
+
+    numWorkers = total - 1;
+
+    /* Record the cpus available to the process before pinning anything */
+#ifdef __linux__
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &available))
+                cpu.push_back(c);
+    }
+
+    /* Read the available cpus of each node, e.g. 0-7,16-23 */
+    if (affinity == "numa") {
+        for (int node = 0; ; node++) {
+            ifstream cpuList(str(format("/sys/devices/system/node/node%d/cpulist") % node));
+            if (!cpuList)
+                break;
+            vector <int> nCPU;
+            string range;
+            while (getline(cpuList, range, ',')) {
+                if (range.find_first_of("0123456789") == string::npos)
+                    continue;
+                size_t dash = range.find('-');
+                int lo = stoi(range.substr(0,dash));
+                int hi = (dash == string::npos) ? lo : stoi(range.substr(dash+1));
+                for (int c = lo; c <= hi; c++)
+                    if (std::find(cpu.begin(),cpu.end(),c) != cpu.end())
+                        nCPU.push_back(c);
+            }
+            if (!nCPU.empty())
+                nodeCPU.push_back(nCPU);
+        }
+    }
+#endif
+    affinity_ = affinity;
+    pin(-1,affinity);
+
+    for (int w = 0; w < numWorkers; w++)
+        queue.push_back(new Queue);
+    for (int w = 0; w < numWorkers; w++)
+        worker.push_back(std::thread(&ThreadPool::work, this, w, affinity));
+}
+
+/**************************************************************************//**
+ *  Submit a task to a group.
+ *
+ *  Without any workers the task is run immediately.
+ *
+ *  @param group The group the task belongs to
+ *  @param fn The task
+******************************************************************************/
+void ThreadPool::run(TaskGroup &group, std::function<void()> fn) {
+
+    Task task = {fn, &group, ConstantParameters::binding(), Communicator::binding()};
+    group.numPending++;
+
+    if (numWorkers == 0) {
+        execute(task);
+        return;
+    }
+
+    /* Workers push onto their own queue, others deal round-robin */
+    int q = workerIndex_;
+    if (q < 0)
+        q = nextQueue++ % numWorkers;
+    {
+        std::lock_guard<std::mutex> lock(queue[q].queueMutex);
+        queue[q].task.push_back(task);
+    }
+    numQueued++;
+
+    { std::lock_guard<std::mutex> lock(activityMutex); }
+    activity.notify_all();
+}
+
+/**************************************************************************//**
+ *  Wait for all tasks of a group.
+ *
+ *  While waiting we execute any queued tasks, only sleeping when there are
+ *  none left.
+ *
+ *  @param group The group to wait for
+******************************************************************************/
+void ThreadPool::wait(TaskGroup &group) {
+
+    while (group.numPending > 0) {
+        if (!tryRun()) {
+            std::unique_lock<std::mutex> lock(activityMutex);
+            activity.wait(lock, [&]{return (group.numPending == 0) || (numQueued > 0);});
+        }
+    }
+}
+
+/**************************************************************************//**
+ *  Take a task and run it.
+ *
+ *  A worker first takes the newest task from its own queue, and otherwise
+ *  steals the oldest task from the next non-empty queue.
+ *
+ *  @return true if a task was run
+******************************************************************************/
+bool ThreadPool::tryRun() {
+
+    if (numQueued == 0)
+        return false;
+
+    int self = workerIndex_;
+    Task task;
+    bool found = false;
+
+    if (self >= 0) {
+        std::lock_guard<std::mutex> lock(queue[self].queueMutex);
+        if (!queue[self].task.empty()) {
+            task = queue[self].task.back();
+            queue[self].task.pop_back();
+            found = true;
+        }
+    }
+
+    int start = (self >= 0) ? self + 1 : 0;
+    for (int n = 0; !found && (n < numWorkers); n++) {
+        int q = (start + n) % numWorkers;
+        std::lock_guard<std::mutex> lock(queue[q].queueMutex);
+        if (!queue[q].task.empty()) {
+            task = queue[q].task.front();
+            queue[q].task.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    numQueued--;
+    execute(task);
+    return true;
+}
+
+/**************************************************************************//**
+ *  Run a task with the constants and communicator it was submitted with,
+ *  restoring those of this thread afterwards.
+ *
+ *  @param task The task
+******************************************************************************/
+void ThreadPool::execute(Task &task) {
+
+    ConstantParameters *constantsPtr = ConstantParameters::binding();
+    Communicator *communicatorPtr = Communicator::binding();
+    ConstantParameters::attach(task.constantsPtr);
+    Communicator::attach(task.communicatorPtr);
+
+    task.fn();
+
+    Communicator::attach(communicatorPtr);
+    ConstantParameters::attach(constantsPtr);
+
+    if (--task.group->numPending == 0) {
+        { std::lock_guard<std::mutex> lock(activityMutex); }
+        activity.notify_all();
+    }
+}
+
+/**************************************************************************//**
+ *  The worker loop.
+ *
+ *  @param w The worker index
+ *  @param affinity The affinity policy
+******************************************************************************/
+void ThreadPool::work(const int w, const string affinity) {
+
+    workerIndex_ = w;
+    pin(w,affinity);
+
+    while (true) {
+        if (tryRun())
+            continue;
+
+        std::unique_lock<std::mutex> lock(activityMutex);
+        activity.wait(lock, [&]{return stopping || (numQueued > 0);});
+        if (stopping && (numQueued == 0))
+            break;
+    }
+}
+
+/**************************************************************************//**
+ *  Pin a worker to a set of cpus.
+ *
+ *  Only the cpus available to the process are used.  The calling thread
+ *  (w = -1) takes the first slot.  Compact places workers on consecutive cpus,
+ *  scatter spreads them evenly over all cpus, and numa deals them
+ *  round-robin between numa nodes, pinning each to all cpus of its node.
+ *  This is only supported on linux, and is otherwise ignored.
+ *
+ *  @param w The worker index
+ *  @param affinity The affinity policy
+******************************************************************************/
+void ThreadPool::pin(const int w, const string &affinity) {
+
+#ifdef __linux__
+    if ((affinity == "none") || cpu.empty())
+        return;
+
+    int slot = w + 1;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+
+    if (affinity == "compact")
+        CPU_SET(cpu[slot % cpu.size()], &mask);
+    else if (affinity == "scatter") {
+        int stride = std::max(1, int(cpu.size())/numThreads());
+        CPU_SET(cpu[(slot*stride) % cpu.size()], &mask);
+    }
+    else if (affinity == "numa") {
+        if (nodeCPU.empty())
+            return;
+
+        for (int c : nodeCPU[slot % nodeCPU.size()])
+            CPU_SET(c, &mask);
+    }
+    else
+        return;
+
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#endif
+}
+
+/**************************************************************************//**
+ *  Allow the calling thread to run on any of the cpus available to the
+ *  process.
+ *
+ *  Used by threads which are started from a pinned thread but are not part
+ *  of the pool (estimator workers, the state writer, unpinned replicas).
+******************************************************************************/
+void ThreadPool::unpin() {
+
+#ifdef __linux__
+    if (cpu.empty())
+        return;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int c : cpu)
+        CPU_SET(c, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#endif
+}
+
+/**************************************************************************//**
+ *  Pin the thread of a replica.
+ *
+ *  With the numa policy replica r runs on all cpus of node r mod the number
+ *  of nodes, so that the path and lookup table it builds are first touched
+ *  there.  Otherwise the replica may run on any cpu.  This must be called
+ *  before the replica allocates its arrays.
+ *
+ *  @param r The replica index
+******************************************************************************/
+void ThreadPool::pinReplica(const int r) {
+
+#ifdef __linux__
+    if ((affinity_ != "numa") || nodeCPU.empty()) {
+        unpin();
+        return;
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int c : nodeCPU[r % nodeCPU.size()])
+        CPU_SET(c, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#else
+    unpin();
+#endif
+}